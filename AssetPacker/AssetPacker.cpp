@@ -0,0 +1,234 @@
+// builds the asset pack the game maps at startup (see Engine/AssetPack.h for the layout)
+// usage: AssetPacker <manifest> <output pack>
+// manifest lines are "<kind> <name> <file> [originX originY]", files relative to the manifest,
+// kinds are wave (stored as is), sprite (24/32-bit uncompressed bmp) and raw, # starts a comment
+#include "AssetPack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Item
+	{
+		std::string name;
+		AssetPack::Format format;
+		std::vector<unsigned char> data;
+	};
+
+	std::vector<unsigned char> ReadFile( const std::string& fileName )
+	{
+		std::ifstream file( fileName,std::ios::binary );
+		if( !file )
+		{
+			throw std::runtime_error( "can't open " + fileName );
+		}
+		return std::vector<unsigned char>( std::istreambuf_iterator<char>( file ),std::istreambuf_iterator<char>() );
+	}
+
+	uint32_t Read32( const std::vector<unsigned char>& v,size_t i )
+	{
+		return uint32_t( v[i] ) | uint32_t( v[i + 1] ) << 8 | uint32_t( v[i + 2] ) << 16 | uint32_t( v[i + 3] ) << 24;
+	}
+
+	uint16_t Read16( const std::vector<unsigned char>& v,size_t i )
+	{
+		return uint16_t( v[i] | v[i + 1] << 8 );
+	}
+
+	std::vector<unsigned char> LoadWave( const std::string& fileName )
+	{
+		std::vector<unsigned char> data = ReadFile( fileName );
+		if( data.size() < 12u || memcmp( &data[0],"RIFF",4 ) != 0 || memcmp( &data[8],"WAVE",4 ) != 0 )
+		{
+			throw std::runtime_error( fileName + " is not a wave file" );
+		}
+		return data;
+	}
+
+	// sprite payload: header then 0x00RRGGBB pixels, top row first
+	std::vector<unsigned char> LoadSprite( const std::string& fileName,int originX,int originY )
+	{
+		const std::vector<unsigned char> bmp = ReadFile( fileName );
+		if( bmp.size() < 54u || bmp[0] != 'B' || bmp[1] != 'M' )
+		{
+			throw std::runtime_error( fileName + " is not a bmp file" );
+		}
+		const uint32_t pixelOffset = Read32( bmp,10u );
+		const int32_t width = int32_t( Read32( bmp,18u ) );
+		const int32_t height = int32_t( Read32( bmp,22u ) );
+		const uint16_t bitCount = Read16( bmp,28u );
+		const uint32_t compression = Read32( bmp,30u );
+		// BI_RGB, or BI_BITFIELDS with the usual masks for 32-bit
+		if( (bitCount != 24u && bitCount != 32u) || (compression != 0u && compression != 3u) ||
+			width <= 0 || height == 0 )
+		{
+			throw std::runtime_error( fileName + ": only uncompressed 24/32-bit bmps are supported" );
+		}
+		// positive height means the rows are stored bottom up
+		const bool bottomUp = height > 0;
+		const uint32_t nRows = uint32_t( bottomUp ? height : -height );
+		const size_t bytesPerPixel = bitCount / 8u;
+		const size_t pitch = (size_t( width ) * bytesPerPixel + 3u) & ~size_t( 3u );
+		if( pixelOffset + pitch * nRows > bmp.size() )
+		{
+			throw std::runtime_error( fileName + " is truncated" );
+		}
+
+		const AssetPack::SpriteHeader header = { uint32_t( width ),nRows,originX,originY };
+		std::vector<unsigned char> data( sizeof( header ) + size_t( width ) * nRows * sizeof( uint32_t ) );
+		memcpy( data.data(),&header,sizeof( header ) );
+		unsigned char* pOut = &data[sizeof( header )];
+		for( uint32_t y = 0u; y < nRows; y++ )
+		{
+			const size_t row = bottomUp ? nRows - 1u - y : y;
+			const unsigned char* pIn = &bmp[pixelOffset + row * pitch];
+			for( int32_t x = 0; x < width; x++,pIn += bytesPerPixel,pOut += 4 )
+			{
+				// bmp is b,g,r(,x) which is a little endian 0x00RRGGBB already
+				pOut[0] = pIn[0];
+				pOut[1] = pIn[1];
+				pOut[2] = pIn[2];
+				pOut[3] = 0u;
+			}
+		}
+		return data;
+	}
+
+	std::vector<Item> ReadManifest( const std::string& manifestName )
+	{
+		std::ifstream manifest( manifestName );
+		if( !manifest )
+		{
+			throw std::runtime_error( "can't open manifest " + manifestName );
+		}
+		const size_t slash = manifestName.find_last_of( "/\\" );
+		const std::string dir = slash == std::string::npos ? "" : manifestName.substr( 0u,slash + 1u );
+
+		std::vector<Item> items;
+		std::string line;
+		for( int lineNumber = 1; std::getline( manifest,line ); lineNumber++ )
+		{
+			line = line.substr( 0u,line.find( '#' ) );
+			std::istringstream fields( line );
+			std::string kind;
+			std::string name;
+			std::string file;
+			if( !(fields >> kind) )
+			{
+				continue;
+			}
+			if( !(fields >> name >> file) )
+			{
+				throw std::runtime_error( manifestName + "(" + std::to_string( lineNumber ) + "): expected <kind> <name> <file>" );
+			}
+			Item item;
+			item.name = name;
+			if( kind == "wave" )
+			{
+				item.format = AssetPack::Format::Wave;
+				item.data = LoadWave( dir + file );
+			}
+			else if( kind == "sprite" )
+			{
+				int originX = 0;
+				int originY = 0;
+				fields >> originX >> originY;
+				item.format = AssetPack::Format::Sprite;
+				item.data = LoadSprite( dir + file,originX,originY );
+			}
+			else if( kind == "raw" )
+			{
+				item.format = AssetPack::Format::Raw;
+				item.data = ReadFile( dir + file );
+			}
+			else
+			{
+				throw std::runtime_error( manifestName + "(" + std::to_string( lineNumber ) + "): unknown kind " + kind );
+			}
+			items.push_back( std::move( item ) );
+		}
+		return items;
+	}
+
+	void WritePack( const std::vector<Item>& items,const std::string& packName )
+	{
+		// at most half full, so probe runs stay short
+		uint32_t nSlots = 1u;
+		while( nSlots < items.size() * 2u )
+		{
+			nSlots *= 2u;
+		}
+		std::vector<AssetPack::Entry> index( nSlots );
+		uint64_t offset = sizeof( AssetPack::Header ) + nSlots * sizeof( AssetPack::Entry );
+		std::vector<uint64_t> offsets;
+		for( const Item& item : items )
+		{
+			const uint64_t hash = AssetPack::HashName( item.name );
+			uint32_t i = uint32_t( hash ) & (nSlots - 1u);
+			for( ; index[i].nameHash != 0u; i = (i + 1u) & (nSlots - 1u) )
+			{
+				if( index[i].nameHash == hash )
+				{
+					// only hashes are stored, so two names with one hash can't both be found
+					throw std::runtime_error( "name hash collision (or duplicate name): " + item.name );
+				}
+			}
+			offset = (offset + AssetPack::alignment - 1u) / AssetPack::alignment * AssetPack::alignment;
+			index[i].nameHash = hash;
+			index[i].offset = offset;
+			index[i].size = item.data.size();
+			index[i].format = item.format;
+			offsets.push_back( offset );
+			offset += item.data.size();
+		}
+
+		std::ofstream pack( packName,std::ios::binary );
+		if( !pack )
+		{
+			throw std::runtime_error( "can't create " + packName );
+		}
+		AssetPack::Header header;
+		memcpy( header.magic,AssetPack::magic,sizeof( header.magic ) );
+		header.version = AssetPack::version;
+		header.nSlots = nSlots;
+		header.nEntries = uint32_t( items.size() );
+		pack.write( reinterpret_cast<const char*>( &header ),sizeof( header ) );
+		pack.write( reinterpret_cast<const char*>( index.data() ),index.size() * sizeof( AssetPack::Entry ) );
+		for( size_t i = 0u; i < items.size(); i++ )
+		{
+			const std::vector<char> padding( size_t( offsets[i] - uint64_t( pack.tellp() ) ),'\0' );
+			pack.write( padding.data(),padding.size() );
+			pack.write( reinterpret_cast<const char*>( items[i].data.data() ),items[i].data.size() );
+		}
+		if( !pack )
+		{
+			throw std::runtime_error( "error writing " + packName );
+		}
+		printf( "%s: %u assets, %llu bytes\n",packName.c_str(),unsigned( items.size() ),(unsigned long long)offset );
+	}
+}
+
+int main( int argc,char** argv )
+{
+	if( argc != 3 )
+	{
+		fprintf( stderr,"usage: AssetPacker <manifest> <output pack>\n" );
+		return 2;
+	}
+	try
+	{
+		WritePack( ReadManifest( argv[1] ),argv[2] );
+	}
+	catch( const std::exception& e )
+	{
+		fprintf( stderr,"AssetPacker: %s\n",e.what() );
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,356 @@
+// the sound path without audio hardware: the sound system runs on the Null device, which paces
+// the mixer thread like a real one would but throws the mix away
+// loading covers both bundled wave files (from the working directory or the Engine folder)
+#include "Benchmark.h"
+#include "Sound.h"
+#include "RiffReader.h"
+#include "SampleConverter.h"
+#include "SoundMixer.h"
+#include "WideFile.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// what the sound system mixes at a time
+	constexpr size_t nMixBlockFrames = 512u;
+	constexpr int nPlaysPerThread = 16;
+
+	struct WaveFile
+	{
+		std::string name;
+		std::wstring path;
+		// the whole file
+		std::vector<unsigned char> image;
+		// where the samples sit in the image (16-bit stereo 44.1kHz like the mixer wants)
+		size_t dataOffset;
+		size_t dataSize;
+	};
+
+	bool LoadWaveFile( const std::string& name,WaveFile& wave )
+	{
+		const std::wstring wideName( name.begin(),name.end() );
+		for( const std::wstring& path : { wideName,L"..\\Engine\\" + wideName } )
+		{
+			std::ifstream file;
+			OpenWideFile( file,path,std::ios::binary );
+			if( !file )
+			{
+				continue;
+			}
+			wave.name = name;
+			wave.path = path;
+			wave.image.assign( std::istreambuf_iterator<char>( file ),std::istreambuf_iterator<char>() );
+			MemoryStreamBuf buf( wave.image.data(),wave.image.size() );
+			std::istream stream( &buf );
+			RiffReader riff( stream,"WAVE" );
+			RiffReader::Chunk chunk;
+			while( riff.Next( chunk ) )
+			{
+				if( chunk.Is( "data" ) )
+				{
+					wave.dataOffset = size_t( chunk.offset );
+					wave.dataSize = chunk.size;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// how the channel pool moved between two snapshots
+	SoundSystem::ChannelStats operator-( const SoundSystem::ChannelStats& a,const SoundSystem::ChannelStats& b )
+	{
+		return { a.nStarted - b.nStarted,a.nStolen - b.nStolen,a.nDropped - b.nDropped,
+			a.nAcquireRetries - b.nAcquireRetries,a.nReleaseRetries - b.nReleaseRetries };
+	}
+
+	void SetChannelCounters( BenchState& state,const SoundSystem::ChannelStats& stats,double nIterations )
+	{
+		state.counters["stolen"] = double( stats.nStolen ) / nIterations;
+		state.counters["dropped"] = double( stats.nDropped ) / nIterations;
+		state.counters["acquire_retries"] = double( stats.nAcquireRetries ) / nIterations;
+		state.counters["release_retries"] = double( stats.nReleaseRetries ) / nIterations;
+	}
+
+	void AddLoad( BenchRunner& runner,const std::shared_ptr<const WaveFile>& pWave )
+	{
+		runner.Add( "Audio/Parse/" + pWave->name,[pWave]( BenchState& state )
+		{
+			while( state.KeepRunning() )
+			{
+				MemoryStreamBuf buf( pWave->image.data(),pWave->image.size() );
+				std::istream stream( &buf );
+				RiffReader riff( stream,"WAVE" );
+				RiffReader::Chunk chunk;
+				size_t nChunks = 0u;
+				while( riff.Next( chunk ) )
+				{
+					nChunks++;
+				}
+				DoNotOptimize( nChunks );
+			}
+		} );
+		// read, parse and copy out of the file (what the game does without a pack)
+		runner.Add( "Audio/Load/" + pWave->name + "/File",[pWave]( BenchState& state )
+		{
+			while( state.KeepRunning() )
+			{
+				Sound sound( pWave->path );
+				DoNotOptimize( sound );
+			}
+			state.SetBytesPerIteration( double( pWave->image.size() ) );
+		} );
+		// out of an image in memory, the samples are played in place
+		runner.Add( "Audio/Load/" + pWave->name + "/Image",[pWave]( BenchState& state )
+		{
+			while( state.KeepRunning() )
+			{
+				Sound sound( pWave->image.data(),pWave->image.size(),L"bench" );
+				DoNotOptimize( sound );
+			}
+			state.SetBytesPerIteration( double( pWave->image.size() ) );
+		} );
+		// header only, the samples are read while playing
+		runner.Add( "Audio/Load/" + pWave->name + "/Streaming",[pWave]( BenchState& state )
+		{
+			while( state.KeepRunning() )
+			{
+				Sound sound( pWave->path,Sound::LoopType::NotLooping,Sound::Storage::Streaming );
+				DoNotOptimize( sound );
+			}
+		} );
+		// what loading costs when the file isn't in the mixer format yet
+		const SampleConverter::Format formats[] =
+		{
+			{ SampleConverter::Encoding::Int16,2u,44100u },
+			{ SampleConverter::Encoding::Int16,2u,48000u }
+		};
+		for( const SampleConverter::Format& format : formats )
+		{
+			runner.Add( "Audio/Convert/" + pWave->name + "/" + std::to_string( format.sampleRate ),[pWave,format]( BenchState& state )
+			{
+				while( state.KeepRunning() )
+				{
+					size_t nBytes;
+					const auto pConverted = SampleConverter::Convert( &pWave->image[pWave->dataOffset],pWave->dataSize,format,44100u,nBytes );
+					DoNotOptimize( pConverted );
+				}
+				state.SetBytesPerIteration( double( pWave->dataSize ) );
+			} );
+		}
+	}
+
+	void AddPlay( BenchRunner& runner,const std::shared_ptr<const WaveFile>& pWave )
+	{
+		// starting voices back to back from the game thread, past 64 they steal each other
+		for( const int nBurst : { 1,16,64,256 } )
+		{
+			runner.Add( "Audio/Play/Burst/" + std::to_string( nBurst ),[pWave,nBurst]( BenchState& state )
+			{
+				const SoundSystem::ChannelStats before = SoundSystem::GetChannelStats();
+				std::unique_ptr<Sound> pSound;
+				while( state.KeepRunning() )
+				{
+					state.PauseTiming();
+					// the old sound waits for its voices to stop here, outside the measurement
+					if( pSound )
+					{
+						pSound->StopAll();
+					}
+					pSound = std::make_unique<Sound>( pWave->image.data(),pWave->image.size(),L"bench" );
+					state.ResumeTiming();
+					for( int i = 0; i < nBurst; i++ )
+					{
+						pSound->Play();
+					}
+				}
+				pSound->StopAll();
+				SetChannelCounters( state,SoundSystem::GetChannelStats() - before,double( state.GetIterations() ) );
+				state.SetItemsPerIteration( double( nBurst ) );
+			} );
+		}
+	}
+
+	void AddContention( BenchRunner& runner,const std::shared_ptr<const WaveFile>& pWave )
+	{
+		// several threads start voices at once, so they fight over the free list (and the
+		// mixer retiring voices pushes back onto it at the same time)
+		for( const int nThreads : { 1,2,4,8 } )
+		{
+			runner.Add( "Audio/Channels/Contention/" + std::to_string( nThreads ) + "threads",[pWave,nThreads]( BenchState& state )
+			{
+				std::atomic<Sound*> pCurrent = { nullptr };
+				std::atomic<int> round = { 0 };
+				std::atomic<int> nDone = { 0 };
+				std::atomic<bool> quitting = { false };
+				std::atomic<long long> playNanoseconds = { 0 };
+				std::vector<std::thread> threads;
+				for( int t = 0; t < nThreads; t++ )
+				{
+					threads.emplace_back( [&]()
+					{
+						int seen = 0;
+						while( true )
+						{
+							while( round.load() == seen && !quitting )
+							{
+								std::this_thread::yield();
+							}
+							if( quitting )
+							{
+								return;
+							}
+							seen = round.load();
+							Sound& sound = *pCurrent.load();
+							const auto start = std::chrono::steady_clock::now();
+							for( int i = 0; i < nPlaysPerThread; i++ )
+							{
+								sound.Play();
+							}
+							playNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+								std::chrono::steady_clock::now() - start ).count();
+							nDone++;
+						}
+					} );
+				}
+
+				const SoundSystem::ChannelStats before = SoundSystem::GetChannelStats();
+				std::unique_ptr<Sound> pSound;
+				while( state.KeepRunning() )
+				{
+					state.PauseTiming();
+					if( pSound )
+					{
+						pSound->StopAll();
+					}
+					pSound = std::make_unique<Sound>( pWave->image.data(),pWave->image.size(),L"bench" );
+					pCurrent = pSound.get();
+					nDone = 0;
+					state.ResumeTiming();
+					round++;
+					while( nDone.load() < nThreads )
+					{
+						std::this_thread::yield();
+					}
+				}
+				quitting = true;
+				for( auto& t : threads )
+				{
+					t.join();
+				}
+				pSound->StopAll();
+
+				const double nIterations = double( state.GetIterations() );
+				SetChannelCounters( state,SoundSystem::GetChannelStats() - before,nIterations );
+				// what a single Play took on average, as seen by the thread calling it
+				state.counters["ns_per_play"] = double( playNanoseconds ) / (nIterations * nThreads * nPlaysPerThread);
+				state.SetItemsPerIteration( double( nThreads * nPlaysPerThread ) );
+			} );
+		}
+	}
+
+	void AddMix( BenchRunner& runner,const std::shared_ptr<const WaveFile>& pWave )
+	{
+		// the kernel every voice goes through once a block
+		for( const bool pitched : { false,true } )
+		{
+			runner.Add( std::string( "Audio/Mix/Pcm16/" ) + (pitched ? "Pitched" : "Unity"),[pWave,pitched]( BenchState& state )
+			{
+				const int16_t* const pSrc = reinterpret_cast<const int16_t*>( &pWave->image[pWave->dataOffset] );
+				const size_t nSrcFrames = pWave->dataSize / (SoundMixer::nChannels * sizeof( int16_t ));
+				std::vector<float> bus( nMixBlockFrames * SoundMixer::nChannels );
+				const uint64_t step = pitched ? SoundMixer::StepFromRatio( 1.1f ) : SoundMixer::unityStep;
+				uint64_t pos = 0u;
+				while( state.KeepRunning() )
+				{
+					// around the sound's end and back like a looping voice
+					if( SoundMixer::MixPcm16( bus.data(),nMixBlockFrames,pSrc,nSrcFrames,pSrc,pos,step,0.5f ) < nMixBlockFrames )
+					{
+						pos = 0u;
+					}
+					DoNotOptimize( bus.data() );
+				}
+				state.SetItemsPerIteration( double( nMixBlockFrames ) );
+			} );
+		}
+		runner.Add( "Audio/Mix/Finalize",[]( BenchState& state )
+		{
+			std::vector<float> bus( nMixBlockFrames * SoundMixer::nChannels,0.25f );
+			while( state.KeepRunning() )
+			{
+				SoundMixer::Finalize( bus.data(),nMixBlockFrames,1.0f );
+				DoNotOptimize( bus.data() );
+			}
+			state.SetItemsPerIteration( double( nMixBlockFrames ) );
+		} );
+
+		// whole blocks as the mixer thread does them, timed by the mixer itself (MixStats),
+		// one iteration per block, so these take real time: a block is ~11.6ms of audio
+		for( const int nVoices : { 0,1,8,32,64 } )
+		{
+			runner.Add( "Audio/Mix/Block/" + std::to_string( nVoices ) + "voices",[pWave,nVoices]( BenchState& state )
+			{
+				Sound sound( pWave->image.data(),pWave->image.size(),L"bench",Sound::LoopType::AutoFullSound );
+				for( int i = 0; i < nVoices; i++ )
+				{
+					sound.Play();
+				}
+				const SoundSystem::MixStats first = SoundSystem::GetMixStats();
+				SoundSystem::MixStats last = first;
+				while( state.KeepRunning() )
+				{
+					// wait for the mixer to get through at least one more block
+					SoundSystem::MixStats now;
+					do
+					{
+						std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+						now = SoundSystem::GetMixStats();
+					}
+					while( now.nBlocks == last.nBlocks );
+					state.SetIterationNanoseconds( double( now.mixNanoseconds - last.mixNanoseconds ) / double( now.nBlocks - last.nBlocks ) );
+					last = now;
+				}
+				sound.StopAll();
+				if( last.nVoiceBlocks > first.nVoiceBlocks )
+				{
+					state.counters["ns_per_voice_block"] = double( last.mixNanoseconds - first.mixNanoseconds ) /
+						double( last.nVoiceBlocks - first.nVoiceBlocks );
+				}
+				state.SetItemsPerIteration( double( nVoices ) );
+			} );
+		}
+	}
+}
+
+void AddAudioBenchmarks( BenchRunner& runner )
+{
+	SoundSystem::SetDevice( SoundSystem::Device::Null );
+	std::shared_ptr<const WaveFile> pShort;
+	for( const char* name : { "menu_boop.wav","spayed.wav" } )
+	{
+		auto pWave = std::make_shared<WaveFile>();
+		if( !LoadWaveFile( name,*pWave ) )
+		{
+			printf( "%s not found, skipping its audio benchmarks\n",name );
+			continue;
+		}
+		AddLoad( runner,pWave );
+		// the hover boop is what gets spammed in the game
+		if( !pShort )
+		{
+			pShort = pWave;
+		}
+	}
+	if( pShort )
+	{
+		AddPlay( runner,pShort );
+		AddContention( runner,pShort );
+		AddMix( runner,pShort );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+	// a store through a volatile can't be optimized away, not even with link time code generation
+	const void* volatile sink = nullptr;
+
+	// makes names and counter keys safe to put between json quotes
+	std::string Escape( const std::string& s )
+	{
+		std::string out;
+		for( const char c : s )
+		{
+			if( c == '"' || c == '\\' )
+			{
+				out += '\\';
+			}
+			out += c;
+		}
+		return out;
+	}
+}
+
+void DoNotOptimize( const void* p )
+{
+	sink = p;
+}
+
+BenchState::BenchState( size_t iterations,unsigned int seed )
+	:
+	iterations( iterations ),
+	iLeft( iterations ),
+	seed( seed )
+{}
+
+bool BenchState::KeepRunning()
+{
+	if( !started )
+	{
+		started = true;
+		start = std::chrono::steady_clock::now();
+		loopStart = start;
+	}
+	if( iLeft == 0u )
+	{
+		PauseTiming();
+		loopElapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - loopStart ).count();
+		return false;
+	}
+	iLeft--;
+	return true;
+}
+
+void BenchState::PauseTiming()
+{
+	elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+}
+
+void BenchState::ResumeTiming()
+{
+	start = std::chrono::steady_clock::now();
+}
+
+size_t BenchState::GetIterations() const
+{
+	return iterations;
+}
+
+unsigned int BenchState::GetSeed() const
+{
+	return seed;
+}
+
+void BenchState::SetItemsPerIteration( double items )
+{
+	itemsPerIteration = items;
+}
+
+void BenchState::SetBytesPerIteration( double bytes )
+{
+	bytesPerIteration = bytes;
+}
+
+void BenchState::SetIterationNanoseconds( double nanoseconds )
+{
+	manualTime = true;
+	manualElapsed += nanoseconds;
+}
+
+int64_t BenchState::GetElapsedNanoseconds() const
+{
+	return manualTime ? int64_t( manualElapsed ) : elapsed;
+}
+
+int64_t BenchState::GetLoopNanoseconds() const
+{
+	return loopElapsed;
+}
+
+BenchRunner::BenchRunner( int argc,char** argv )
+{
+	for( int i = 1; i < argc; i++ )
+	{
+		const bool hasValue = i + 1 < argc;
+		if( !strcmp( argv[i],"--filter" ) && hasValue )
+		{
+			filter = argv[++i];
+		}
+		else if( !strcmp( argv[i],"--json" ) && hasValue )
+		{
+			jsonFile = argv[++i];
+		}
+		else if( !strcmp( argv[i],"--seed" ) && hasValue )
+		{
+			seed = static_cast<unsigned int>( strtoul( argv[++i],nullptr,10 ) );
+		}
+		else if( !strcmp( argv[i],"--min-time" ) && hasValue )
+		{
+			minTime = atof( argv[++i] );
+		}
+		else if( !strcmp( argv[i],"--repetitions" ) && hasValue )
+		{
+			repetitions = std::max( atoi( argv[++i] ),1 );
+		}
+		else if( !strcmp( argv[i],"--list" ) )
+		{
+			listOnly = true;
+		}
+		else
+		{
+			printf( "unknown argument %s\n"
+				"usage: Benchmark [--filter <substring>] [--json <file>] [--seed <n>] [--min-time <seconds>] [--repetitions <n>] [--list]\n",
+				argv[i] );
+		}
+	}
+}
+
+void BenchRunner::Add( const std::string& name,std::function<void( BenchState& )> func )
+{
+	cases.push_back( { name,std::move( func ) } );
+}
+
+int BenchRunner::Run()
+{
+	std::vector<Result> results;
+	if( !listOnly )
+	{
+		printf( "%-40s %14s %14s %12s %14s\n","benchmark","ns/iter","min","iterations","items/s" );
+	}
+	for( const Case& c : cases )
+	{
+		if( c.name.find( filter ) == std::string::npos )
+		{
+			continue;
+		}
+		if( listOnly )
+		{
+			printf( "%s\n",c.name.c_str() );
+			continue;
+		}
+		const Result r = RunCase( c );
+		printf( "%-40s %14.1f %14.1f %12zu %14.4g\n",r.name.c_str(),r.median,r.min,r.iterations,r.itemsPerSecond );
+		results.push_back( r );
+	}
+	if( listOnly )
+	{
+		return 0;
+	}
+
+	std::ofstream file( jsonFile,std::ios::binary );
+	file << GetJson( results );
+	if( !file )
+	{
+		printf( "can't write %s\n",jsonFile.c_str() );
+		return 1;
+	}
+	printf( "results written to %s\n",jsonFile.c_str() );
+	return 0;
+}
+
+BenchRunner::Result BenchRunner::RunCase( const Case& c ) const
+{
+	// one iteration to warm caches and get an estimate, then grow until a run takes minTime
+	// (or until the paused setup makes the loop take far longer than that)
+	size_t iterations = 1u;
+	for( ;; )
+	{
+		BenchState state( iterations,seed );
+		c.func( state );
+		const double seconds = double( state.GetElapsedNanoseconds() ) / 1e9;
+		const double loopSeconds = double( state.GetLoopNanoseconds() ) / 1e9;
+		if( seconds >= minTime || loopSeconds >= minTime * 10.0 || iterations >= 1000000000u )
+		{
+			break;
+		}
+		// aim a bit over minTime, but don't grow more than 10x at once
+		const double scale = seconds > 0.0 ? minTime * 1.4 / seconds : 10.0;
+		iterations = std::max( iterations + 1u,size_t( double( iterations ) * std::min( scale,10.0 ) ) );
+	}
+
+	std::vector<double> times;
+	double itemsPerIteration = 0.0;
+	double bytesPerIteration = 0.0;
+	Result r = {};
+	r.name = c.name;
+	r.iterations = iterations;
+	for( int i = 0; i < repetitions; i++ )
+	{
+		BenchState state( iterations,seed );
+		c.func( state );
+		times.push_back( double( state.GetElapsedNanoseconds() ) / double( iterations ) );
+		itemsPerIteration = state.itemsPerIteration;
+		bytesPerIteration = state.bytesPerIteration;
+		r.counters = state.counters;
+	}
+	std::sort( times.begin(),times.end() );
+	r.median = times.size() % 2u ? times[times.size() / 2u] : (times[times.size() / 2u - 1u] + times[times.size() / 2u]) / 2.0;
+	r.min = times.front();
+	r.max = times.back();
+	// the rates are from the median
+	r.itemsPerSecond = itemsPerIteration * 1e9 / r.median;
+	r.bytesPerSecond = bytesPerIteration * 1e9 / r.median;
+	return r;
+}
+
+std::string BenchRunner::GetJson( const std::vector<Result>& results ) const
+{
+	char line[512];
+	const time_t now = time( nullptr );
+	char date[32];
+	strftime( date,sizeof( date ),"%Y-%m-%dT%H:%M:%S",localtime( &now ) );
+	snprintf( line,sizeof( line ),
+		"{\n\"context\":{\"date\":\"%s\",\"num_cpus\":%u,\"seed\":%u,\"min_time\":%g,\"repetitions\":%d,\"build\":\"%s\"},\n\"benchmarks\":[",
+		date,std::thread::hardware_concurrency(),seed,minTime,repetitions,
+#ifdef NDEBUG
+		"release"
+#else
+		"debug"
+#endif
+	);
+	std::string json = line;
+	bool first = true;
+	for( const Result& r : results )
+	{
+		snprintf( line,sizeof( line ),
+			"%s\n{\"name\":\"%s\",\"iterations\":%zu,\"real_time\":%.3f,\"min_time\":%.3f,\"max_time\":%.3f,\"time_unit\":\"ns\"",
+			first ? "" : ",",Escape( r.name ).c_str(),r.iterations,r.median,r.min,r.max );
+		json += line;
+		if( r.itemsPerSecond > 0.0 )
+		{
+			snprintf( line,sizeof( line ),",\"items_per_second\":%.6g",r.itemsPerSecond );
+			json += line;
+		}
+		if( r.bytesPerSecond > 0.0 )
+		{
+			snprintf( line,sizeof( line ),",\"bytes_per_second\":%.6g",r.bytesPerSecond );
+			json += line;
+		}
+		for( const auto& counter : r.counters )
+		{
+			snprintf( line,sizeof( line ),",\"%s\":%.6g",Escape( counter.first ).c_str(),counter.second );
+			json += line;
+		}
+		json += "}";
+		first = false;
+	}
+	return json + "\n]}\n";
+}
\ No newline at end of file
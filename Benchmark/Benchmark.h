@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// a minimal google benchmark style runner
+// a case loops while( state.KeepRunning() ) around the code it measures, the runner grows the
+// iteration count until one run takes at least the minimum time, then repeats that run a few times
+// and reports the median/min/max time per iteration
+class BenchState
+{
+public:
+	BenchState( size_t iterations,unsigned int seed );
+	// true while there are iterations left, the timer runs from the first call to the last
+	bool KeepRunning();
+	// keep per-iteration setup (building a fresh board, say) out of the measurement
+	void PauseTiming();
+	void ResumeTiming();
+	size_t GetIterations() const;
+	// the same seed every run (set with --seed), mix in a constant for a different stream
+	unsigned int GetSeed() const;
+	// work per iteration, reported as a rate per second
+	void SetItemsPerIteration( double items );
+	void SetBytesPerIteration( double bytes );
+	// for cases that measure their iterations themselves (work done on another thread, say),
+	// once called the reported time is the sum of these instead of the loop timer
+	void SetIterationNanoseconds( double nanoseconds );
+	int64_t GetElapsedNanoseconds() const;
+	// the whole loop including the paused parts
+	int64_t GetLoopNanoseconds() const;
+public:
+	// extra numbers for the report (tiles a cascade opened, ...), reported as is
+	std::map<std::string,double> counters;
+	double itemsPerIteration = 0.0;
+	double bytesPerIteration = 0.0;
+private:
+	size_t iterations;
+	size_t iLeft;
+	unsigned int seed;
+	bool started = false;
+	std::chrono::steady_clock::time_point loopStart;
+	std::chrono::steady_clock::time_point start;
+	int64_t elapsed = 0;
+	int64_t loopElapsed = 0;
+	bool manualTime = false;
+	double manualElapsed = 0.0;
+};
+
+class BenchRunner
+{
+public:
+	// --filter <substring> --json <file> --seed <n> --min-time <seconds> --repetitions <n>
+	BenchRunner( int argc,char** argv );
+	void Add( const std::string& name,std::function<void( BenchState& )> func );
+	// runs the cases matching the filter, prints a table and writes the json, returns the exit code
+	int Run();
+private:
+	struct Case
+	{
+		std::string name;
+		std::function<void( BenchState& )> func;
+	};
+	struct Result
+	{
+		std::string name;
+		size_t iterations;
+		// nanoseconds per iteration over the repetitions
+		double median;
+		double min;
+		double max;
+		double itemsPerSecond;
+		double bytesPerSecond;
+		std::map<std::string,double> counters;
+	};
+private:
+	Result RunCase( const Case& c ) const;
+	std::string GetJson( const std::vector<Result>& results ) const;
+private:
+	std::vector<Case> cases;
+	std::string filter;
+	std::string jsonFile = "benchmark.json";
+	unsigned int seed = 20160720u;
+	double minTime = 0.1;
+	int repetitions = 5;
+	bool listOnly = false;
+};
+
+// prevents the optimizer from dropping a computation whose result the benchmark doesn't use
+void DoNotOptimize( const void* p );
+template<typename T>
+inline void DoNotOptimize( const T& value )
+{
+	DoNotOptimize( static_cast<const void*>( &value ) );
+}
+
+// the suites, each in its own file
+void AddMemeFieldBenchmarks( BenchRunner& runner );
+void AddRenderBenchmarks( BenchRunner& runner );
+void AddAudioBenchmarks( BenchRunner& runner );
+void AddMetricsBenchmarks( BenchRunner& runner );
\ No newline at end of file
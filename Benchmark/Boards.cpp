@@ -0,0 +1,85 @@
+#include "Boards.h"
+#include "SpriteCodex.h"
+#include <algorithm>
+
+const Board smallBoard = { "Small",8,4,5 };
+const Board mediumBoard = { "Medium",14,7,15 };
+const Board largeBoard = { "Large",24,16,45 };
+const Board expertBoard = { "Expert",30,16,99 };
+
+Board MakeCustomBoard( int width,int height,float density )
+{
+	const int percent = int( density * 100.0f + 0.5f );
+	return { std::to_string( width ) + "x" + std::to_string( height ) + "/" + std::to_string( percent ) + "%",
+		width,height,std::max( int( float( width * height ) * density ),1 ) };
+}
+
+Board MakeScreenBoard()
+{
+	const int border = 10;
+	return MakeCustomBoard( (Graphics::ScreenWidth - 2 * border) / SpriteCodex::tileSize,
+		(Graphics::ScreenHeight - 2 * border) / SpriteCodex::tileSize,0.16f );
+}
+
+std::unique_ptr<MemeField> MakeField( const Board& board,unsigned int seed )
+{
+	const Vei2 screenCenter = { Graphics::ScreenWidth / 2,Graphics::ScreenHeight / 2 };
+	return std::make_unique<MemeField>( screenCenter,board.width,board.height,board.nMemes,seed );
+}
+
+int CountRevealed( const MemeField& field )
+{
+	int count = 0;
+	for( Vei2 gridPos = { 0,0 }; gridPos.y < field.GetHeight(); gridPos.y++ )
+	{
+		for( gridPos.x = 0; gridPos.x < field.GetWidth(); gridPos.x++ )
+		{
+			count += field.TileIsRevealed( gridPos ) ? 1 : 0;
+		}
+	}
+	return count;
+}
+
+void RevealAllSafe( MemeField& field )
+{
+	for( Vei2 gridPos = { 0,0 }; gridPos.y < field.GetHeight(); gridPos.y++ )
+	{
+		for( gridPos.x = 0; gridPos.x < field.GetWidth(); gridPos.x++ )
+		{
+			if( !field.TileHasMeme( gridPos ) && !field.TileIsRevealed( gridPos ) )
+			{
+				field.OnRevealClick( field.GridToScreen( gridPos ) );
+			}
+		}
+	}
+}
+
+Vei2 FindMeme( const MemeField& field,int nth )
+{
+	for( Vei2 gridPos = { 0,0 }; gridPos.y < field.GetHeight(); gridPos.y++ )
+	{
+		for( gridPos.x = 0; gridPos.x < field.GetWidth(); gridPos.x++ )
+		{
+			if( field.TileHasMeme( gridPos ) && nth-- == 0 )
+			{
+				return gridPos;
+			}
+		}
+	}
+	return { -1,-1 };
+}
+
+void FlagMemes( MemeField& field,int nFlags )
+{
+	for( Vei2 gridPos = { 0,0 }; gridPos.y < field.GetHeight() && nFlags > 0; gridPos.y++ )
+	{
+		for( gridPos.x = 0; gridPos.x < field.GetWidth() && nFlags > 0; gridPos.x++ )
+		{
+			if( field.TileHasMeme( gridPos ) && !field.TileIsFlagged( gridPos ) )
+			{
+				field.OnFlagClick( field.GridToScreen( gridPos ) );
+				nFlags--;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "MemeField.h"
+#include <memory>
+#include <string>
+
+// boards shared by the suites, every field is built from a seed so runs see the same layouts
+struct Board
+{
+	std::string name;
+	int width;
+	int height;
+	int nMemes;
+};
+
+// the menu presets (Game::UpdateModel)
+extern const Board smallBoard;
+extern const Board mediumBoard;
+extern const Board largeBoard;
+// the classic expert board, for comparing with other minesweepers
+extern const Board expertBoard;
+
+// named like 64x64/16%
+Board MakeCustomBoard( int width,int height,float density );
+// the biggest board that still fits the screen with its border (48x36)
+Board MakeScreenBoard();
+// centered on the screen like the game does it
+std::unique_ptr<MemeField> MakeField( const Board& board,unsigned int seed );
+int CountRevealed( const MemeField& field );
+// clicks every safe tile that's still hidden, leaving only the memes to flag
+void RevealAllSafe( MemeField& field );
+// the nth meme in row order
+Vei2 FindMeme( const MemeField& field,int nth );
+// flags the first nFlags memes
+void FlagMemes( MemeField& field,int nFlags );
\ No newline at end of file
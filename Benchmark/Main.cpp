@@ -0,0 +1,14 @@
+// offline benchmarks of the game code, no window or audio device needed
+// usage: Benchmark [--filter <substring>] [--json <file>] [--seed <n>] [--min-time <seconds>] [--repetitions <n>] [--list]
+// build Release for numbers worth comparing, results go to benchmark.json unless --json says otherwise
+#include "Benchmark.h"
+
+int main( int argc,char** argv )
+{
+	BenchRunner runner( argc,argv );
+	AddMemeFieldBenchmarks( runner );
+	AddRenderBenchmarks( runner );
+	AddAudioBenchmarks( runner );
+	AddMetricsBenchmarks( runner );
+	return runner.Run();
+}
\ No newline at end of file
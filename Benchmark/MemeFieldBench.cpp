@@ -0,0 +1,315 @@
+// the MemeField core: board generation, reveal cascades, flagging into a win, hit testing and drawing
+// every board comes from the --seed seed, so runs (and machines) compare like for like
+#include "Benchmark.h"
+#include "Boards.h"
+#include "Graphics.h"
+#include "BoardQueue.h"
+#include "ThreadPool.h"
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// the safe clicks that open the fewest and the most tiles (tries all of them on fresh boards)
+	struct Clicks
+	{
+		Vei2 best;
+		int nBest;
+		Vei2 worst;
+		int nWorst;
+	};
+
+	Clicks FindClicks( const Board& board,unsigned int seed )
+	{
+		Clicks clicks = { { 0,0 },board.width * board.height + 1,{ 0,0 },0 };
+		const auto pLayout = MakeField( board,seed );
+		for( Vei2 gridPos = { 0,0 }; gridPos.y < board.height; gridPos.y++ )
+		{
+			for( gridPos.x = 0; gridPos.x < board.width; gridPos.x++ )
+			{
+				if( pLayout->TileHasMeme( gridPos ) )
+				{
+					continue;
+				}
+				const auto pField = MakeField( board,seed );
+				pField->OnRevealClick( pField->GridToScreen( gridPos ) );
+				const int n = CountRevealed( *pField );
+				if( n < clicks.nBest )
+				{
+					clicks.best = gridPos;
+					clicks.nBest = n;
+				}
+				if( n > clicks.nWorst )
+				{
+					clicks.worst = gridPos;
+					clicks.nWorst = n;
+				}
+			}
+		}
+		return clicks;
+	}
+
+	void AddConstruct( BenchRunner& runner,const Board& board )
+	{
+		runner.Add( "MemeField/Construct/" + board.name,[board]( BenchState& state )
+		{
+			// a different layout every iteration, the same sequence every run
+			unsigned int seed = state.GetSeed();
+			while( state.KeepRunning() )
+			{
+				const auto pField = MakeField( board,seed++ );
+				DoNotOptimize( *pField );
+			}
+			state.SetItemsPerIteration( double( board.width * board.height ) );
+		} );
+	}
+
+	void AddRestart( BenchRunner& runner,const Board& board )
+	{
+		// what a new game costs Game: the last field torn down and the next one built in the same arena
+		runner.Add( "MemeField/Restart/" + board.name,[board]( BenchState& state )
+		{
+			const Vei2 screenCenter = { Graphics::ScreenWidth / 2,Graphics::ScreenHeight / 2 };
+			FieldArena arena;
+			unsigned int seed = state.GetSeed();
+			while( state.KeepRunning() )
+			{
+				MemeField* const pField = new( arena.Allocate<MemeField>( 1u ) )
+					MemeField( screenCenter,board.width,board.height,board.nMemes,seed++,arena );
+				DoNotOptimize( *pField );
+				pField->~MemeField();
+				arena.Reset();
+			}
+			state.SetItemsPerIteration( double( board.width * board.height ) );
+			state.counters["arena_bytes"] = double( arena.GetCapacity() );
+		} );
+	}
+
+	void AddParallelGenerate( BenchRunner& runner,const Board& board,size_t nThreads )
+	{
+		// the stripes on nThreads threads (the calling one included), the board is the same for any count
+		runner.Add( "MemeField/Generate/" + board.name + "/" + std::to_string( nThreads ) + "threads",[board,nThreads]( BenchState& state )
+		{
+			const Vei2 screenCenter = { Graphics::ScreenWidth / 2,Graphics::ScreenHeight / 2 };
+			std::unique_ptr<ThreadPool> pPool;
+			if( nThreads > 1u )
+			{
+				pPool = std::make_unique<ThreadPool>( nThreads - 1u );
+			}
+			FieldArena arena;
+			unsigned int seed = state.GetSeed();
+			while( state.KeepRunning() )
+			{
+				MemeField* const pField = new( arena.Allocate<MemeField>( 1u ) )
+					MemeField( screenCenter,board.width,board.height,board.nMemes,seed++,arena,nullptr,pPool.get() );
+				DoNotOptimize( *pField );
+				state.PauseTiming();
+				pField->~MemeField();
+				arena.Reset();
+				state.ResumeTiming();
+			}
+			state.SetItemsPerIteration( double( board.width * board.height ) );
+		} );
+	}
+
+	void AddQueuedStart( BenchRunner& runner,const Board& board )
+	{
+		// what a click in the menu costs when the board was built ahead: taking it off the queue
+		runner.Add( "MemeField/Start/Queued/" + board.name,[board]( BenchState& state )
+		{
+			const Vei2 screenCenter = { Graphics::ScreenWidth / 2,Graphics::ScreenHeight / 2 };
+			BoardQueue queue( screenCenter,{ { board.width,board.height,board.nMemes } },1u,size_t( -1 ) );
+			while( state.KeepRunning() )
+			{
+				state.PauseTiming();
+				// the game is played for longer than it takes to build the next one
+				while( queue.GetReadyCount( 0u ) == 0u )
+				{
+					std::this_thread::yield();
+				}
+				state.ResumeTiming();
+				MemeField* const pField = queue.Take( 0u );
+				state.PauseTiming();
+				DoNotOptimize( *pField );
+				queue.Recycle( pField );
+				state.ResumeTiming();
+			}
+			state.counters["queue_bytes"] = double( queue.GetBytes() );
+		} );
+	}
+
+	void AddReveal( BenchRunner& runner,const Board& board,bool worst )
+	{
+		runner.Add( std::string( "MemeField/Reveal/" ) + (worst ? "Worst/" : "Best/") + board.name,[board,worst]( BenchState& state )
+		{
+			const Clicks clicks = FindClicks( board,state.GetSeed() );
+			const Vei2 gridPos = worst ? clicks.worst : clicks.best;
+			std::unique_ptr<MemeField> pField;
+			while( state.KeepRunning() )
+			{
+				state.PauseTiming();
+				// the old board is freed here too, outside the measurement
+				pField = MakeField( board,state.GetSeed() );
+				const Vei2 screenPos = pField->GridToScreen( gridPos );
+				state.ResumeTiming();
+				pField->OnRevealClick( screenPos );
+			}
+			const int nRevealed = worst ? clicks.nWorst : clicks.nBest;
+			state.SetItemsPerIteration( double( nRevealed ) );
+			state.counters["tiles_revealed"] = double( nRevealed );
+		} );
+	}
+
+	void AddFlagWin( BenchRunner& runner,const Board& board )
+	{
+		// the last flag on a cleared board, so the win check has to look at every tile
+		runner.Add( "MemeField/FlagWin/" + board.name,[board]( BenchState& state )
+		{
+			std::unique_ptr<MemeField> pField;
+			bool won = true;
+			while( state.KeepRunning() )
+			{
+				state.PauseTiming();
+				pField = MakeField( board,state.GetSeed() );
+				RevealAllSafe( *pField );
+				FlagMemes( *pField,board.nMemes - 1 );
+				const Vei2 screenPos = pField->GridToScreen( FindMeme( *pField,board.nMemes - 1 ) );
+				state.ResumeTiming();
+				pField->OnFlagClick( screenPos );
+				won = won && pField->GetState() == MemeField::State::Winrar;
+			}
+			state.SetItemsPerIteration( double( board.width * board.height ) );
+			state.counters["won"] = won ? 1.0 : 0.0;
+		} );
+		// flag and unflag on a fresh board, the win check bails at the first hidden tile
+		runner.Add( "MemeField/FlagToggle/" + board.name,[board]( BenchState& state )
+		{
+			const auto pField = MakeField( board,state.GetSeed() );
+			const Vei2 screenPos = pField->GridToScreen( { board.width / 2,board.height / 2 } );
+			while( state.KeepRunning() )
+			{
+				pField->OnFlagClick( screenPos );
+				pField->OnFlagClick( screenPos );
+			}
+			state.SetItemsPerIteration( 2.0 );
+		} );
+	}
+
+	void AddScreenToGrid( BenchRunner& runner,const Board& board )
+	{
+		runner.Add( "MemeField/ScreenToGrid/" + board.name,[board]( BenchState& state )
+		{
+			constexpr int nPositions = 4096;
+			const auto pField = MakeField( board,state.GetSeed() );
+			const RectI rect = pField->GetRect();
+			std::mt19937 rng( state.GetSeed() );
+			std::uniform_int_distribution<int> xDist( rect.left,rect.right - 1 );
+			std::uniform_int_distribution<int> yDist( rect.top,rect.bottom - 1 );
+			std::vector<Vei2> positions;
+			for( int i = 0; i < nPositions; i++ )
+			{
+				positions.push_back( { xDist( rng ),yDist( rng ) } );
+			}
+			while( state.KeepRunning() )
+			{
+				int sum = 0;
+				for( const Vei2& screenPos : positions )
+				{
+					const Vei2 gridPos = pField->ScreenToGrid( screenPos );
+					sum += gridPos.x + gridPos.y;
+				}
+				DoNotOptimize( sum );
+			}
+			state.SetItemsPerIteration( double( nPositions ) );
+		} );
+	}
+
+	// what the tiles look like decides which sprites get drawn
+	enum class Look
+	{
+		Hidden,
+		// every safe tile revealed, the memes flagged but one
+		Cleared,
+		// a meme clicked, so all memes show
+		Lost
+	};
+
+	void AddDraw( BenchRunner& runner,const Board& board,Look look )
+	{
+		const char* const lookNames[] = { "Hidden","Cleared","Lost" };
+		runner.Add( "MemeField/Draw/" + board.name + "/" + lookNames[int( look )],[board,look]( BenchState& state )
+		{
+			Graphics gfx( Graphics::Headless{} );
+			const auto pField = MakeField( board,state.GetSeed() );
+			if( look == Look::Cleared )
+			{
+				RevealAllSafe( *pField );
+				FlagMemes( *pField,board.nMemes - 1 );
+			}
+			else if( look == Look::Lost )
+			{
+				pField->OnRevealClick( pField->GridToScreen( FindMeme( *pField,0 ) ) );
+			}
+			gfx.BeginFrame();
+			while( state.KeepRunning() )
+			{
+				pField->Draw( gfx );
+				DoNotOptimize( gfx.GetSysBuffer() );
+			}
+			state.SetItemsPerIteration( double( board.width * board.height ) );
+		} );
+	}
+}
+
+void AddMemeFieldBenchmarks( BenchRunner& runner )
+{
+	const Board presets[] = { smallBoard,mediumBoard,largeBoard };
+	for( const Board& board : presets )
+	{
+		AddConstruct( runner,board );
+	}
+	for( const int size : { 64,256 } )
+	{
+		for( const float density : { 0.10f,0.16f,0.30f } )
+		{
+			AddConstruct( runner,MakeCustomBoard( size,size,density ) );
+		}
+	}
+	// against Construct of the same boards, the difference is the heap and fresh pages
+	for( const Board& board : { smallBoard,mediumBoard,largeBoard,MakeCustomBoard( 256,256,0.16f ) } )
+	{
+		AddRestart( runner,board );
+		AddQueuedStart( runner,board );
+	}
+
+	// how generation scales with threads on a board of many stripes
+	for( const size_t nThreads : { 1u,2u,4u,8u } )
+	{
+		AddParallelGenerate( runner,MakeCustomBoard( 2048,2048,0.16f ),nThreads );
+	}
+
+	// openings come off their lists, but a board with a flag in one falls back to the tile by tile cascade
+	const Board revealBoards[] = { smallBoard,mediumBoard,largeBoard,MakeCustomBoard( 64,64,0.10f ) };
+	for( const Board& board : revealBoards )
+	{
+		AddReveal( runner,board,false );
+		AddReveal( runner,board,true );
+	}
+
+	for( const Board& board : revealBoards )
+	{
+		AddFlagWin( runner,board );
+	}
+
+	AddScreenToGrid( runner,largeBoard );
+
+	const Board drawBoards[] = { smallBoard,mediumBoard,largeBoard,MakeScreenBoard() };
+	for( const Board& board : drawBoards )
+	{
+		for( const Look look : { Look::Hidden,Look::Cleared,Look::Lost } )
+		{
+			AddDraw( runner,board,look );
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+// board metrics: 3BV and its parts on single layouts, with the solver playing, and batches of
+// generated boards on a pool, in boards per second
+#include "Benchmark.h"
+#include "Boards.h"
+#include "BoardMetrics.h"
+#include "ThreadPool.h"
+#include <memory>
+#include <vector>
+
+namespace
+{
+	// layouts made ahead, cycled through so the timing isn't one board's
+	constexpr int nLayouts = 64;
+
+	void AddCompute( BenchRunner& runner,const Board& board,bool solve )
+	{
+		runner.Add( std::string( "Metrics/" ) + (solve ? "Solve/" : "Clicks/") + board.name,[board,solve]( BenchState& state )
+		{
+			const size_t nTiles = size_t( board.width * board.height );
+			std::vector<unsigned char> layouts( nTiles * size_t( nLayouts ) );
+			for( int i = 0; i < nLayouts; i++ )
+			{
+				MemeField::PlaceMemes( board.width,board.height,board.nMemes,uint64_t( state.GetSeed() ) + uint64_t( i ),&layouts[nTiles * size_t( i )] );
+			}
+			BoardMetrics metrics;
+			double bbbv = 0.0;
+			double nGuesses = 0.0;
+			size_t iLayout = 0u;
+			while( state.KeepRunning() )
+			{
+				const BoardMetrics::Result result = metrics.Compute( board.width,board.height,board.nMemes,
+					&layouts[nTiles * iLayout],solve );
+				DoNotOptimize( result );
+				bbbv += double( result.bbbv );
+				nGuesses += double( result.nGuesses );
+				iLayout = (iLayout + 1u) % size_t( nLayouts );
+			}
+			state.SetItemsPerIteration( 1.0 );
+			state.counters["bbbv"] = bbbv / double( state.GetIterations() );
+			if( solve )
+			{
+				state.counters["guesses"] = nGuesses / double( state.GetIterations() );
+			}
+		} );
+	}
+
+	void AddBatch( BenchRunner& runner,const Board& board,size_t nThreads )
+	{
+		// generation included, on nThreads threads (the calling one included)
+		runner.Add( "Metrics/Batch/" + board.name + "/" + std::to_string( nThreads ) + "threads",[board,nThreads]( BenchState& state )
+		{
+			constexpr size_t nBoards = 64u * 1024u;
+			std::unique_ptr<ThreadPool> pPool;
+			if( nThreads > 1u )
+			{
+				pPool = std::make_unique<ThreadPool>( nThreads - 1u );
+			}
+			std::vector<BoardMetrics::Result> results( nBoards );
+			uint64_t seed = state.GetSeed();
+			while( state.KeepRunning() )
+			{
+				BoardMetrics::ComputeBatch( board.width,board.height,board.nMemes,seed,nBoards,false,pPool.get(),results.data() );
+				DoNotOptimize( results[0] );
+				seed += nBoards;
+			}
+			state.SetItemsPerIteration( double( nBoards ) );
+		} );
+	}
+}
+
+void AddMetricsBenchmarks( BenchRunner& runner )
+{
+	for( const Board& board : { largeBoard,expertBoard,MakeCustomBoard( 64,64,0.16f ) } )
+	{
+		AddCompute( runner,board,false );
+		AddCompute( runner,board,true );
+	}
+	for( const size_t nThreads : { 1u,2u,4u,8u } )
+	{
+		AddBatch( runner,expertBoard,nThreads );
+	}
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+// whole frames of each screen composed into a headless sysbuffer, clear included and present left out
+// every screen runs with the sprites drawn by the built-in PutPixel code and, when assets.pak is
+// around, blitted out of the pack
+// pixels/s counts what Graphics reports as written (HotCounters), bytes/s is the sysbuffer traffic
+// of the clear plus those pixels (what the sprite blits read comes on top)
+#include "Benchmark.h"
+#include "Boards.h"
+#include "Graphics.h"
+#include "SelectionMenu.h"
+#include "SpriteCodex.h"
+#include "AssetPack.h"
+#include "HotCounters.h"
+#include <functional>
+#include <memory>
+
+namespace
+{
+	AssetPack pack;
+
+	// draws one screen
+	typedef std::function<void( Graphics& gfx )> ComposeFunc;
+
+	uint64_t CountPixels( Graphics& gfx,const ComposeFunc& compose )
+	{
+#if CHILI_HOT_COUNTERS
+		// flush what's pending so the next frame only holds this compose
+		gfx.EndFrame();
+		HotCounters::EndFrame();
+		gfx.BeginFrame();
+		compose( gfx );
+		gfx.EndFrame();
+		HotCounters::EndFrame();
+		return HotCounters::GetLastFrame( HotCounters::Counter::PixelsWritten );
+#else
+		return 0u;
+#endif
+	}
+
+	void AddScreen( BenchRunner& runner,const std::string& name,std::function<ComposeFunc( unsigned int seed )> makeCompose )
+	{
+		const auto Add = [&]( bool packed )
+		{
+			runner.Add( "Render/" + name + (packed ? "/Packed" : "/Builtin"),[makeCompose,packed]( BenchState& state )
+			{
+				Graphics gfx( Graphics::Headless{} );
+				SpriteCodex::UsePack( packed ? &pack : nullptr );
+				const ComposeFunc compose = makeCompose( state.GetSeed() );
+				const uint64_t nPixels = CountPixels( gfx,compose );
+				while( state.KeepRunning() )
+				{
+					gfx.BeginFrame();
+					compose( gfx );
+					DoNotOptimize( gfx.GetSysBuffer() );
+				}
+				SpriteCodex::UsePack( nullptr );
+				const double clearBytes = double( sizeof( Color ) * Graphics::ScreenWidth * Graphics::ScreenHeight );
+				state.SetItemsPerIteration( double( nPixels ) );
+				state.SetBytesPerIteration( clearBytes + double( nPixels * sizeof( Color ) ) );
+				state.counters["pixels_per_frame"] = double( nPixels );
+			} );
+		};
+		Add( false );
+		if( pack.IsOpen() )
+		{
+			Add( true );
+		}
+	}
+
+	// the field as it looks after the given moves
+	enum class Look
+	{
+		Hidden,
+		// a meme clicked, so all memes show
+		Lost,
+		// everything revealed and flagged, the win sprite on top
+		Won
+	};
+
+	ComposeFunc MakeBoardCompose( const Board& board,Look look,unsigned int seed )
+	{
+		std::shared_ptr<MemeField> pField = MakeField( board,seed );
+		if( look == Look::Lost )
+		{
+			pField->OnRevealClick( pField->GridToScreen( FindMeme( *pField,0 ) ) );
+		}
+		else if( look == Look::Won )
+		{
+			RevealAllSafe( *pField );
+			FlagMemes( *pField,board.nMemes );
+		}
+		// what Game::ComposeFrame does in the Memesweeper state
+		return [pField]( Graphics& gfx )
+		{
+			pField->Draw( gfx );
+			if( pField->GetState() == MemeField::State::Winrar )
+			{
+				SpriteCodex::DrawWin( gfx.GetRect().GetCenter(),gfx );
+			}
+		};
+	}
+}
+
+void AddRenderBenchmarks( BenchRunner& runner )
+{
+	// from where the game runs, or from next to the solution
+	pack = AssetPack::OpenIfPresent( L"assets.pak" );
+	if( !pack.IsOpen() )
+	{
+		pack = AssetPack::OpenIfPresent( L"..\\Engine\\assets.pak" );
+	}
+
+	// the floor every screen pays: only the clear
+	runner.Add( "Render/Clear",[]( BenchState& state )
+	{
+		Graphics gfx( Graphics::Headless{} );
+		while( state.KeepRunning() )
+		{
+			gfx.BeginFrame();
+			DoNotOptimize( gfx.GetSysBuffer() );
+		}
+		state.SetBytesPerIteration( double( sizeof( Color ) * Graphics::ScreenWidth * Graphics::ScreenHeight ) );
+	} );
+
+	AddScreen( runner,"Menu",[]( unsigned int )
+	{
+		// where Game puts it
+		const auto pMenu = std::make_shared<SelectionMenu>( Vei2{ Graphics::ScreenWidth / 2,200 } );
+		return ComposeFunc( [pMenu]( Graphics& gfx )
+		{
+			pMenu->Draw( gfx );
+		} );
+	} );
+
+	const Board boards[] = { smallBoard,mediumBoard,largeBoard,MakeScreenBoard() };
+	const char* const lookNames[] = { "Hidden","Lost","Won" };
+	for( const Board& board : boards )
+	{
+		for( const Look look : { Look::Hidden,Look::Lost,Look::Won } )
+		{
+			AddScreen( runner,"Board/" + board.name + "/" + lookNames[int( look )],[board,look]( unsigned int seed )
+			{
+				return MakeBoardCompose( board,look,seed );
+			} );
+		}
+	}
+
+	// the win sprite alone, on an empty frame
+	AddScreen( runner,"Win",[]( unsigned int )
+	{
+		return ComposeFunc( []( Graphics& gfx )
+		{
+			SpriteCodex::DrawWin( gfx.GetRect().GetCenter(),gfx );
+		} );
+	} );
+}
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include "AllocTracker.h"
+#include "WideFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <new>
+
+namespace
+{
+	constexpr int nSubsystems = int( AllocTracker::Subsystem::Count );
+	const char* const names[nSubsystems] =
+	{
+		"other",
+		"input",
+		"update",
+		"compose",
+		"present",
+		"sound",
+		"assets"
+	};
+	// a thread takes the next slot on its first allocation and keeps it (so what exited threads
+	// counted stays in the sums), threads past the last slot all share that one
+	constexpr int nSlots = 64;
+	struct Slot
+	{
+		// only the owning thread writes (but in the shared slot), EndFrame reads from the game thread
+		std::atomic<uint64_t> nAllocs[nSubsystems];
+		std::atomic<uint64_t> nBytes[nSubsystems];
+		std::atomic<uint64_t> nFrees[nSubsystems];
+	};
+	// zeroed before any constructor runs, the runtime allocates long before main
+	Slot slots[nSlots];
+	std::atomic<int> nSlotsTaken = { 0 };
+	thread_local int iSlot = -1;
+	thread_local AllocTracker::Subsystem current = AllocTracker::Subsystem::Other;
+	thread_local uint64_t nThreadAllocs = 0u;
+
+	Slot& GetSlot()
+	{
+		if( iSlot < 0 )
+		{
+			iSlot = std::min( nSlotsTaken.fetch_add( 1 ),nSlots - 1 );
+		}
+		return slots[iSlot];
+	}
+
+	void Add( std::atomic<uint64_t>& count,uint64_t n )
+	{
+		if( iSlot == nSlots - 1 )
+		{
+			count.fetch_add( n,std::memory_order_relaxed );
+		}
+		else
+		{
+			count.store( count.load( std::memory_order_relaxed ) + n,std::memory_order_relaxed );
+		}
+	}
+
+	// guards everything below, taken once a frame and when reporting
+	std::mutex mutex;
+	AllocTracker::Counts lastTotals[nSubsystems] = {};
+	// ring of per-frame counts
+	AllocTracker::Counts frames[AllocTracker::nFrames][nSubsystems] = {};
+	uint64_t frameNumbers[AllocTracker::nFrames] = {};
+	uint64_t nextFrameNumber = 0u;
+	size_t iNext = 0u;
+	size_t nRecorded = 0u;
+	AllocTracker::Counts lastFrame[nSubsystems] = {};
+}
+
+AllocTracker::Scope::Scope( Subsystem s )
+	:
+	prev( current )
+{
+	current = s;
+}
+
+AllocTracker::Scope::~Scope()
+{
+	current = prev;
+}
+
+void AllocTracker::OnAlloc( size_t nBytes )
+{
+	Slot& slot = GetSlot();
+	const int s = int( current );
+	Add( slot.nAllocs[s],1u );
+	Add( slot.nBytes[s],uint64_t( nBytes ) );
+	nThreadAllocs++;
+}
+
+void AllocTracker::OnFree()
+{
+	Add( GetSlot().nFrees[int( current )],1u );
+}
+
+void AllocTracker::EndFrame()
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	Counts totals[nSubsystems] = {};
+	for( const Slot& slot : slots )
+	{
+		for( int s = 0; s < nSubsystems; s++ )
+		{
+			totals[s].nAllocs += slot.nAllocs[s].load( std::memory_order_relaxed );
+			totals[s].nBytes += slot.nBytes[s].load( std::memory_order_relaxed );
+			totals[s].nFrees += slot.nFrees[s].load( std::memory_order_relaxed );
+		}
+	}
+	for( int s = 0; s < nSubsystems; s++ )
+	{
+		lastFrame[s].nAllocs = totals[s].nAllocs - lastTotals[s].nAllocs;
+		lastFrame[s].nBytes = totals[s].nBytes - lastTotals[s].nBytes;
+		lastFrame[s].nFrees = totals[s].nFrees - lastTotals[s].nFrees;
+		lastTotals[s] = totals[s];
+		frames[iNext][s] = lastFrame[s];
+	}
+	frameNumbers[iNext] = nextFrameNumber++;
+	iNext = (iNext + 1u) % nFrames;
+	if( nRecorded < nFrames )
+	{
+		nRecorded++;
+	}
+}
+
+AllocTracker::Counts AllocTracker::GetLastFrame( Subsystem s )
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return lastFrame[int( s )];
+}
+
+uint64_t AllocTracker::GetThreadAllocs()
+{
+	return nThreadAllocs;
+}
+
+std::string AllocTracker::GetLastFrameReport()
+{
+	Counts counts[nSubsystems];
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		std::copy( std::begin( lastFrame ),std::end( lastFrame ),counts );
+	}
+	std::string report;
+	for( int s = 0; s < nSubsystems; s++ )
+	{
+		if( counts[s].nAllocs > 0u || counts[s].nFrees > 0u )
+		{
+			report += std::string( names[s] ) + ": " + std::to_string( counts[s].nAllocs ) + " allocations ("
+				+ std::to_string( counts[s].nBytes ) + " bytes), " + std::to_string( counts[s].nFrees ) + " frees\n";
+		}
+	}
+	return report;
+}
+
+std::string AllocTracker::GetCsv()
+{
+	std::string csv = "frame";
+	for( const char* name : names )
+	{
+		csv += std::string( "," ) + name + "_allocs," + name + "_bytes," + name + "_frees";
+	}
+	csv += "\n";
+	std::lock_guard<std::mutex> lock( mutex );
+	for( size_t i = 0u; i < nRecorded; i++ )
+	{
+		const size_t frame = (iNext + nFrames - nRecorded + i) % nFrames;
+		csv += std::to_string( frameNumbers[frame] );
+		for( const Counts& c : frames[frame] )
+		{
+			csv += "," + std::to_string( c.nAllocs ) + "," + std::to_string( c.nBytes ) + "," + std::to_string( c.nFrees );
+		}
+		csv += "\n";
+	}
+	return csv;
+}
+
+bool AllocTracker::WriteCsv( const std::wstring& fileName )
+{
+	std::ofstream file;
+	OpenWideFile( file,fileName,std::ios::binary );
+	file << GetCsv();
+	return bool( file );
+}
+
+const char* AllocTracker::GetName( Subsystem s )
+{
+	return names[int( s )];
+}
+
+#if CHILI_ALLOC_TRACKING
+// the replacements, the array, nothrow and sized forms all go through the first two
+void* operator new( size_t size )
+{
+	AllocTracker::OnAlloc( size );
+	while( true )
+	{
+		if( void* const p = std::malloc( size > 0u ? size : 1u ) )
+		{
+			return p;
+		}
+		const std::new_handler handler = std::get_new_handler();
+		if( !handler )
+		{
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+}
+
+void operator delete( void* p ) noexcept
+{
+	if( p )
+	{
+		AllocTracker::OnFree();
+		std::free( p );
+	}
+}
+
+void* operator new[]( size_t size )
+{
+	return operator new( size );
+}
+
+void* operator new( size_t size,const std::nothrow_t& ) noexcept
+{
+	try
+	{
+		return operator new( size );
+	}
+	catch( const std::bad_alloc& )
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[]( size_t size,const std::nothrow_t& ) noexcept
+{
+	return operator new( size,std::nothrow );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+	operator delete( p );
+}
+
+void operator delete( void* p,const std::nothrow_t& ) noexcept
+{
+	operator delete( p );
+}
+
+void operator delete[]( void* p,const std::nothrow_t& ) noexcept
+{
+	operator delete( p );
+}
+
+void operator delete( void* p,size_t ) noexcept
+{
+	operator delete( p );
+}
+
+void operator delete[]( void* p,size_t ) noexcept
+{
+	operator delete( p );
+}
+#endif
\ No newline at end of file
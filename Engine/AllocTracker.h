@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// build with CHILI_ALLOC_TRACKING=0 to leave the global operator new/delete to the runtime
+#ifndef CHILI_ALLOC_TRACKING
+#define CHILI_ALLOC_TRACKING 1
+#endif
+
+// build with CHILI_ALLOC_STRICT=1 to have Game::Go assert that steady-state frames don't allocate
+// (needs tracking, and asserts only fire in debug builds)
+#ifndef CHILI_ALLOC_STRICT
+#define CHILI_ALLOC_STRICT 0
+#endif
+#if !CHILI_ALLOC_TRACKING
+#undef CHILI_ALLOC_STRICT
+#define CHILI_ALLOC_STRICT 0
+#endif
+
+#define CHILI_ALLOC_CONCAT_( a,b ) a##b
+#define CHILI_ALLOC_CONCAT( a,b ) CHILI_ALLOC_CONCAT_( a,b )
+#if CHILI_ALLOC_TRACKING
+#define CHILI_ALLOC_SCOPE( subsystem ) const AllocTracker::Scope CHILI_ALLOC_CONCAT( chiliAllocScope,__LINE__ )( AllocTracker::Subsystem::subsystem )
+#else
+#define CHILI_ALLOC_SCOPE( subsystem ) ((void)0)
+#endif
+
+// counts heap allocations with a replacement of the global operator new/delete
+// every thread counts into a fixed slot of its own (nothing in here may allocate), under the
+// subsystem of the innermost scope open on that thread, and once a frame EndFrame sums the
+// slots and stores the difference to last frame, like HotCounters does
+class AllocTracker
+{
+public:
+	enum class Subsystem
+	{
+		// everything outside a scope
+		Other,
+		// the message pump, which fills the mouse and keyboard buffers
+		Input,
+		Update,
+		Compose,
+		// Graphics::EndFrame
+		Present,
+		// starting voices, the mixer and stream threads
+		Sound,
+		// the loader's tasks
+		Assets,
+		Count
+	};
+	struct Counts
+	{
+		uint64_t nAllocs;
+		uint64_t nBytes;
+		// frees are counted under the scope of whoever frees, not the one who allocated
+		uint64_t nFrees;
+	};
+	// what the calling thread allocates goes to the subsystem until the scope closes
+	class Scope
+	{
+	public:
+		Scope( Subsystem s );
+		Scope( const Scope& ) = delete;
+		Scope& operator=( const Scope& ) = delete;
+		~Scope();
+	private:
+		Subsystem prev;
+	};
+	// frames kept for the time series
+	static constexpr size_t nFrames = 1024u;
+public:
+	// called by the operator new/delete replacements
+	static void OnAlloc( size_t nBytes );
+	static void OnFree();
+	// call once at the end of every frame
+	static void EndFrame();
+	// counts of the last completed frame
+	static Counts GetLastFrame( Subsystem s );
+	// how often the calling thread allocated so far, for checking a stretch of code doesn't
+	static uint64_t GetThreadAllocs();
+	// the subsystems that allocated in the last completed frame, a line each
+	static std::string GetLastFrameReport();
+	// frame number then allocs, bytes and frees columns per subsystem, oldest frame first
+	static std::string GetCsv();
+	static bool WriteCsv( const std::wstring& fileName );
+	static const char* GetName( Subsystem s );
+};
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include "AssetLoader.h"
+#include "AllocTracker.h"
+
+AssetLoader::AssetLoader( size_t nThreads )
+	:
+	pool( nThreads )
+{}
+
+std::future<Sound> AssetLoader::LoadSound( const std::wstring& fileName,Sound::LoopType loopType,Sound::Storage storage )
+{
+	return pool.Submit( [fileName,loopType,storage]()
+	{
+		CHILI_ALLOC_SCOPE( Assets );
+		return Sound( fileName,loopType,storage );
+	} );
+}
+
+std::future<Sound> AssetLoader::LoadSound( const AssetPack& pack,const std::string& name,Sound::LoopType loopType )
+{
+	const std::wstring wideName( name.begin(),name.end() );
+	AssetPack::Asset asset;
+	if( !pack.Find( name,asset ) || asset.format != AssetPack::Format::Wave )
+	{
+		return LoadSound( wideName,loopType );
+	}
+	return pool.Submit( [asset,wideName,loopType]()
+	{
+		CHILI_ALLOC_SCOPE( Assets );
+		return Sound( asset.pData,asset.size,wideName,loopType );
+	} );
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "Sound.h"
+#include "AssetPack.h"
+#include <chrono>
+#include <future>
+#include <string>
+
+// decodes assets on a pool of worker threads so the game can get going while they load
+// (a failed load throws its exception out of the future's get())
+class AssetLoader
+{
+public:
+	AssetLoader( size_t nThreads = ThreadPool::DefaultThreadCount() );
+	std::future<Sound> LoadSound( const std::wstring& fileName,
+		Sound::LoopType loopType = Sound::LoopType::NotLooping,
+		Sound::Storage storage = Sound::Storage::Resident );
+	// out of the pack when it has the sound (played straight from the mapping, so the pack has
+	// to outlive the sound), otherwise from the loose file of the same name
+	std::future<Sound> LoadSound( const AssetPack& pack,const std::string& name,
+		Sound::LoopType loopType = Sound::LoopType::NotLooping );
+	// for polling from the game loop, false again once the result has been taken
+	template<typename T>
+	static bool IsReady( const std::future<T>& f )
+	{
+		return f.valid() && f.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+	}
+private:
+	ThreadPool pool;
+};
\ No newline at end of file
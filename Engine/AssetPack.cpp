@@ -0,0 +1,202 @@
+#include "AssetPack.h"
+#include "StartupProfiler.h"
+#include <assert.h>
+#include <cstring>
+
+#define CHILI_PACK_EXCEPTION( filename,note ) AssetPack::Exception( _CRT_WIDE(__FILE__),__LINE__,note,filename )
+
+constexpr char AssetPack::magic[4];
+
+static_assert( sizeof( AssetPack::Header ) == 16u,"Pack header layout changed" );
+static_assert( sizeof( AssetPack::Entry ) == 32u,"Pack index entry layout changed" );
+static_assert( sizeof( AssetPack::SpriteHeader ) == 16u,"Packed sprite header layout changed" );
+static_assert( sizeof( Color ) == 4u,"Packed sprites are stored as 32-bit pixels" );
+
+AssetPack::AssetPack( const std::wstring& fileName )
+{
+	StartupProfiler::Phase phase( L"asset pack " + fileName );
+	// map the whole file, the handles can go as soon as the view is up (it keeps the file open)
+	const HANDLE hFile = CreateFileW( fileName.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,
+		OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr );
+	if( hFile == INVALID_HANDLE_VALUE )
+	{
+		throw CHILI_PACK_EXCEPTION( fileName,L"Could not open asset pack" );
+	}
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( hFile,&size ) || size.QuadPart < LONGLONG( sizeof( Header ) ) ||
+		uint64_t( size.QuadPart ) > uint64_t( SIZE_MAX ) )
+	{
+		CloseHandle( hFile );
+		throw CHILI_PACK_EXCEPTION( fileName,L"Asset pack has a bad size" );
+	}
+	const HANDLE hMapping = CreateFileMappingW( hFile,nullptr,PAGE_READONLY,0u,0u,nullptr );
+	CloseHandle( hFile );
+	if( hMapping == nullptr )
+	{
+		throw CHILI_PACK_EXCEPTION( fileName,L"Could not create asset pack file mapping" );
+	}
+	pBase = static_cast<const unsigned char*>( MapViewOfFile( hMapping,FILE_MAP_READ,0u,0u,0u ) );
+	CloseHandle( hMapping );
+	if( pBase == nullptr )
+	{
+		throw CHILI_PACK_EXCEPTION( fileName,L"Could not map asset pack" );
+	}
+	fileSize = size_t( size.QuadPart );
+
+	// check everything the lookups rely on once here, so Find doesn't have to
+	Header header;
+	memcpy( &header,pBase,sizeof( header ) );
+	const bool goodSlots = header.nSlots != 0u && (header.nSlots & (header.nSlots - 1u)) == 0u &&
+		header.nEntries < header.nSlots &&
+		header.nSlots <= (fileSize - sizeof( Header )) / sizeof( Entry );
+	if( memcmp( header.magic,magic,sizeof( magic ) ) != 0 || header.version != version || !goodSlots )
+	{
+		Close();
+		throw CHILI_PACK_EXCEPTION( fileName,L"Not an asset pack (or one built by a different packer version)" );
+	}
+	pIndex = reinterpret_cast<const Entry*>( pBase + sizeof( Header ) );
+	slotMask = header.nSlots - 1u;
+	uint32_t nUsed = 0u;
+	for( uint32_t i = 0u; i < header.nSlots; i++ )
+	{
+		const Entry& e = pIndex[i];
+		if( e.nameHash == 0u )
+		{
+			continue;
+		}
+		nUsed++;
+		if( e.offset > fileSize || e.size > fileSize - e.offset )
+		{
+			Close();
+			throw CHILI_PACK_EXCEPTION( fileName,L"Asset pack index points past the end of the file" );
+		}
+	}
+	// probing stops at an empty slot, there has to be one
+	if( nUsed >= header.nSlots )
+	{
+		Close();
+		throw CHILI_PACK_EXCEPTION( fileName,L"Asset pack index is full" );
+	}
+}
+
+AssetPack::AssetPack( AssetPack&& donor )
+{
+	*this = std::move( donor );
+}
+
+AssetPack& AssetPack::operator=( AssetPack&& donor )
+{
+	if( this != &donor )
+	{
+		Close();
+		pBase = donor.pBase;
+		fileSize = donor.fileSize;
+		pIndex = donor.pIndex;
+		slotMask = donor.slotMask;
+		donor.pBase = nullptr;
+		donor.pIndex = nullptr;
+	}
+	return *this;
+}
+
+AssetPack::~AssetPack()
+{
+	Close();
+}
+
+AssetPack AssetPack::OpenIfPresent( const std::wstring& fileName )
+{
+	try
+	{
+		return AssetPack( fileName );
+	}
+	catch( const Exception& )
+	{
+		return AssetPack();
+	}
+}
+
+bool AssetPack::IsOpen() const
+{
+	return pBase != nullptr;
+}
+
+bool AssetPack::Find( const std::string& name,Asset& asset ) const
+{
+	if( !pIndex )
+	{
+		return false;
+	}
+	// linear probing, the table is at most half full so the run ends at an empty slot quickly
+	const uint64_t hash = HashName( name );
+	for( uint32_t i = uint32_t( hash ) & slotMask; pIndex[i].nameHash != 0u; i = (i + 1u) & slotMask )
+	{
+		if( pIndex[i].nameHash == hash )
+		{
+			asset.pData = pBase + pIndex[i].offset;
+			asset.size = size_t( pIndex[i].size );
+			asset.format = pIndex[i].format;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool AssetPack::FindSprite( const std::string& name,SpriteView& sprite ) const
+{
+	Asset asset;
+	if( !Find( name,asset ) || asset.format != Format::Sprite || asset.size < sizeof( SpriteHeader ) )
+	{
+		return false;
+	}
+	SpriteHeader header;
+	memcpy( &header,asset.pData,sizeof( header ) );
+	if( uint64_t( header.width ) * header.height > (asset.size - sizeof( header )) / sizeof( Color ) )
+	{
+		return false;
+	}
+	sprite.width = int( header.width );
+	sprite.height = int( header.height );
+	sprite.originX = header.originX;
+	sprite.originY = header.originY;
+	sprite.pPixels = reinterpret_cast<const Color*>( asset.pData + sizeof( header ) );
+	return true;
+}
+
+uint64_t AssetPack::HashName( const std::string& name )
+{
+	uint64_t hash = 14695981039346656037ull;
+	for( const char c : name )
+	{
+		hash = (hash ^ uint64_t( uint8_t( c ) )) * 1099511628211ull;
+	}
+	return hash != 0u ? hash : 1u;
+}
+
+void AssetPack::Close()
+{
+	if( pBase )
+	{
+		UnmapViewOfFile( pBase );
+		pBase = nullptr;
+		pIndex = nullptr;
+	}
+}
+
+AssetPack::Exception::Exception( const wchar_t* file,unsigned int line,const std::wstring& note,const std::wstring& filename )
+	:
+	ChiliException( file,line,note ),
+	filename( filename )
+{}
+
+std::wstring AssetPack::Exception::GetFullMessage() const
+{
+	return L"Filename: " + filename + L"\n\n" +
+		L"Note: " + GetNote() + L"\n\n" +
+		L"Location: " + GetLocation();
+}
+
+std::wstring AssetPack::Exception::GetExceptionType() const
+{
+	return L"Asset Pack Exception";
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ChiliWin.h"
+#include "ChiliException.h"
+#include "SpriteView.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// every asset the game ships with in one file, mapped into memory in one go
+// the index is an open addressing hash table of name hashes, so a lookup costs
+// a hash and (almost always) one probe, and the assets are used in place from the mapping
+// (build packs with the AssetPacker tool)
+class AssetPack
+{
+public:
+	class Exception : public ChiliException
+	{
+	public:
+		Exception( const wchar_t* file,unsigned int line,const std::wstring& note,const std::wstring& filename );
+		virtual std::wstring GetFullMessage() const override;
+		virtual std::wstring GetExceptionType() const override;
+	private:
+		std::wstring filename;
+	};
+	enum class Format : uint32_t
+	{
+		Raw,
+		// a complete wave file
+		Wave,
+		// SpriteHeader then width * height Colors (rows top to bottom), Colors::Magenta is transparent
+		Sprite
+	};
+	struct Asset
+	{
+		const unsigned char* pData;
+		size_t size;
+		Format format;
+	};
+	// the file layout, shared with the packer (all little endian)
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		// index slots, a power of two at least twice the number of entries
+		uint32_t nSlots;
+		uint32_t nEntries;
+		// index of nSlots Entries right after the header
+	};
+	struct Entry
+	{
+		// 0 marks an empty slot
+		uint64_t nameHash;
+		uint64_t offset;
+		uint64_t size;
+		Format format;
+		uint32_t reserved;
+	};
+	struct SpriteHeader
+	{
+		uint32_t width;
+		uint32_t height;
+		int32_t originX;
+		int32_t originY;
+	};
+	static constexpr char magic[4] = { 'C','P','A','K' };
+	static constexpr uint32_t version = 1u;
+	// asset payloads start on this boundary
+	static constexpr size_t alignment = 16u;
+public:
+	// empty pack, finds nothing
+	AssetPack() = default;
+	AssetPack( const std::wstring& fileName );
+	AssetPack( AssetPack&& donor );
+	AssetPack& operator=( AssetPack&& donor );
+	AssetPack( const AssetPack& ) = delete;
+	AssetPack& operator=( const AssetPack& ) = delete;
+	~AssetPack();
+	// for packs that are optional: an empty pack if the file isn't there or isn't a pack
+	static AssetPack OpenIfPresent( const std::wstring& fileName );
+	bool IsOpen() const;
+	// pointers handed out stay valid for as long as the pack is open
+	bool Find( const std::string& name,Asset& asset ) const;
+	bool FindSprite( const std::string& name,SpriteView& sprite ) const;
+	// FNV-1a, never 0
+	static uint64_t HashName( const std::string& name );
+private:
+	void Close();
+private:
+	const unsigned char* pBase = nullptr;
+	size_t fileSize = 0u;
+	const Entry* pIndex = nullptr;
+	uint32_t slotMask = 0u;
+};
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "BoardMetrics.h"
+#include "MemeField.h"
+#include "ThreadPool.h"
+#include <assert.h>
+#include <algorithm>
+
+namespace
+{
+	// boards a task of the batch does, with one set of buffers
+	constexpr size_t batchChunk = 1024u;
+}
+
+BoardMetrics::Result BoardMetrics::Compute( int width_in,int height_in,int nMemes,const unsigned char* pMemes,bool solve )
+{
+	width = width_in;
+	height = height_in;
+	stride = width + 2;
+	const size_t nPadded = size_t( stride * (height + 2) );
+	padded.assign( nPadded,0u );
+	for( int y = 0; y < height; y++ )
+	{
+		std::copy( &pMemes[y * width],&pMemes[(y + 1) * width],&padded[(y + 1) * stride + 1] );
+	}
+	numbers.resize( nPadded );
+	kinds.assign( nPadded,Kind::Meme );
+	parents.resize( nPadded );
+	columnSums.resize( size_t( stride ) );
+	nOpenings = 0;
+	nIsolated = 0;
+	nIslands = 0;
+	// a row is counted once the one above is, and known isolated or not once the one below is
+	for( int y = 1; y <= height + 1; y++ )
+	{
+		if( y <= height )
+		{
+			CountRow( y );
+		}
+		if( y > 1 )
+		{
+			IsolateRow( y - 1 );
+		}
+	}
+	Result result = { nOpenings + nIsolated,nOpenings,nIsolated,nIslands,-1,-1 };
+	if( solve )
+	{
+		result.nGuesses = Solve( nMemes,result.nGuessesLost );
+	}
+	return result;
+}
+
+BoardMetrics::Result BoardMetrics::Compute( const MemeField& field,bool solve )
+{
+	memes.resize( size_t( field.GetWidth() * field.GetHeight() ) );
+	int nMemes = 0;
+	for( Vei2 gridPos = { 0,0 }; gridPos.y < field.GetHeight(); gridPos.y++ )
+	{
+		for( gridPos.x = 0; gridPos.x < field.GetWidth(); gridPos.x++ )
+		{
+			const bool hasMeme = field.TileHasMeme( gridPos );
+			memes[gridPos.y * field.GetWidth() + gridPos.x] = hasMeme ? 1u : 0u;
+			nMemes += hasMeme ? 1 : 0;
+		}
+	}
+	return Compute( field.GetWidth(),field.GetHeight(),nMemes,memes.data(),solve );
+}
+
+void BoardMetrics::ComputeBatch( int width,int height,int nMemes,uint64_t firstSeed,size_t nBoards,bool solve,
+	ThreadPool* pPool,Result* pResults )
+{
+	const size_t nChunks = (nBoards + batchChunk - 1u) / batchChunk;
+	const auto computeChunk = [=]( size_t chunk )
+	{
+		BoardMetrics metrics;
+		std::vector<unsigned char> layout( size_t( width * height ) );
+		const size_t end = std::min( (chunk + 1u) * batchChunk,nBoards );
+		for( size_t i = chunk * batchChunk; i < end; i++ )
+		{
+			MemeField::PlaceMemes( width,height,nMemes,firstSeed + i,layout.data() );
+			pResults[i] = metrics.Compute( width,height,nMemes,layout.data(),solve );
+		}
+	};
+	if( pPool )
+	{
+		pPool->ParallelFor( nChunks,computeChunk );
+	}
+	else
+	{
+		for( size_t chunk = 0u; chunk < nChunks; chunk++ )
+		{
+			computeChunk( chunk );
+		}
+	}
+}
+
+void BoardMetrics::CountRow( int y )
+{
+	// the border takes care of the edges, so these are straight sums the compiler can vectorize
+	// (with the bounds and buffers in locals, byte stores could alias the members otherwise)
+	const int nColumns = stride;
+	const int nInside = width;
+	const unsigned char* const pRow = &padded[y * nColumns];
+	unsigned char* const pSums = columnSums.data();
+	for( int x = 0; x < nColumns; x++ )
+	{
+		pSums[x] = static_cast<unsigned char>( pRow[x - nColumns] + pRow[x] + pRow[x + nColumns] );
+	}
+	unsigned char* const pNumbers = &numbers[y * nColumns];
+	Kind* const pKinds = &kinds[y * nColumns];
+	for( int x = 1; x <= nInside; x++ )
+	{
+		pNumbers[x] = static_cast<unsigned char>( pSums[x - 1] + pSums[x] + pSums[x + 1] - pRow[x] );
+		pKinds[x] = pRow[x] ? Kind::Meme : pNumbers[x] > 0u ? Kind::Number : Kind::Zero;
+	}
+	for( int x = 1; x <= nInside; x++ )
+	{
+		if( pKinds[x] == Kind::Zero )
+		{
+			const int i = y * nColumns + x;
+			parents[i] = i;
+			nOpenings += 1 - JoinBefore( i );
+		}
+	}
+}
+
+void BoardMetrics::IsolateRow( int y )
+{
+	const int nColumns = stride;
+	const int nInside = width;
+	Kind* const pKinds = &kinds[y * nColumns];
+	unsigned char* const pSums = columnSums.data();
+	for( int x = 0; x < nColumns; x++ )
+	{
+		pSums[x] = static_cast<unsigned char>( (pKinds[x - nColumns] == Kind::Zero ? 1 : 0) +
+			(pKinds[x] == Kind::Zero ? 1 : 0) + (pKinds[x + nColumns] == Kind::Zero ? 1 : 0) );
+	}
+	for( int x = 1; x <= nInside; x++ )
+	{
+		if( pKinds[x] == Kind::Number && pSums[x - 1] + pSums[x] + pSums[x + 1] == 0 )
+		{
+			const int i = y * nColumns + x;
+			pKinds[x] = Kind::Isolated;
+			parents[i] = i;
+			nIsolated++;
+			nIslands += 1 - JoinBefore( i );
+		}
+	}
+}
+
+int BoardMetrics::JoinBefore( int i )
+{
+	// of the neighbors swept already (left and the three above), the one above touches the
+	// other two, so they're in its set if they're of the kind, otherwise up left touches left
+	// (the border is never of a kind that joins)
+	const Kind kind = kinds[i];
+	int nJoined = 0;
+	if( kinds[i - stride] == kind )
+	{
+		nJoined += Join( i,i - stride ) ? 1 : 0;
+	}
+	else
+	{
+		if( kinds[i - stride - 1] == kind )
+		{
+			nJoined += Join( i,i - stride - 1 ) ? 1 : 0;
+		}
+		else if( kinds[i - 1] == kind )
+		{
+			nJoined += Join( i,i - 1 ) ? 1 : 0;
+		}
+		if( kinds[i - stride + 1] == kind )
+		{
+			nJoined += Join( i,i - stride + 1 ) ? 1 : 0;
+		}
+	}
+	return nJoined;
+}
+
+bool BoardMetrics::Join( int i,int j )
+{
+	const int rootA = FindRoot( i );
+	const int rootB = FindRoot( j );
+	if( rootA == rootB )
+	{
+		return false;
+	}
+	parents[std::max( rootA,rootB )] = std::min( rootA,rootB );
+	return true;
+}
+
+int BoardMetrics::FindRoot( int i )
+{
+	// halving the path on the way up
+	while( parents[i] != i )
+	{
+		parents[i] = parents[parents[i]];
+		i = parents[i];
+	}
+	return i;
+}
+
+int BoardMetrics::Solve( int nMemes,int& nGuessesLost )
+{
+	solver.Start( width,height,nMemes );
+	int nGuesses = 0;
+	nGuessesLost = 0;
+	while( true )
+	{
+		const BoardSolver::Move move = solver.Next();
+		if( move.type == BoardSolver::Move::Type::Done )
+		{
+			break;
+		}
+		if( move.type == BoardSolver::Move::Type::Flag )
+		{
+			continue;
+		}
+		nGuesses += move.guess ? 1 : 0;
+		if( kinds[ToPadded( move.tile )] == Kind::Meme )
+		{
+			// what it deduces is never wrong
+			assert( move.guess );
+			nGuessesLost++;
+			solver.OnMeme( move.tile );
+		}
+		else
+		{
+			Open( move.tile );
+		}
+	}
+	return nGuesses;
+}
+
+void BoardMetrics::Open( int tile )
+{
+	cascade.clear();
+	cascade.push_back( ToPadded( tile ) );
+	while( !cascade.empty() )
+	{
+		const int i = cascade.back();
+		cascade.pop_back();
+		const int x = i % stride - 1;
+		const int y = i / stride - 1;
+		const int tileAt = y * width + x;
+		if( solver.IsRevealed( tileAt ) )
+		{
+			continue;
+		}
+		solver.OnRevealed( tileAt,numbers[i] );
+		if( kinds[i] == Kind::Zero )
+		{
+			// a zero has no memes around, and border tiles don't count as safe
+			for( const int d : { -stride - 1,-stride,-stride + 1,-1,1,stride - 1,stride,stride + 1 } )
+			{
+				if( kinds[i + d] != Kind::Meme )
+				{
+					cascade.push_back( i + d );
+				}
+			}
+		}
+	}
+}
+
+int BoardMetrics::ToPadded( int tile ) const
+{
+	return (tile / width + 1) * stride + tile % width + 1;
+}
\ No newline at end of file
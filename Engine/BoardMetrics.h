@@ -0,0 +1,82 @@
+#pragma once
+
+#include "BoardSolver.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class MemeField;
+class ThreadPool;
+
+// how hard a board is: its 3BV (the fewest clicks that clear it) and what makes that up, and
+// how often a solver seeing only what a player sees has to guess its way through
+class BoardMetrics
+{
+public:
+	struct Result
+	{
+		// openings plus isolated numbers
+		int bbbv;
+		int nOpenings;
+		// safe tiles not on the border of an opening, each takes a click of its own
+		int nIsolated;
+		// 8-connected groups of isolated numbers
+		int nIslands;
+		// the solver's guesses (its first click is one), -1 when it didn't play
+		int nGuesses;
+		// guesses that hit a meme, the solver plays on as if it had flagged it
+		int nGuessesLost;
+	};
+public:
+	// one sweep down the rows for the clicks, the solver plays on top of that when asked
+	// the buffers grow to the biggest board seen and are reused after that
+	Result Compute( int width_in,int height_in,int nMemes,const unsigned char* pMemes,bool solve );
+	Result Compute( const MemeField& field,bool solve );
+	// the boards MemeField makes of the seeds from firstSeed on, results in seed order, in chunks
+	// on the pool and the calling thread (just the calling thread without a pool)
+	static void ComputeBatch( int width,int height,int nMemes,uint64_t firstSeed,size_t nBoards,bool solve,
+		ThreadPool* pPool,Result* pResults );
+private:
+	enum class Kind : unsigned char
+	{
+		Meme,
+		// safe with memes around, on the border of an opening or not yet known not to be
+		Number,
+		// no memes around, inside an opening
+		Zero,
+		Isolated
+	};
+private:
+	// numbers and zero tiles of a (padded) row, joining the zeros up with the rows above
+	void CountRow( int y );
+	// the numbers of a row away from every zero (the row below has to be counted already)
+	void IsolateRow( int y );
+	// joins a tile with the ones of its kind to the left and above, returns how many sets merged
+	int JoinBefore( int i );
+	bool Join( int i,int j );
+	int FindRoot( int i );
+	int Solve( int nMemes,int& nGuessesLost );
+	// a reveal and the cascade it sets off, reported to the solver
+	void Open( int tile );
+	int ToPadded( int tile ) const;
+private:
+	int width = 0;
+	int height = 0;
+	// the buffers have a border of a tile all around, which spares the sweeps the edge checks
+	int stride = 0;
+	int nOpenings = 0;
+	int nIsolated = 0;
+	int nIslands = 0;
+	// the board's memes, for the MemeField overload
+	std::vector<unsigned char> memes;
+	std::vector<unsigned char> padded;
+	std::vector<unsigned char> numbers;
+	// the border is Meme, as far as opening and joining go it's the same
+	std::vector<Kind> kinds;
+	// union-find of the zero tiles and of the isolated ones (never next to each other)
+	std::vector<int> parents;
+	// per column of the rows around the one being swept
+	std::vector<unsigned char> columnSums;
+	std::vector<int> cascade;
+	BoardSolver solver;
+};
\ No newline at end of file
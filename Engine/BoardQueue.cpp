@@ -0,0 +1,133 @@
+#include "BoardQueue.h"
+#include "Trace.h"
+#include "CounterRng.h"
+#include <assert.h>
+#include <algorithm>
+
+BoardQueue::BoardQueue( const Vei2& center,const std::vector<Preset>& presets,size_t depth,size_t budgetBytes )
+	:
+	center( center ),
+	presets( presets ),
+	pool( 1u )
+{
+	const size_t presetBudget = budgetBytes / std::max( presets.size(),size_t( 1u ) );
+	for( size_t p = 0u; p < presets.size(); p++ )
+	{
+		const size_t bytes = MemeField::GetArenaBytes( presets[p].width,presets[p].height );
+		// the board being played plus the ones waiting, just the one would leave nothing waiting
+		// for the next game
+		const size_t nSlots = std::min( presetBudget / bytes,depth + 1u );
+		if( nSlots < 2u )
+		{
+			continue;
+		}
+		for( size_t i = 0u; i < nSlots; i++ )
+		{
+			slots.push_back( std::make_unique<Slot>() );
+			slots.back()->preset = p;
+			slots.back()->arena.Reserve( bytes );
+		}
+	}
+	Refill();
+}
+
+BoardQueue::~BoardQueue()
+{
+	for( auto& pSlot : slots )
+	{
+		if( pSlot->state == Slot::State::Building )
+		{
+			pSlot->progress.Cancel();
+		}
+	}
+	// cancelled fields are half built, but they're all destroyed the same way
+	for( auto& pSlot : slots )
+	{
+		if( pSlot->state == Slot::State::Building )
+		{
+			MemeField* const pField = pSlot->building.get();
+			pField->~MemeField();
+		}
+		else
+		{
+			// a field still out being played is the game's problem, it has to be recycled first
+			assert( pSlot->state == Slot::State::Free );
+		}
+	}
+}
+
+MemeField* BoardQueue::Take( size_t preset )
+{
+	for( auto& pSlot : slots )
+	{
+		if( pSlot->preset == preset && IsReady( *pSlot ) )
+		{
+			pSlot->pField = pSlot->building.get();
+			pSlot->state = Slot::State::Taken;
+			return pSlot->pField;
+		}
+	}
+	return nullptr;
+}
+
+void BoardQueue::Recycle( MemeField* pField )
+{
+	const auto i = std::find_if( slots.begin(),slots.end(),[pField]( const std::unique_ptr<Slot>& pSlot )
+	{
+		return pSlot->pField == pField;
+	} );
+	assert( i != slots.end() && (*i)->state == Slot::State::Taken );
+	Slot& slot = **i;
+	slot.pField->~MemeField();
+	slot.pField = nullptr;
+	slot.arena.Reset();
+	slot.state = Slot::State::Free;
+	Refill();
+}
+
+size_t BoardQueue::GetReadyCount( size_t preset ) const
+{
+	return size_t( std::count_if( slots.begin(),slots.end(),[preset]( const std::unique_ptr<Slot>& pSlot )
+	{
+		return pSlot->preset == preset && IsReady( *pSlot );
+	} ) );
+}
+
+size_t BoardQueue::GetBytes() const
+{
+	size_t bytes = 0u;
+	for( const auto& pSlot : slots )
+	{
+		bytes += pSlot->arena.GetCapacity();
+	}
+	return bytes;
+}
+
+void BoardQueue::Refill()
+{
+	for( auto& pSlot : slots )
+	{
+		if( pSlot->state != Slot::State::Free )
+		{
+			continue;
+		}
+		Slot* const p = pSlot.get();
+		const Preset& preset = presets[p->preset];
+		const Vei2 pos = center;
+		const uint64_t seed = CounterRng::RandomSeed();
+		p->progress.Reset();
+		p->state = Slot::State::Building;
+		p->building = pool.Submit( [p,preset,pos,seed]()
+		{
+			CHILI_TRACE_ZONE( "BoardQueue build" );
+			return new( p->arena.Allocate<MemeField>( 1u ) )
+				MemeField( pos,preset.width,preset.height,preset.nMemes,seed,p->arena,&p->progress );
+		} );
+	}
+}
+
+bool BoardQueue::IsReady( const Slot& slot )
+{
+	return slot.state == Slot::State::Building &&
+		slot.building.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+}
\ No newline at end of file
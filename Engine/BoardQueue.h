@@ -0,0 +1,66 @@
+#pragma once
+
+#include "MemeField.h"
+#include "FieldArena.h"
+#include "ThreadPool.h"
+#include <future>
+#include <memory>
+#include <vector>
+
+// keeps a few boards of every preset built ahead on a worker thread, so starting a game is
+// taking one off the queue, however long generating a board takes
+// every board sits in an arena of its own, sized once up front: a preset gets as many boards
+// (up to the depth, plus the one being played) as fit its share of the memory budget, none
+// when not even one fits (the game builds those on the spot)
+class BoardQueue
+{
+public:
+	struct Preset
+	{
+		int width;
+		int height;
+		int nMemes;
+	};
+public:
+	BoardQueue( const Vei2& center,const std::vector<Preset>& presets,size_t depth,size_t budgetBytes );
+	BoardQueue( const BoardQueue& ) = delete;
+	BoardQueue& operator=( const BoardQueue& ) = delete;
+	// calls off the builds still running
+	~BoardQueue();
+	// a ready board of the preset, or nullptr when there's none ready yet
+	// the board stays the queue's, hand it back with Recycle when the game's over
+	MemeField* Take( size_t preset );
+	void Recycle( MemeField* pField );
+	// boards of the preset ready to go
+	size_t GetReadyCount( size_t preset ) const;
+	// what the arenas hold between them
+	size_t GetBytes() const;
+private:
+	struct Slot
+	{
+		enum class State
+		{
+			Free,
+			// ready to take once the future is
+			Building,
+			Taken
+		};
+		size_t preset;
+		State state = State::Free;
+		FieldArena arena;
+		MemeField::Progress progress;
+		std::future<MemeField*> building;
+		MemeField* pField = nullptr;
+	};
+private:
+	// starts builds into all free slots
+	void Refill();
+	static bool IsReady( const Slot& slot );
+private:
+	Vei2 center;
+	std::vector<Preset> presets;
+	// slots don't move (the worker builds into them), so they're each on the heap
+	std::vector<std::unique_ptr<Slot>> slots;
+	// one is enough to keep up with anyone clicking through games
+	ThreadPool pool;
+};
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "BoardSolver.h"
+#include <assert.h>
+#include <algorithm>
+
+void BoardSolver::Start( int width_in,int height_in,int nMemes )
+{
+	width = width_in;
+	height = height_in;
+	nMemesLeft = nMemes;
+	nHidden = width * height;
+	tiles.assign( size_t( width * height ),Knowledge::Hidden );
+	numbers.assign( size_t( width * height ),static_cast<signed char>( -1 ) );
+	queued.assign( size_t( width * height ),false );
+	dirty.clear();
+	safe.clear();
+	flags.clear();
+}
+
+void BoardSolver::OnRevealed( int tile,int nNeighborMemes )
+{
+	assert( tiles[tile] == Knowledge::Hidden || tiles[tile] == Knowledge::Safe );
+	if( tiles[tile] == Knowledge::Hidden )
+	{
+		nHidden--;
+	}
+	tiles[tile] = Knowledge::Revealed;
+	numbers[tile] = static_cast<signed char>( nNeighborMemes );
+	Queue( tile );
+	Touch( tile );
+}
+
+void BoardSolver::OnMeme( int tile )
+{
+	assert( tiles[tile] == Knowledge::Hidden );
+	tiles[tile] = Knowledge::Flagged;
+	nHidden--;
+	nMemesLeft--;
+	Touch( tile );
+}
+
+BoardSolver::Move BoardSolver::Next()
+{
+	while( true )
+	{
+		if( !flags.empty() )
+		{
+			const int tile = flags.back();
+			flags.pop_back();
+			return { Move::Type::Flag,tile,false };
+		}
+		while( !safe.empty() )
+		{
+			const int tile = safe.back();
+			safe.pop_back();
+			// a cascade may have opened it in the meantime
+			if( tiles[tile] == Knowledge::Safe )
+			{
+				return { Move::Type::Reveal,tile,false };
+			}
+		}
+		if( !dirty.empty() )
+		{
+			const int tile = dirty.back();
+			dirty.pop_back();
+			queued[tile] = false;
+			Deduce( tile );
+			continue;
+		}
+		if( nHidden == 0 )
+		{
+			return { Move::Type::Done,-1,false };
+		}
+		// no memes left means the rest is safe, as many memes as hidden tiles means they're all memes
+		if( nMemesLeft == 0 || nMemesLeft == nHidden )
+		{
+			const bool memes = nMemesLeft > 0;
+			for( int tile = 0; tile < width * height; tile++ )
+			{
+				if( tiles[tile] == Knowledge::Hidden )
+				{
+					if( memes )
+					{
+						MarkMeme( tile );
+					}
+					else
+					{
+						MarkSafe( tile );
+					}
+				}
+			}
+			continue;
+		}
+		return Guess();
+	}
+}
+
+bool BoardSolver::IsRevealed( int tile ) const
+{
+	return tiles[tile] == Knowledge::Revealed || tiles[tile] == Knowledge::Settled;
+}
+
+void BoardSolver::MarkSafe( int tile )
+{
+	tiles[tile] = Knowledge::Safe;
+	nHidden--;
+	safe.push_back( tile );
+	Touch( tile );
+}
+
+void BoardSolver::MarkMeme( int tile )
+{
+	tiles[tile] = Knowledge::Flagged;
+	nHidden--;
+	nMemesLeft--;
+	flags.push_back( tile );
+	Touch( tile );
+}
+
+void BoardSolver::Touch( int tile )
+{
+	int neighbors[8];
+	const int nNeighbors = GetNeighbors( tile,neighbors );
+	for( int k = 0; k < nNeighbors; k++ )
+	{
+		if( tiles[neighbors[k]] == Knowledge::Revealed )
+		{
+			Queue( neighbors[k] );
+		}
+	}
+}
+
+void BoardSolver::Queue( int tile )
+{
+	// a cascade touches most tiles from several sides, once in dirty is enough
+	if( !queued[tile] )
+	{
+		queued[tile] = true;
+		dirty.push_back( tile );
+	}
+}
+
+void BoardSolver::Deduce( int tile )
+{
+	int neighbors[8];
+	const int nNeighbors = GetNeighbors( tile,neighbors );
+	int nFlagged = 0;
+	int nHiddenAround = 0;
+	for( int k = 0; k < nNeighbors; k++ )
+	{
+		nFlagged += tiles[neighbors[k]] == Knowledge::Flagged ? 1 : 0;
+		nHiddenAround += tiles[neighbors[k]] == Knowledge::Hidden ? 1 : 0;
+	}
+	const int nMemesAround = numbers[tile] - nFlagged;
+	if( nMemesAround > 0 && nMemesAround < nHiddenAround )
+	{
+		return;
+	}
+	// whatever is hidden around it is about to be known, so touching and guessing can skip it
+	tiles[tile] = Knowledge::Settled;
+	for( int k = 0; k < nNeighbors; k++ )
+	{
+		if( tiles[neighbors[k]] == Knowledge::Hidden )
+		{
+			if( nMemesAround == 0 )
+			{
+				MarkSafe( neighbors[k] );
+			}
+			else
+			{
+				MarkMeme( neighbors[k] );
+			}
+		}
+	}
+}
+
+BoardSolver::Move BoardSolver::Guess()
+{
+	// a tile next to numbers is as risky as the worst of them says (memes still to find over
+	// hidden tiles around it), any other tile as the memes left over the hidden tiles left
+	const int nTiles = width * height;
+	risks.assign( size_t( nTiles ),-1.0f );
+	int neighbors[8];
+	for( int tile = 0; tile < nTiles; tile++ )
+	{
+		if( tiles[tile] != Knowledge::Revealed )
+		{
+			continue;
+		}
+		const int nNeighbors = GetNeighbors( tile,neighbors );
+		int nFlagged = 0;
+		int nHiddenAround = 0;
+		for( int k = 0; k < nNeighbors; k++ )
+		{
+			nFlagged += tiles[neighbors[k]] == Knowledge::Flagged ? 1 : 0;
+			nHiddenAround += tiles[neighbors[k]] == Knowledge::Hidden ? 1 : 0;
+		}
+		if( nHiddenAround == 0 )
+		{
+			continue;
+		}
+		const float risk = float( numbers[tile] - nFlagged ) / float( nHiddenAround );
+		for( int k = 0; k < nNeighbors; k++ )
+		{
+			if( tiles[neighbors[k]] == Knowledge::Hidden )
+			{
+				risks[neighbors[k]] = std::max( risks[neighbors[k]],risk );
+			}
+		}
+	}
+	// between tiles as risky, the one at a corner (or else an edge) has the fewest neighbors that
+	// could be memes, so it's the likeliest to open something up
+	const float density = float( nMemesLeft ) / float( nHidden );
+	int best = -1;
+	float bestRisk = 2.0f;
+	int bestSides = -1;
+	for( int tile = 0; tile < nTiles; tile++ )
+	{
+		if( tiles[tile] == Knowledge::Hidden )
+		{
+			const float risk = risks[tile] < 0.0f ? density : risks[tile];
+			if( risk <= bestRisk )
+			{
+				const int sides = GetSides( tile );
+				if( risk < bestRisk || sides > bestSides )
+				{
+					best = tile;
+					bestRisk = risk;
+					bestSides = sides;
+				}
+			}
+		}
+	}
+	assert( best >= 0 );
+	return { Move::Type::Reveal,best,true };
+}
+
+int BoardSolver::GetSides( int tile ) const
+{
+	const int x = tile % width;
+	const int y = tile / width;
+	return (x == 0 || x == width - 1 ? 1 : 0) + (y == 0 || y == height - 1 ? 1 : 0);
+}
+
+int BoardSolver::GetNeighbors( int tile,int* pNeighbors ) const
+{
+	const int x = tile % width;
+	const int y = tile / width;
+	const int xStart = std::max( 0,x - 1 );
+	const int yStart = std::max( 0,y - 1 );
+	const int xEnd = std::min( width - 1,x + 1 );
+	const int yEnd = std::min( height - 1,y + 1 );
+
+	int nNeighbors = 0;
+	for( int ny = yStart; ny <= yEnd; ny++ )
+	{
+		for( int nx = xStart; nx <= xEnd; nx++ )
+		{
+			if( nx != x || ny != y )
+			{
+				pNeighbors[nNeighbors++] = ny * width + nx;
+			}
+		}
+	}
+	return nNeighbors;
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+
+// plays a board knowing only what a player sees, the numbers on revealed tiles and its own flags
+// it deduces from one number at a time (all its memes flagged means the rest is safe, as many
+// hidden as memes left means they're all memes) and from the memes left on the board, and when
+// that runs dry it guesses the tile least likely to be a meme going by the numbers around it
+// the game (or whatever stands in for it) reports every tile a reveal opens, cascades included
+class BoardSolver
+{
+public:
+	struct Move
+	{
+		enum class Type
+		{
+			Reveal,
+			Flag,
+			// every meme flagged and every other tile revealed
+			Done
+		};
+		Type type;
+		int tile;
+		// nothing said it was safe
+		bool guess;
+	};
+public:
+	// a fresh board, the buffers grow to the biggest one seen and are reused after that
+	void Start( int width_in,int height_in,int nMemes );
+	void OnRevealed( int tile,int nNeighborMemes );
+	// a guess hit a meme, taken as flagged from then on (for playing a board out anyway)
+	void OnMeme( int tile );
+	// flags are taken as done when they're handed out
+	Move Next();
+	bool IsRevealed( int tile ) const;
+private:
+	enum class Knowledge : unsigned char
+	{
+		Hidden,
+		// known safe, the reveal is waiting in safe
+		Safe,
+		Flagged,
+		Revealed,
+		// revealed with nothing hidden around, nothing more to get out of it
+		Settled
+	};
+private:
+	void MarkSafe( int tile );
+	void MarkMeme( int tile );
+	// the revealed neighbors get looked at again
+	void Touch( int tile );
+	void Queue( int tile );
+	void Deduce( int tile );
+	Move Guess();
+	// the 8 (fewer at the edges) neighbors, returns how many
+	int GetNeighbors( int tile,int* pNeighbors ) const;
+	// how many edges of the board the tile is on, 2 for a corner
+	int GetSides( int tile ) const;
+private:
+	int width = 0;
+	int height = 0;
+	int nMemesLeft = 0;
+	int nHidden = 0;
+	std::vector<Knowledge> tiles;
+	std::vector<signed char> numbers;
+	// revealed tiles whose neighbors changed
+	std::vector<int> dirty;
+	std::vector<bool> queued;
+	std::vector<int> safe;
+	std::vector<int> flags;
+	// per tile while guessing
+	std::vector<float> risks;
+};
\ No newline at end of file
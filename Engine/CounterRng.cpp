@@ -0,0 +1,18 @@
+#include "CounterRng.h"
+#include <random>
+
+CounterRng::CounterRng( uint64_t seed )
+{
+	// splitmix64's finalizer, so neighboring seeds get unrelated keys, and odd, so the counter
+	// times the key never repeats
+	uint64_t z = seed + 0x9E3779B97F4A7C15u;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9u;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBu;
+	key = (z ^ (z >> 31)) | 1u;
+}
+
+uint64_t CounterRng::RandomSeed()
+{
+	std::random_device rd;
+	return (uint64_t( rd() ) << 32) | uint64_t( rd() );
+}
\ No newline at end of file
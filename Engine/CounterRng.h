@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// a counter-based random generator (squares, after Widynski): a value is a function of the key
+// and a counter only, so any tile or stripe of a board gets its numbers in O(1) without running
+// a generator through everything before it, and threads drawing in any order make the same board
+class CounterRng
+{
+public:
+	// any seed goes, it's mixed into a key with the kind of bit pattern squares needs
+	explicit CounterRng( uint64_t seed );
+	uint32_t operator()( uint64_t counter ) const
+	{
+		uint64_t x = counter * key;
+		const uint64_t y = x;
+		const uint64_t z = y + key;
+		x = x * x + y;
+		x = (x >> 32) | (x << 32);
+		x = x * x + z;
+		x = (x >> 32) | (x << 32);
+		x = x * x + y;
+		x = (x >> 32) | (x << 32);
+		return uint32_t( (x * x + z) >> 32 );
+	}
+	// 0 to n - 1 by multiply and shift, off from uniform by at most n / 2^32
+	uint32_t Below( uint64_t counter,uint32_t n ) const
+	{
+		return uint32_t( (uint64_t( (*this)( counter ) ) * n) >> 32 );
+	}
+	// the first counter of a stream of 2^32 values (a stripe, a chunk, ...)
+	static uint64_t StreamStart( uint32_t stream )
+	{
+		return uint64_t( stream ) << 32;
+	}
+	// for boards nobody asked to reproduce
+	static uint64_t RandomSeed();
+private:
+	uint64_t key;
+};
\ No newline at end of file
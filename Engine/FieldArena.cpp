@@ -0,0 +1,89 @@
+#include "FieldArena.h"
+#include <assert.h>
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace
+{
+	// blocks come in whole multiples of this, so boards of about the same size share one
+	constexpr size_t granularity = 64u * 1024u;
+
+	size_t AlignUp( size_t n,size_t alignment )
+	{
+		return (n + alignment - 1u) / alignment * alignment;
+	}
+}
+
+FieldArena::~FieldArena()
+{
+	Reset();
+	::operator delete( pBlock );
+}
+
+void* FieldArena::Allocate( size_t nBytes,size_t alignment )
+{
+	if( !pBlock && reserve > 0u )
+	{
+		capacity = AlignUp( reserve,granularity );
+		pBlock = static_cast<unsigned char*>( ::operator new( capacity ) );
+	}
+	const uintptr_t base = reinterpret_cast<uintptr_t>( pBlock );
+	const size_t offset = AlignUp( base + used,alignment ) - base;
+	if( pBlock && offset + nBytes <= capacity )
+	{
+		used = offset + nBytes;
+		return pBlock + offset;
+	}
+	// slack for the alignment, so the overflow is as big as it would be in the block
+	const size_t size = AlignUp( sizeof( Overflow ),alignment ) + nBytes + alignment;
+	Overflow* const pOverflow = static_cast<Overflow*>( ::operator new( size ) );
+	pOverflow->pNext = pOverflows;
+	pOverflow->size = size;
+	pOverflows = pOverflow;
+	overflowUsed += size;
+	const uintptr_t start = reinterpret_cast<uintptr_t>( pOverflow + 1 );
+	return reinterpret_cast<void*>( AlignUp( start,alignment ) );
+}
+
+void FieldArena::Reset()
+{
+	if( pOverflows )
+	{
+		reserve = std::max( reserve,used + overflowUsed );
+		while( pOverflows )
+		{
+			Overflow* const pNext = pOverflows->pNext;
+			::operator delete( pOverflows );
+			pOverflows = pNext;
+		}
+		overflowUsed = 0u;
+		// the next game gets a block that holds everything this one needed
+		::operator delete( pBlock );
+		pBlock = nullptr;
+		capacity = 0u;
+	}
+	used = 0u;
+}
+
+void FieldArena::Reserve( size_t nBytes )
+{
+	assert( used == 0u && !pOverflows );
+	if( capacity < nBytes )
+	{
+		::operator delete( pBlock );
+		pBlock = static_cast<unsigned char*>( ::operator new( nBytes ) );
+		capacity = nBytes;
+	}
+	reserve = std::max( reserve,nBytes );
+}
+
+size_t FieldArena::GetCapacity() const
+{
+	return capacity + overflowUsed;
+}
+
+size_t FieldArena::GetUsed() const
+{
+	return used + overflowUsed;
+}
\ No newline at end of file
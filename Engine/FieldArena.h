@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+// storage for one game at a time: the field, its tiles and whatever else a game needs,
+// handed out front to back and all taken back at once by Reset
+// the block stays across games (grown to the most one game needed), so a new game doesn't go
+// to the heap, or fault in and zero fresh pages, unless it needs more than any game before
+class FieldArena
+{
+public:
+	FieldArena() = default;
+	FieldArena( const FieldArena& ) = delete;
+	FieldArena& operator=( const FieldArena& ) = delete;
+	~FieldArena();
+	// uninitialized, valid until the next Reset
+	void* Allocate( size_t nBytes,size_t alignment );
+	template<typename T>
+	T* Allocate( size_t n )
+	{
+		return static_cast<T*>( Allocate( sizeof( T ) * n,alignof( T ) ) );
+	}
+	// takes back everything handed out (destroy what's in there first)
+	void Reset();
+	// makes the block hold at least nBytes right away (exactly that much if it has to grow),
+	// for sizing an arena up front, only while nothing is handed out
+	void Reserve( size_t nBytes );
+	// bytes held, and bytes handed out since the last reset
+	size_t GetCapacity() const;
+	size_t GetUsed() const;
+private:
+	// what didn't fit the block goes into blocks of its own until the next reset, which
+	// swaps the lot for one block big enough for all of it
+	struct Overflow
+	{
+		Overflow* pNext;
+		size_t size;
+	};
+private:
+	unsigned char* pBlock = nullptr;
+	size_t capacity = 0u;
+	size_t used = 0u;
+	Overflow* pOverflows = nullptr;
+	size_t overflowUsed = 0u;
+	// what the next block has to hold
+	size_t reserve = 0u;
+};
\ No newline at end of file
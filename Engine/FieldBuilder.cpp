@@ -0,0 +1,88 @@
+#include "FieldBuilder.h"
+#include "Trace.h"
+#include <assert.h>
+#include <algorithm>
+
+namespace
+{
+	// builds quicker than this never show the bar
+	constexpr std::chrono::milliseconds drawDelay( 100 );
+}
+
+FieldBuilder::FieldBuilder()
+	:
+	pool( ThreadPool::DefaultThreadCount() )
+{}
+
+FieldBuilder::~FieldBuilder()
+{
+	Cancel();
+	Collect();
+}
+
+void FieldBuilder::Start( FieldArena& arena,const Vei2& center,int width,int height,int nMemes,uint64_t seed )
+{
+	Collect();
+	assert( !building.valid() );
+	progress.Reset();
+	pArena = &arena;
+	start = std::chrono::steady_clock::now();
+	MemeField::Progress* const pProgress = &progress;
+	ThreadPool* const pPool = &pool;
+	building = pool.Submit( [pProgress,pPool,&arena,center,width,height,nMemes,seed]()
+	{
+		CHILI_TRACE_ZONE( "FieldBuilder build" );
+		return new( arena.Allocate<MemeField>( 1u ) )
+			MemeField( center,width,height,nMemes,seed,arena,pProgress,pPool );
+	} );
+}
+
+bool FieldBuilder::IsReady() const
+{
+	return !cancelled && building.valid() &&
+		building.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+}
+
+MemeField* FieldBuilder::Take()
+{
+	assert( IsReady() );
+	pArena = nullptr;
+	return building.get();
+}
+
+void FieldBuilder::Cancel()
+{
+	if( building.valid() )
+	{
+		progress.Cancel();
+		cancelled = true;
+	}
+}
+
+void FieldBuilder::Collect()
+{
+	if( !building.valid() )
+	{
+		return;
+	}
+	// only a cancelled build can be pending here, the game takes the others
+	assert( cancelled );
+	MemeField* const pField = building.get();
+	pField->~MemeField();
+	pArena->Reset();
+	pArena = nullptr;
+	cancelled = false;
+}
+
+void FieldBuilder::Draw( const Vei2& center,Graphics& gfx ) const
+{
+	if( !building.valid() || cancelled || std::chrono::steady_clock::now() - start < drawDelay )
+	{
+		return;
+	}
+	const RectI bar = RectI::FromCenter( center,barWidth / 2,barHeight / 2 );
+	gfx.DrawRect( bar.GetExpanded( barBorder ),Colors::Blue );
+	gfx.DrawRect( bar,Colors::Gray );
+	const int filled = std::min( int( progress.Get() * float( barWidth ) ),int( barWidth ) );
+	gfx.DrawRect( bar.left,bar.top,bar.left + filled,bar.bottom,Colors::LightGray );
+}
\ No newline at end of file
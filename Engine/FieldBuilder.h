@@ -0,0 +1,46 @@
+#pragma once
+
+#include "MemeField.h"
+#include "FieldArena.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <future>
+
+// builds fields on a worker thread, so a huge board doesn't freeze the window while its memes
+// are placed and counted
+// the field goes into the arena, which belongs to the builder until the field is taken
+// (or a cancelled one has been cleaned up, which the next Start or the destructor wait for)
+class FieldBuilder
+{
+public:
+	FieldBuilder();
+	FieldBuilder( const FieldBuilder& ) = delete;
+	FieldBuilder& operator=( const FieldBuilder& ) = delete;
+	// calls off a build still running
+	~FieldBuilder();
+	// the arena has to be reset and outlive the builder
+	void Start( FieldArena& arena,const Vei2& center,int width,int height,int nMemes,uint64_t seed );
+	// true once the field of the last Start is done (false again after Take, or when cancelled)
+	bool IsReady() const;
+	// the field once ready, destroy it and reset the arena when done with it
+	MemeField* Take();
+	// the worker stops at its next look at the progress and throws the field away
+	void Cancel();
+	// a bar under the center filling with the progress of the build, drawn only once a build
+	// has taken a moment, so the ones that finish right away don't flash it
+	void Draw( const Vei2& center,Graphics& gfx ) const;
+private:
+	// waits out a cancelled build and cleans up after it
+	void Collect();
+private:
+	static constexpr int barWidth = 200;
+	static constexpr int barHeight = 12;
+	static constexpr int barBorder = 2;
+	MemeField::Progress progress;
+	FieldArena* pArena = nullptr;
+	std::future<MemeField*> building;
+	bool cancelled = false;
+	std::chrono::steady_clock::time_point start;
+	// the build runs on one worker, the others help with the stripes of big boards
+	ThreadPool pool;
+};
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+// a queue in a fixed ring of capacity elements, so pushing and popping never allocates
+// (std::queue's deque takes a fresh block from the heap every few pushes)
+// pushing into a full queue drops the oldest element
+template<typename T,size_t capacity>
+class FixedQueue
+{
+public:
+	void Push( const T& value )
+	{
+		if( nElements == capacity )
+		{
+			Pop();
+		}
+		elements[(iFront + nElements) % capacity] = value;
+		nElements++;
+	}
+	void Pop()
+	{
+		iFront = (iFront + 1u) % capacity;
+		nElements--;
+	}
+	const T& Front() const
+	{
+		return elements[iFront];
+	}
+	bool IsEmpty() const
+	{
+		return nElements == 0u;
+	}
+	size_t GetSize() const
+	{
+		return nElements;
+	}
+	void Clear()
+	{
+		iFront = 0u;
+		nElements = 0u;
+	}
+private:
+	T elements[capacity];
+	size_t iFront = 0u;
+	size_t nElements = 0u;
+};
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+namespace
+{
+	const Color phaseColors[int( FrameProfiler::Phase::Count )] =
+	{
+		Colors::Gray,
+		Colors::Green,
+		Colors::Cyan,
+		Colors::Red
+	};
+	const char* const phaseNames[int( FrameProfiler::Phase::Count )] =
+	{
+		"BeginFrame",
+		"UpdateModel",
+		"ComposeFrame",
+		"EndFrame"
+	};
+}
+
+void FrameProfiler::StartFrame()
+{
+	std::fill( std::begin( current ),std::end( current ),int64_t( 0 ) );
+	lapStart = std::chrono::steady_clock::now();
+}
+
+void FrameProfiler::Lap( Phase p )
+{
+	const auto now = std::chrono::steady_clock::now();
+	current[int( p )] += std::chrono::duration_cast<std::chrono::nanoseconds>( now - lapStart ).count();
+	lapStart = now;
+}
+
+void FrameProfiler::EndFrame()
+{
+	std::copy( std::begin( current ),std::end( current ),frames[iNext] );
+	iNext = (iNext + 1u) % nFrames;
+	nRecorded = std::min( nRecorded + 1u,size_t( nFrames ) );
+}
+
+size_t FrameProfiler::GetFrameCount() const
+{
+	return nRecorded;
+}
+
+FrameProfiler::Stats FrameProfiler::GetStats( Phase p ) const
+{
+	return MakeStats( [this,p]( size_t frame )
+	{
+		return frames[frame][int( p )];
+	} );
+}
+
+FrameProfiler::Stats FrameProfiler::GetFrameStats() const
+{
+	return MakeStats( [this]( size_t frame )
+	{
+		return GetFrameTotal( frame );
+	} );
+}
+
+std::string FrameProfiler::GetReport() const
+{
+	std::string report = "Frame profile over " + std::to_string( nRecorded ) + " frames (ms)\n";
+	char line[96];
+	for( int p = 0; p <= int( Phase::Count ); p++ )
+	{
+		const Stats s = p < int( Phase::Count ) ? GetStats( Phase( p ) ) : GetFrameStats();
+		snprintf( line,sizeof( line ),"%-14s min %7.3f  avg %7.3f  p99 %7.3f\n",
+			p < int( Phase::Count ) ? phaseNames[p] : "Frame",s.min,s.avg,s.p99 );
+		report += line;
+	}
+	return report;
+}
+
+void FrameProfiler::Draw( Graphics& gfx ) const
+{
+	const int top = graphBottom - graphHeight;
+	const float pixelsPerNanosecond = float( graphHeight ) / (graphMilliseconds * 1e6f);
+	gfx.DrawRect( graphLeft - 1,top - 1,graphLeft + int( nFrames ) + 1,graphBottom + 1,Colors::Black );
+
+	for( size_t i = 0u; i < nRecorded; i++ )
+	{
+		const size_t frame = (iNext + nFrames - nRecorded + i) % nFrames;
+		const int x = graphLeft + int( i );
+		int y = graphBottom;
+		for( int p = 0; p < int( Phase::Count ) && y > top; p++ )
+		{
+			const int height = std::min( int( float( frames[frame][p] ) * pixelsPerNanosecond + 0.5f ),y - top );
+			gfx.DrawRect( x,y - height,x + 1,y,phaseColors[p] );
+			y -= height;
+		}
+	}
+
+	// 60Hz budget, then where the average and the slow frames are
+	const Stats s = GetFrameStats();
+	const auto DrawLevel = [&]( float milliseconds,Color c )
+	{
+		const int y = graphBottom - int( milliseconds * 1e6f * pixelsPerNanosecond + 0.5f );
+		if( y > top )
+		{
+			gfx.DrawRect( graphLeft,y,graphLeft + int( nFrames ),y + 1,c );
+		}
+	};
+	DrawLevel( 1000.0f / 60.0f,Colors::LightGray );
+	if( nRecorded > 0u )
+	{
+		DrawLevel( s.avg,Colors::White );
+		DrawLevel( s.p99,Colors::Yellow );
+	}
+}
+
+int64_t FrameProfiler::GetFrameTotal( size_t frame ) const
+{
+	int64_t total = 0;
+	for( int p = 0; p < int( Phase::Count ); p++ )
+	{
+		total += frames[frame][p];
+	}
+	return total;
+}
+
+template<typename F>
+FrameProfiler::Stats FrameProfiler::MakeStats( F getNanoseconds ) const
+{
+	if( nRecorded == 0u )
+	{
+		return { 0.0f,0.0f,0.0f };
+	}
+	// the ring order doesn't matter for these, only which slots are filled
+	std::array<int64_t,nFrames> times;
+	int64_t sum = 0;
+	for( size_t i = 0u; i < nRecorded; i++ )
+	{
+		times[i] = getNanoseconds( i );
+		sum += times[i];
+	}
+	const auto end = times.begin() + nRecorded;
+	const int64_t min = *std::min_element( times.begin(),end );
+	// nearest rank
+	const auto p99 = times.begin() + (nRecorded * 99u + 99u) / 100u - 1u;
+	std::nth_element( times.begin(),p99,end );
+	return { float( min ) / 1e6f,float( sum ) / float( nRecorded ) / 1e6f,float( *p99 ) / 1e6f };
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Graphics.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// times the phases of Game::Go for the last nFrames frames
+// everything lives in fixed arrays, so profiling a frame never allocates
+class FrameProfiler
+{
+public:
+	enum class Phase
+	{
+		BeginFrame,
+		UpdateModel,
+		ComposeFrame,
+		EndFrame,
+		Count
+	};
+	// milliseconds over the frames in the ring
+	struct Stats
+	{
+		float min;
+		float avg;
+		float p99;
+	};
+	static constexpr size_t nFrames = 256u;
+public:
+	// call at the start of the frame, then Lap after each phase in order
+	void StartFrame();
+	// time since the previous lap (or the frame start) goes to phase p
+	void Lap( Phase p );
+	// commits the frame to the ring
+	void EndFrame();
+	size_t GetFrameCount() const;
+	Stats GetStats( Phase p ) const;
+	// all phases together
+	Stats GetFrameStats() const;
+	// min/avg/p99 of every phase, one line each (allocates, so not every frame)
+	std::string GetReport() const;
+	// stacked bar per frame (oldest on the left) with the frame time avg and p99 as lines
+	void Draw( Graphics& gfx ) const;
+private:
+	int64_t GetFrameTotal( size_t frame ) const;
+	template<typename F>
+	Stats MakeStats( F getNanoseconds ) const;
+private:
+	std::chrono::steady_clock::time_point lapStart;
+	int64_t current[int( Phase::Count )] = {};
+	int64_t frames[nFrames][int( Phase::Count )] = {};
+	// next slot to write, and how many slots hold frames
+	size_t iNext = 0u;
+	size_t nRecorded = 0u;
+	// overlay layout, 1 pixel column per frame
+	static constexpr int graphLeft = 8;
+	static constexpr int graphBottom = Graphics::ScreenHeight - 8;
+	static constexpr int graphHeight = 100;
+	// full graph height is 2 frames at 60Hz
+	static constexpr float graphMilliseconds = 33.3f;
+};
\ No newline at end of file
@@ -21,31 +21,118 @@
 #include "MainWindow.h"
 #include "Game.h"
 #include "SpriteCodex.h"
+#include "StartupProfiler.h"
+#include "HotCounters.h"
+#include "Trace.h"
+#include "AllocTracker.h"
+#include "CounterRng.h"
 #include <assert.h>
 
+namespace
+{
+	// the menu sizes, in SelectionMenu::Size order
+	const BoardQueue::Preset presets[] =
+	{
+		{ 8,4,5 },
+		{ 14,7,15 },
+		{ 24,16,45 }
+	};
+}
+
 Game::Game( MainWindow& wnd )
 	:
 	wnd( wnd ),
 	gfx( wnd ),
-	menu( { gfx.GetRect().GetCenter().x,200 } )
+	// one file mapping for everything, without a pack the loose files and built-in sprites are used
+	pack( AssetPack::OpenIfPresent( L"assets.pak" ) ),
+	boardQueue( gfx.GetRect().GetCenter(),std::vector<BoardQueue::Preset>( std::begin( presets ),std::end( presets ) ),
+		size_t( boardQueueDepth ),size_t( boardQueueBudget ) ),
+	menu( { gfx.GetRect().GetCenter().x,200 } ),
+	hoverLoading( loader.LoadSound( pack,"menu_boop.wav" ) ),
+	loseLoading( loader.LoadSound( pack,"spayed.wav" ) )
 {
+	SpriteCodex::UsePack( &pack );
+	Trace::SetThreadName( "game" );
 }
 
 Game::~Game()
 {
+	SpriteCodex::UsePack( nullptr );
 	DestroyField();
 }
 
 void Game::Go()
 {
+	CHILI_TRACE_ZONE( "Frame" );
+	frameProfiler.StartFrame();
 	gfx.BeginFrame();	
+	frameProfiler.Lap( FrameProfiler::Phase::BeginFrame );
 	UpdateModel();
+	frameProfiler.Lap( FrameProfiler::Phase::UpdateModel );
 	ComposeFrame();
-	gfx.EndFrame();
+	frameProfiler.Lap( FrameProfiler::Phase::ComposeFrame );
+	{
+		CHILI_ALLOC_SCOPE( Present );
+		gfx.EndFrame();
+	}
+	frameProfiler.Lap( FrameProfiler::Phase::EndFrame );
+	frameProfiler.EndFrame();
+	HotCounters::EndFrame();
+	AllocTracker::EndFrame();
+	if( !firstFrameDone )
+	{
+		firstFrameDone = true;
+		ReportTime( "first frame" );
+	}
+	CheckAllocations();
 }
 
 void Game::UpdateModel()
 {
+	CHILI_TRACE_ZONE( "UpdateModel" );
+	CHILI_ALLOC_SCOPE( Update );
+	CollectAssets();
+	while( !wnd.kbd.KeyIsEmpty() )
+	{
+		const auto e = wnd.kbd.ReadKey();
+		if( e.IsPress() && e.GetCode() == countersKey )
+		{
+			frameMayAllocate = true;
+			HotCounters::WriteCsv( L"hot_counters.csv" );
+			AllocTracker::WriteCsv( L"allocations.csv" );
+		}
+		else if( e.IsPress() && e.GetCode() == traceKey )
+		{
+			frameMayAllocate = true;
+			if( Trace::IsCapturing() )
+			{
+				Trace::StopAndWrite( L"trace.json" );
+			}
+			else
+			{
+				Trace::Start();
+			}
+		}
+		else if( e.IsPress() && e.GetCode() == cancelKey && state == State::Generating )
+		{
+			fieldBuilder.Cancel();
+			state = State::SelectionMenu;
+		}
+		else if( e.IsPress() && e.GetCode() == frameGraphKey )
+		{
+			frameMayAllocate = true;
+			showFrameGraph = !showFrameGraph;
+			if( showFrameGraph )
+			{
+				OutputDebugStringA( frameProfiler.GetReport().c_str() );
+			}
+		}
+	}
+	if( state == State::Generating && fieldBuilder.IsReady() )
+	{
+		pField = fieldBuilder.Take();
+		state = State::Memesweeper;
+	}
 	while( !wnd.mouse.IsEmpty() )
 	{
 		const auto e = wnd.mouse.Read();
@@ -59,6 +146,10 @@ void Game::UpdateModel()
 					if( pField->GetRect().Contains( mousePos ) )
 					{
 						pField->OnRevealClick( mousePos );
+						if( pField->GetState() == MemeField::State::Fucked )
+						{
+							sndLose.Play();
+						}
 					}
 				}
 				else if( e.GetType() == Mouse::Event::Type::RPress )
@@ -79,42 +170,116 @@ void Game::UpdateModel()
 				}
 			}
 		}
-		else
+		else if( state == State::SelectionMenu )
 		{
 			const SelectionMenu::Size s = menu.ProcessMouse( e );
-			switch( s )
+			if( s != SelectionMenu::Size::Invalid )
 			{
-			case SelectionMenu::Size::Small:
-				CreateField( 8,4,5 );
-				state = State::Memesweeper;
-				break;
-			case SelectionMenu::Size::Medium:
-				CreateField( 14,7,15 );
-				state = State::Memesweeper;
-				break;
-			case SelectionMenu::Size::Large:
-				CreateField( 24,16,45 );
-				state = State::Memesweeper;
-				break;
+				CreateField( s );
 			}
 		}
 	}
 }
 
-void Game::CreateField( int width,int height,int nMemes )
+void Game::CreateField( SelectionMenu::Size size )
 {
 	assert( pField == nullptr );
-	pField = new MemeField( gfx.GetRect().GetCenter(),width,height,nMemes );
+	pField = boardQueue.Take( size_t( size ) );
+	if( pField )
+	{
+		fieldFromQueue = true;
+		state = State::Memesweeper;
+	}
+	else
+	{
+		// none ready (or the size is too big to keep around), so this one's built while we wait
+		// handing the build to the worker allocates (the field itself only when this board needs
+		// more than any game before, on the worker)
+		frameMayAllocate = true;
+		const BoardQueue::Preset& p = presets[int( size )];
+		fieldBuilder.Start( fieldArena,gfx.GetRect().GetCenter(),p.width,p.height,p.nMemes,CounterRng::RandomSeed() );
+		state = State::Generating;
+	}
 }
 
 void Game::DestroyField()
 {
-	delete pField;
-	pField = nullptr;
+	// a field still building belongs to the builder, arena and all
+	if( pField && fieldFromQueue )
+	{
+		// the queue starts building the next board into its slot right away, which allocates
+		frameMayAllocate = true;
+		boardQueue.Recycle( pField );
+		pField = nullptr;
+		fieldFromQueue = false;
+	}
+	else if( pField )
+	{
+		pField->~MemeField();
+		pField = nullptr;
+		fieldArena.Reset();
+	}
+}
+
+void Game::CollectAssets()
+{
+	// assets show up whenever the loader gets them done, the game runs fine without them
+	if( AssetLoader::IsReady( hoverLoading ) )
+	{
+		frameMayAllocate = true;
+		menu.SetHoverSound( hoverLoading.get() );
+	}
+	if( AssetLoader::IsReady( loseLoading ) )
+	{
+		frameMayAllocate = true;
+		sndLose = loseLoading.get();
+		// losing has to be heard no matter how much else is going on
+		sndLose.SetPriority( Sound::Priority::Critical );
+	}
+	if( !hoverLoading.valid() && !loseLoading.valid() && !assetsReported )
+	{
+		assetsReported = true;
+		frameMayAllocate = true;
+		ReportTime( "all assets resident" );
+		// that's the end of startup, the whole breakdown is available on request
+		if( wnd.GetArgs().find( L"--startup-profile" ) != std::wstring::npos )
+		{
+			StartupProfiler::Print();
+			StartupProfiler::WriteJson( L"startup_profile.json" );
+		}
+	}
+}
+
+void Game::ReportTime( const std::string& what ) const
+{
+	StartupProfiler::Mark( what );
+	const double ms = StartupProfiler::Now() / 1e6;
+	OutputDebugStringA( ("Memesweeper: " + what + " at " + std::to_string( ms ) + " ms since launch\n").c_str() );
+}
+
+void Game::CheckAllocations()
+{
+#if CHILI_ALLOC_STRICT
+	// everything the game thread allocated since the end of the last frame, so the message pump too
+	if( !frameMayAllocate && nFramesDone >= nWarmupFrames && AllocTracker::GetThreadAllocs() != nAllocsAtFrameEnd )
+	{
+		OutputDebugStringA( ("Memesweeper: a steady-state frame allocated\n" + AllocTracker::GetLastFrameReport()).c_str() );
+		assert( false && "steady-state frame allocated" );
+	}
+	// after the report, which allocates itself
+	nAllocsAtFrameEnd = AllocTracker::GetThreadAllocs();
+#endif
+	frameMayAllocate = false;
+	if( nFramesDone < nWarmupFrames )
+	{
+		nFramesDone++;
+	}
 }
 
 void Game::ComposeFrame()
 {
+	CHILI_TRACE_ZONE( "ComposeFrame" );
+	CHILI_ALLOC_SCOPE( Compose );
 	if( state == State::Memesweeper )
 	{
 		pField->Draw( gfx );
@@ -126,5 +291,14 @@ void Game::ComposeFrame()
 	else
 	{
 		menu.Draw( gfx );
+		if( state == State::Generating )
+		{
+			fieldBuilder.Draw( gfx.GetRect().GetCenter(),gfx );
+		}
+	}
+	// last so it's on top (its own drawing counts toward ComposeFrame)
+	if( showFrameGraph )
+	{
+		frameProfiler.Draw( gfx );
 	}
 }
@@ -25,6 +25,12 @@
 #include "Graphics.h"
 #include "MemeField.h"
 #include "SelectionMenu.h"
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "FrameProfiler.h"
+#include "FieldBuilder.h"
+#include "BoardQueue.h"
+#include <future>
 
 class Game
 {
@@ -32,6 +38,8 @@ private:
 	enum class State
 	{
 		SelectionMenu,
+		// the field is being built, the menu stays up under a progress bar
+		Generating,
 		Memesweeper
 	};
 public:
@@ -45,16 +53,53 @@ private:
 	void UpdateModel();
 	/********************************/
 	/*  User Functions              */
-	void CreateField( int width,int height,int nMemes );
+	void CreateField( SelectionMenu::Size size );
 	void DestroyField();
+	void CollectAssets();
+	void ReportTime( const std::string& what ) const;
+	void CheckAllocations();
 	/********************************/
 private:
 	MainWindow& wnd;
 	Graphics gfx;
 	/********************************/
 	/*  User Variables              */
+	// first so it outlives everything that plays or draws out of it
+	AssetPack pack;
+	// the field lives in here, so a new game reuses the last one's memory
+	FieldArena fieldArena;
 	MemeField* pField = nullptr;
+	// after the arena, it may still be cleaning up a cancelled field in there
+	FieldBuilder fieldBuilder;
+	// boards of every menu size built ahead, pField is one of these when fieldFromQueue
+	static constexpr size_t boardQueueDepth = 2u;
+	static constexpr size_t boardQueueBudget = 16u * 1024u * 1024u;
+	BoardQueue boardQueue;
+	bool fieldFromQueue = false;
 	SelectionMenu menu;
 	State state = State::SelectionMenu;
+	AssetLoader loader;
+	std::future<Sound> hoverLoading;
+	std::future<Sound> loseLoading;
+	Sound sndLose;
+	bool firstFrameDone = false;
+	bool assetsReported = false;
+	FrameProfiler frameProfiler;
+	// backs out of a board that's still being built
+	static constexpr unsigned char cancelKey = VK_ESCAPE;
+	// F3 toggles the frame time graph, and dumps the phase stats to the debug output when it comes on
+	static constexpr unsigned char frameGraphKey = VK_F3;
+	bool showFrameGraph = false;
+	// F4 writes the per-frame hot path counters and heap allocations of the last 1024 frames
+	static constexpr unsigned char countersKey = VK_F4;
+	// F5 starts a trace capture, pressing it again writes it to trace.json
+	static constexpr unsigned char traceKey = VK_F5;
+	// set by whatever may allocate this frame (a field bigger than before, loaded assets arriving, the debug keys),
+	// every other frame past the warm-up has to get by without the heap (asserted with CHILI_ALLOC_STRICT)
+	bool frameMayAllocate = true;
+	static constexpr int nWarmupFrames = 2;
+	int nFramesDone = 0;
+	// what the game thread had allocated at the end of the last frame
+	uint64_t nAllocsAtFrameEnd = 0u;
 	/********************************/
 };
\ No newline at end of file
@@ -22,9 +22,17 @@
 #include "Graphics.h"
 #include "DXErr.h"
 #include "ChiliException.h"
+#include "StartupProfiler.h"
+#include "Trace.h"
 #include <assert.h>
 #include <string>
 #include <array>
+#include <algorithm>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#define CHILI_GFX_SSE2
+#include <emmintrin.h>
+#endif
 
 // Ignore the intellisense error "cannot open source file" for .shh files.
 // They will be created during the build sequence before the preprocessor runs.
@@ -43,6 +51,8 @@ using Microsoft::WRL::ComPtr;
 Graphics::Graphics( HWNDKey& key )
 {
 	assert( key.hWnd != nullptr );
+	StartupProfiler::Phase phase( "graphics" );
+	StartupProfiler::Phase devicePhase( "device and swap chain" );
 
 	//////////////////////////////////////////////////////
 	// create device and swap chain/get render target view
@@ -118,6 +128,8 @@ Graphics::Graphics( HWNDKey& key )
 	vp.TopLeftX = 0.0f;
 	vp.TopLeftY = 0.0f;
 	pImmediateContext->RSSetViewports( 1,&vp );
+	devicePhase.End();
+	StartupProfiler::Phase texturePhase( "sysbuffer texture" );
 
 
 	///////////////////////////////////////
@@ -150,6 +162,8 @@ Graphics::Graphics( HWNDKey& key )
 	{
 		throw CHILI_GFX_EXCEPTION( hr,L"Creating view on sysBuffer texture" );
 	}
+	texturePhase.End();
+	StartupProfiler::Phase shaderPhase( "shaders and quad" );
 
 
 	////////////////////////////////////////////////
@@ -240,6 +254,12 @@ Graphics::Graphics( HWNDKey& key )
 		_aligned_malloc( sizeof( Color ) * Graphics::ScreenWidth * Graphics::ScreenHeight,16u ) );
 }
 
+Graphics::Graphics( Headless )
+{
+	pSysBuffer = reinterpret_cast<Color*>(
+		_aligned_malloc( sizeof( Color ) * Graphics::ScreenWidth * Graphics::ScreenHeight,16u ) );
+}
+
 Graphics::~Graphics()
 {
 	// free sysbuffer memory (aligned free)
@@ -254,8 +274,19 @@ Graphics::~Graphics()
 
 void Graphics::EndFrame()
 {
+	CHILI_TRACE_ZONE( "Graphics::EndFrame" );
 	HRESULT hr;
 
+	CHILI_HOT_COUNT( PixelsWritten,nPixelsWritten );
+#if CHILI_HOT_COUNTERS
+	nPixelsWritten = 0u;
+#endif
+	if( !pImmediateContext )
+	{
+		// headless
+		return;
+	}
+
 	// lock and map the adapter memory for copying over the sysbuffer
 	if( FAILED( hr = pImmediateContext->Map( pSysBufferTexture.Get(),0u,
 		D3D11_MAP_WRITE_DISCARD,0u,&mappedSysBufferTexture ) ) )
@@ -307,6 +338,11 @@ void Graphics::BeginFrame()
 	memset( pSysBuffer,0u,sizeof( Color ) * Graphics::ScreenHeight * Graphics::ScreenWidth );
 }
 
+const Color* Graphics::GetSysBuffer() const
+{
+	return pSysBuffer;
+}
+
 RectI Graphics::GetRect() const
 {
 	return RectI( 0,ScreenWidth,0,ScreenHeight );
@@ -318,6 +354,9 @@ void Graphics::PutPixel( int x,int y,Color c )
 	assert( x < int( Graphics::ScreenWidth ) );
 	assert( y >= 0 );
 	assert( y < int( Graphics::ScreenHeight ) );
+#if CHILI_HOT_COUNTERS
+	nPixelsWritten++;
+#endif
 	pSysBuffer[Graphics::ScreenWidth * y + x] = c;
 }
 
@@ -332,6 +371,44 @@ void Graphics::DrawRect( int x0,int y0,int x1,int y1,Color c )
 	}
 }
 
+void Graphics::DrawSprite( int x,int y,const SpriteView& sprite,Color chroma )
+{
+	const int xStart = std::max( x,0 );
+	const int yStart = std::max( y,0 );
+	const int xEnd = std::min( x + sprite.width,int( Graphics::ScreenWidth ) );
+	const int yEnd = std::min( y + sprite.height,int( Graphics::ScreenHeight ) );
+	const int nCols = xEnd - xStart;
+#if CHILI_HOT_COUNTERS
+	nPixelsWritten += uint64_t( std::max( nCols,0 ) ) * uint64_t( std::max( yEnd - yStart,0 ) );
+#endif
+#ifdef CHILI_GFX_SSE2
+	const __m128i vChroma = _mm_set1_epi32( int( chroma.dword ) );
+#endif
+	for( int sy = yStart; sy < yEnd; sy++ )
+	{
+		const Color* const pSrc = &sprite.pPixels[(sy - y) * sprite.width + (xStart - x)];
+		Color* const pDst = &pSysBuffer[Graphics::ScreenWidth * sy + xStart];
+		int i = 0;
+#ifdef CHILI_GFX_SSE2
+		// 4 pixels at a time, keep the destination where the source is the chroma color
+		for( ; i + 4 <= nCols; i += 4 )
+		{
+			const __m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &pSrc[i] ) );
+			const __m128i dst = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &pDst[i] ) );
+			const __m128i keep = _mm_cmpeq_epi32( src,vChroma );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( &pDst[i] ),
+				_mm_or_si128( _mm_and_si128( keep,dst ),_mm_andnot_si128( keep,src ) ) );
+		}
+#endif
+		for( ; i < nCols; i++ )
+		{
+			if( pSrc[i].dword != chroma.dword )
+			{
+				pDst[i] = pSrc[i];
+			}
+		}
+	}
+}
 
 //////////////////////////////////////////////////
 //           Graphics Exception
@@ -25,6 +25,8 @@
 #include "ChiliException.h"
 #include "Colors.h"
 #include "RectI.h"
+#include "SpriteView.h"
+#include "HotCounters.h"
 
 class Graphics
 {
@@ -47,8 +49,12 @@ private:
 		float x,y,z;		// position
 		float u,v;			// texcoords
 	};
+public:
+	// tag for a sysbuffer without device or window (for benchmarks), EndFrame presents nothing
+	struct Headless {};
 public:
 	Graphics( class HWNDKey& key );
+	Graphics( Headless );
 	Graphics( const Graphics& ) = delete;
 	Graphics& operator=( const Graphics& ) = delete;
 	void EndFrame();
@@ -64,6 +70,10 @@ public:
 	{
 		DrawRect( rect.left,rect.top,rect.right,rect.bottom,c );
 	}
+	// top left at (x,y) (the origin is ignored), clipped to the screen, pixels matching chroma are left alone
+	void DrawSprite( int x,int y,const SpriteView& sprite,Color chroma = Colors::Magenta );
+	// what has been drawn this frame, row by row
+	const Color* GetSysBuffer() const;
 	~Graphics();
 private:
 	Microsoft::WRL::ComPtr<IDXGISwapChain>				pSwapChain;
@@ -79,6 +89,10 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11SamplerState>			pSamplerState;
 	D3D11_MAPPED_SUBRESOURCE							mappedSysBufferTexture;
 	Color*                                              pSysBuffer = nullptr;
+#if CHILI_HOT_COUNTERS
+	// handed to HotCounters once a frame, going through the thread local slots for every pixel costs too much
+	uint64_t                                            nPixelsWritten = 0u;
+#endif
 public:
 	static constexpr int ScreenWidth = 800;
 	static constexpr int ScreenHeight = 600;
@@ -0,0 +1,129 @@
+#include "HotCounters.h"
+#include "WideFile.h"
+#include <fstream>
+#include <mutex>
+
+namespace
+{
+	constexpr int nCounters = int( HotCounters::Counter::Count );
+	const char* const names[nCounters] =
+	{
+		"pixels_written",
+		"tiles_drawn",
+		"tiles_revealed",
+		"reveal_cascades",
+		"voices_started"
+	};
+	// guards everything below and the thread list, taken when threads come and go and once a frame
+	std::mutex mutex;
+	// what exited threads counted, and the sums at the last frame end
+	uint64_t retired[nCounters] = {};
+	uint64_t lastTotals[nCounters] = {};
+	// ring of per-frame counts
+	uint64_t frames[HotCounters::nFrames][nCounters] = {};
+	uint64_t frameNumbers[HotCounters::nFrames] = {};
+	uint64_t nextFrameNumber = 0u;
+	size_t iNext = 0u;
+	size_t nRecorded = 0u;
+	uint64_t lastFrame[nCounters] = {};
+}
+
+HotCounters::ThreadSlots* HotCounters::pThreads = nullptr;
+
+HotCounters::ThreadSlots::ThreadSlots()
+{
+	for( auto& c : counts )
+	{
+		c.store( 0u,std::memory_order_relaxed );
+	}
+	std::lock_guard<std::mutex> lock( mutex );
+	pNext = pThreads;
+	pThreads = this;
+}
+
+HotCounters::ThreadSlots::~ThreadSlots()
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	for( int i = 0; i < nCounters; i++ )
+	{
+		retired[i] += counts[i].load( std::memory_order_relaxed );
+	}
+	for( ThreadSlots** ppSlots = &pThreads; *ppSlots; ppSlots = &(*ppSlots)->pNext )
+	{
+		if( *ppSlots == this )
+		{
+			*ppSlots = pNext;
+			break;
+		}
+	}
+}
+
+void HotCounters::EndFrame()
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	uint64_t totals[nCounters];
+	for( int i = 0; i < nCounters; i++ )
+	{
+		totals[i] = retired[i];
+	}
+	for( const ThreadSlots* pSlots = pThreads; pSlots; pSlots = pSlots->pNext )
+	{
+		for( int i = 0; i < nCounters; i++ )
+		{
+			totals[i] += pSlots->counts[i].load( std::memory_order_relaxed );
+		}
+	}
+	for( int i = 0; i < nCounters; i++ )
+	{
+		lastFrame[i] = totals[i] - lastTotals[i];
+		lastTotals[i] = totals[i];
+		frames[iNext][i] = lastFrame[i];
+	}
+	frameNumbers[iNext] = nextFrameNumber++;
+	iNext = (iNext + 1u) % nFrames;
+	if( nRecorded < nFrames )
+	{
+		nRecorded++;
+	}
+}
+
+uint64_t HotCounters::GetLastFrame( Counter c )
+{
+	std::lock_guard<std::mutex> lock( mutex );
+	return lastFrame[int( c )];
+}
+
+std::string HotCounters::GetCsv()
+{
+	std::string csv = "frame";
+	for( const char* name : names )
+	{
+		csv += std::string( "," ) + name;
+	}
+	csv += "\n";
+	std::lock_guard<std::mutex> lock( mutex );
+	for( size_t i = 0u; i < nRecorded; i++ )
+	{
+		const size_t frame = (iNext + nFrames - nRecorded + i) % nFrames;
+		csv += std::to_string( frameNumbers[frame] );
+		for( int c = 0; c < nCounters; c++ )
+		{
+			csv += "," + std::to_string( frames[frame][c] );
+		}
+		csv += "\n";
+	}
+	return csv;
+}
+
+bool HotCounters::WriteCsv( const std::wstring& fileName )
+{
+	std::ofstream file;
+	OpenWideFile( file,fileName,std::ios::binary );
+	file << GetCsv();
+	return bool( file );
+}
+
+const char* HotCounters::GetName( Counter c )
+{
+	return names[int( c )];
+}
\ No newline at end of file
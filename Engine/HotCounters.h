@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// build with CHILI_HOT_COUNTERS=0 to compile every count out (arguments aren't even evaluated)
+#ifndef CHILI_HOT_COUNTERS
+#define CHILI_HOT_COUNTERS 1
+#endif
+
+#if CHILI_HOT_COUNTERS
+#define CHILI_HOT_COUNT( counter,n ) HotCounters::Add( HotCounters::Counter::counter,uint64_t( n ) )
+#else
+#define CHILI_HOT_COUNT( counter,n ) ((void)0)
+#endif
+
+// cheap always-on counts of the work done on the hot paths, as per-frame time series
+// every thread counts into its own slots (a plain load and store, no locked instructions),
+// once a frame EndFrame sums the slots of all threads and stores the difference to last frame
+class HotCounters
+{
+public:
+	enum class Counter
+	{
+		// PutPixel (so DrawRect too) plus the area DrawSprite blits
+		PixelsWritten,
+		TilesDrawn,
+		// tiles opened by reveal clicks, and how many clicks did it
+		TilesRevealed,
+		RevealCascades,
+		VoicesStarted,
+		Count
+	};
+	// frames kept for the time series
+	static constexpr size_t nFrames = 1024u;
+public:
+	static void Add( Counter c,uint64_t n );
+	// call once at the end of every frame
+	static void EndFrame();
+	// counts of the last completed frame
+	static uint64_t GetLastFrame( Counter c );
+	// frame number then a column per counter, oldest frame first
+	static std::string GetCsv();
+	static bool WriteCsv( const std::wstring& fileName );
+	static const char* GetName( Counter c );
+private:
+	struct ThreadSlots
+	{
+		ThreadSlots();
+		~ThreadSlots();
+		// only the owning thread writes, EndFrame reads from the game thread
+		std::atomic<uint64_t> counts[int( Counter::Count )];
+		ThreadSlots* pNext = nullptr;
+	};
+	// slots of all live threads
+	static ThreadSlots* pThreads;
+	static ThreadSlots& GetThreadSlots()
+	{
+		thread_local ThreadSlots slots;
+		return slots;
+	}
+};
+
+inline void HotCounters::Add( Counter c,uint64_t n )
+{
+	std::atomic<uint64_t>& slot = GetThreadSlots().counts[int( c )];
+	slot.store( slot.load( std::memory_order_relaxed ) + n,std::memory_order_relaxed );
+}
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "ImaAdpcm.h"
+#include <assert.h>
+#include <algorithm>
+#include <cstring>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#define CHILI_ADPCM_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const int16_t stepTable[89] =
+	{
+		7,8,9,10,11,12,13,14,16,17,
+		19,21,23,25,28,31,34,37,41,45,
+		50,55,60,66,73,80,88,97,107,118,
+		130,143,157,173,190,209,230,253,279,307,
+		337,371,408,449,494,544,598,658,724,796,
+		876,963,1060,1166,1282,1411,1552,1707,1878,2066,
+		2272,2499,2749,3024,3327,3660,4026,4428,4871,5358,
+		5894,6484,7132,7845,8630,9493,10442,11487,12635,13899,
+		15289,16818,18500,20350,22385,24623,27086,29794,32767
+	};
+	const int indexTable[8] = { -1,-1,-1,-1,2,4,6,8 };
+	constexpr int maxStepIndex = 88;
+
+	int16_t ReadInt16( const unsigned char* p )
+	{
+		return int16_t( uint16_t( p[0] ) | uint16_t( p[1] ) << 8 );
+	}
+}
+
+bool ImaAdpcm::MakeLayout( unsigned int nChannels,size_t blockAlign,size_t framesPerBlock,Layout& layout )
+{
+	if( nChannels < 1u || nChannels > 2u )
+	{
+		return false;
+	}
+	// header is 4 bytes per channel, the rest comes in 4 byte (8 sample) groups per channel
+	const size_t headerSize = 4u * nChannels;
+	if( blockAlign <= headerSize || (blockAlign - headerSize) % headerSize != 0u )
+	{
+		return false;
+	}
+	const size_t maxFrames = (blockAlign - headerSize) / headerSize * 8u + 1u;
+	if( framesPerBlock == 0u )
+	{
+		framesPerBlock = maxFrames;
+	}
+	if( framesPerBlock > maxFrames || (framesPerBlock - 1u) % 8u != 0u )
+	{
+		return false;
+	}
+	layout.nChannels = nChannels;
+	layout.blockAlign = blockAlign;
+	layout.framesPerBlock = framesPerBlock;
+	return true;
+}
+
+size_t ImaAdpcm::GetBlocksPerBatch( const Layout& layout )
+{
+	return nLanes / layout.nChannels;
+}
+
+size_t ImaAdpcm::GetFrameCount( const Layout& layout,size_t nBytes )
+{
+	const size_t headerSize = 4u * layout.nChannels;
+	const size_t nWhole = nBytes / layout.blockAlign;
+	const size_t nRemaining = nBytes % layout.blockAlign;
+	size_t nFrames = nWhole * layout.framesPerBlock;
+	if( nRemaining >= headerSize )
+	{
+		nFrames += std::min( (nRemaining - headerSize) / headerSize * 8u + 1u,layout.framesPerBlock );
+	}
+	return nFrames;
+}
+
+void ImaAdpcm::GetFirstFrame( const unsigned char* pBlock,const Layout& layout,int16_t* pFrame )
+{
+	pFrame[0] = ReadInt16( pBlock );
+	pFrame[1] = layout.nChannels == 2u ? ReadInt16( pBlock + 4 ) : pFrame[0];
+}
+
+void ImaAdpcm::DecodeChannel( const unsigned char* pBlock,const Layout& layout,unsigned int channel,int16_t* pDst )
+{
+	const unsigned int nChannels = layout.nChannels;
+	const unsigned char* const pHeader = &pBlock[channel * 4u];
+	int predictor = ReadInt16( pHeader );
+	int index = std::min( int( pHeader[2] ),maxStepIndex );
+	const auto Put = [=]( size_t frame,int16_t s )
+	{
+		pDst[frame * 2u + channel] = s;
+		if( nChannels == 1u )
+		{
+			pDst[frame * 2u + 1u] = s;
+		}
+	};
+	Put( 0u,int16_t( predictor ) );
+
+	const unsigned char* pGroup = &pBlock[4u * nChannels + channel * 4u];
+	for( size_t frame = 1u; frame < layout.framesPerBlock; pGroup += 4u * nChannels )
+	{
+		// low nibble first
+		uint32_t nibbles = uint32_t( pGroup[0] ) | uint32_t( pGroup[1] ) << 8 |
+			uint32_t( pGroup[2] ) << 16 | uint32_t( pGroup[3] ) << 24;
+		for( int j = 0; j < 8; j++,frame++,nibbles >>= 4 )
+		{
+			const int n = int( nibbles & 0xFu );
+			const int step = stepTable[index];
+			int diff = step >> 3;
+			if( n & 4 )
+			{
+				diff += step;
+			}
+			if( n & 2 )
+			{
+				diff += step >> 1;
+			}
+			if( n & 1 )
+			{
+				diff += step >> 2;
+			}
+			predictor += (n & 8) ? -diff : diff;
+			predictor = std::max( std::min( predictor,32767 ),-32768 );
+			index = std::max( std::min( index + indexTable[n & 7],maxStepIndex ),0 );
+			Put( frame,int16_t( predictor ) );
+		}
+	}
+}
+
+void ImaAdpcm::Decode( const unsigned char* pSrc,size_t nBlocks,const Layout& layout,int16_t* pDst )
+{
+	const unsigned int nChannels = layout.nChannels;
+	const size_t blockFrames = layout.framesPerBlock;
+	size_t b = 0u;
+#ifdef CHILI_ADPCM_SSE2
+	const size_t nBatch = GetBlocksPerBatch( layout );
+	for( ; b + nBatch <= nBlocks; b += nBatch )
+	{
+		// lane l decodes channel (l % nChannels) of block (b + l / nChannels)
+		const unsigned char* pGroup[nLanes];
+		int16_t* pOut[nLanes];
+		alignas( 16 ) int32_t predictor[nLanes];
+		alignas( 16 ) int32_t index[nLanes];
+		for( size_t l = 0u; l < nLanes; l++ )
+		{
+			const unsigned char* const pBlock = &pSrc[(b + l / nChannels) * layout.blockAlign];
+			const size_t c = l % nChannels;
+			pGroup[l] = &pBlock[4u * nChannels + c * 4u];
+			pOut[l] = &pDst[(b + l / nChannels) * blockFrames * 2u];
+			predictor[l] = ReadInt16( &pBlock[c * 4u] );
+			index[l] = std::min( int32_t( pBlock[c * 4u + 2u] ),int32_t( maxStepIndex ) );
+		}
+		// header samples, the first frame of each block
+		for( size_t l = 0u; l < nLanes; l++ )
+		{
+			const size_t c = l % nChannels;
+			pOut[l][c] = int16_t( predictor[l] );
+			if( nChannels == 1u )
+			{
+				pOut[l][1] = int16_t( predictor[l] );
+			}
+		}
+
+		__m128i vPredictor = _mm_load_si128( reinterpret_cast<const __m128i*>( predictor ) );
+		__m128i vIndex = _mm_load_si128( reinterpret_cast<const __m128i*>( index ) );
+		const __m128i vZero = _mm_setzero_si128();
+		const __m128i vOnes = _mm_set1_epi32( -1 );
+		const __m128i vBit0 = _mm_set1_epi32( 1 );
+		const __m128i vBit1 = _mm_set1_epi32( 2 );
+		const __m128i vBit2 = _mm_set1_epi32( 4 );
+		const __m128i vBit3 = _mm_set1_epi32( 8 );
+		const __m128i vNibble = _mm_set1_epi32( 0xF );
+		const __m128i vMagnitude = _mm_set1_epi32( 7 );
+		const __m128i vThree = _mm_set1_epi32( 3 );
+		const __m128i vMaxIndex = _mm_set1_epi32( maxStepIndex );
+		const size_t groupStride = 4u * nChannels;
+		for( size_t frame = 1u; frame < blockFrames; frame += 8u )
+		{
+			uint32_t words[nLanes];
+			for( size_t l = 0u; l < nLanes; l++ )
+			{
+				memcpy( &words[l],pGroup[l],sizeof( uint32_t ) );
+				pGroup[l] += groupStride;
+			}
+			__m128i vWords = _mm_set_epi32( int( words[3] ),int( words[2] ),int( words[1] ),int( words[0] ) );
+			for( size_t j = 0u; j < 8u; j++ )
+			{
+				const __m128i n = _mm_and_si128( vWords,vNibble );
+				vWords = _mm_srli_epi32( vWords,4 );
+				// no gather in SSE2, the step lookup is the one scalar part
+				_mm_store_si128( reinterpret_cast<__m128i*>( index ),vIndex );
+				const __m128i step = _mm_set_epi32( stepTable[index[3]],stepTable[index[2]],
+					stepTable[index[1]],stepTable[index[0]] );
+
+				// diff = step/8 + step*(n&4) + step/2*(n&2) + step/4*(n&1), negated by bit 3
+				__m128i diff = _mm_srai_epi32( step,3 );
+				diff = _mm_add_epi32( diff,_mm_and_si128( step,
+					_mm_cmpeq_epi32( _mm_and_si128( n,vBit2 ),vBit2 ) ) );
+				diff = _mm_add_epi32( diff,_mm_and_si128( _mm_srai_epi32( step,1 ),
+					_mm_cmpeq_epi32( _mm_and_si128( n,vBit1 ),vBit1 ) ) );
+				diff = _mm_add_epi32( diff,_mm_and_si128( _mm_srai_epi32( step,2 ),
+					_mm_cmpeq_epi32( _mm_and_si128( n,vBit0 ),vBit0 ) ) );
+				const __m128i sign = _mm_cmpeq_epi32( _mm_and_si128( n,vBit3 ),vBit3 );
+				diff = _mm_sub_epi32( _mm_xor_si128( diff,sign ),sign );
+
+				// packs saturates to int16, sign extend back to keep the predictor in 32 bits
+				const __m128i packed = _mm_packs_epi32( _mm_add_epi32( vPredictor,diff ),vZero );
+				vPredictor = _mm_srai_epi32( _mm_unpacklo_epi16( packed,packed ),16 );
+
+				// index += n&7 < 4 ? -1 : (n&7 - 3) * 2, clamped to [0,88]
+				// (16-bit min/max are fine on these small values)
+				const __m128i m = _mm_and_si128( n,vMagnitude );
+				const __m128i up = _mm_cmpgt_epi32( m,vThree );
+				const __m128i delta = _mm_or_si128(
+					_mm_and_si128( up,_mm_slli_epi32( _mm_sub_epi32( m,vThree ),1 ) ),
+					_mm_andnot_si128( up,vOnes ) );
+				vIndex = _mm_min_epi16( _mm_max_epi16( _mm_add_epi32( vIndex,delta ),vZero ),vMaxIndex );
+
+				// stereo lanes come out as (L,R) pairs, mono lanes get duplicated into pairs
+				alignas( 16 ) uint32_t frames[nLanes];
+				_mm_store_si128( reinterpret_cast<__m128i*>( frames ),
+					nChannels == 2u ? packed : _mm_unpacklo_epi16( packed,packed ) );
+				for( size_t l = 0u; l < nLanes; l += nChannels )
+				{
+					memcpy( &pOut[l][(frame + j) * 2u],&frames[l / nChannels],sizeof( uint32_t ) );
+				}
+			}
+		}
+	}
+#endif
+	for( ; b < nBlocks; b++ )
+	{
+		for( unsigned int c = 0u; c < nChannels; c++ )
+		{
+			DecodeChannel( &pSrc[b * layout.blockAlign],layout,c,&pDst[b * blockFrames * 2u] );
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// IMA ADPCM (wave format 0x11), 4 bits a sample
+// a block is a header per channel (raw first sample + step index) followed by groups of
+// 8 samples interleaved by channel, every block decodes on its own
+// sounds in this format stay compressed in memory and are decoded a few blocks at a time by the mixer
+class ImaAdpcm
+{
+public:
+	static constexpr unsigned int formatTag = 0x11u;
+	struct Layout
+	{
+		unsigned int nChannels;
+		size_t blockAlign;
+		size_t framesPerBlock;
+	};
+	// channel streams decoded side by side (2 stereo blocks or 4 mono ones)
+	static constexpr size_t nLanes = 4u;
+public:
+	// framesPerBlock of 0 means work it out from the block size
+	// returns false for layouts we can't decode (only mono and stereo are supported)
+	static bool MakeLayout( unsigned int nChannels,size_t blockAlign,size_t framesPerBlock,Layout& layout );
+	static size_t GetBlocksPerBatch( const Layout& layout );
+	// frames in nBytes of blocks, counting the frames of a trailing partial block
+	static size_t GetFrameCount( const Layout& layout,size_t nBytes );
+	// decodes whole blocks to interleaved 16-bit stereo (mono is duplicated)
+	// the sample recurrence is serial within a channel, so the SSE2 path runs one channel of
+	// one block per lane (GetBlocksPerBatch blocks at a time), leftover blocks are done scalar
+	static void Decode( const unsigned char* pSrc,size_t nBlocks,const Layout& layout,int16_t* pDst );
+	// first frame of a block is stored raw in its header, no decoding needed
+	static void GetFirstFrame( const unsigned char* pBlock,const Layout& layout,int16_t* pFrame );
+private:
+	static void DecodeChannel( const unsigned char* pBlock,const Layout& layout,unsigned int channel,int16_t* pDst );
+};
\ No newline at end of file
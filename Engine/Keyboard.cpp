@@ -27,10 +27,10 @@ bool Keyboard::KeyIsPressed( unsigned char keycode ) const
 
 Keyboard::Event Keyboard::ReadKey()
 {
-	if( keybuffer.size() > 0u )
+	if( !keybuffer.IsEmpty() )
 	{
-		Keyboard::Event e = keybuffer.front();
-		keybuffer.pop();
+		Keyboard::Event e = keybuffer.Front();
+		keybuffer.Pop();
 		return e;
 	}
 	else
@@ -41,15 +41,15 @@ Keyboard::Event Keyboard::ReadKey()
 
 bool Keyboard::KeyIsEmpty() const
 {
-	return keybuffer.empty();
+	return keybuffer.IsEmpty();
 }
 
 char Keyboard::ReadChar()
 {
-	if( charbuffer.size() > 0u )
+	if( !charbuffer.IsEmpty() )
 	{
-		unsigned char charcode = charbuffer.front();
-		charbuffer.pop();
+		unsigned char charcode = charbuffer.Front();
+		charbuffer.Pop();
 		return charcode;
 	}
 	else
@@ -60,17 +60,17 @@ char Keyboard::ReadChar()
 
 bool Keyboard::CharIsEmpty() const
 {
-	return charbuffer.empty();
+	return charbuffer.IsEmpty();
 }
 
 void Keyboard::FlushKey()
 {
-	keybuffer = std::queue<Event>();
+	keybuffer.Clear();
 }
 
 void Keyboard::FlushChar()
 {
-	charbuffer = std::queue<char>();
+	charbuffer.Clear();
 }
 
 void Keyboard::Flush()
@@ -97,29 +97,17 @@ bool Keyboard::AutorepeatIsEnabled() const
 void Keyboard::OnKeyPressed( unsigned char keycode )
 {
 	keystates[ keycode ] = true;	
-	keybuffer.push( Keyboard::Event( Keyboard::Event::Type::Press,keycode ) );
-	TrimBuffer( keybuffer );
+	keybuffer.Push( Keyboard::Event( Keyboard::Event::Type::Press,keycode ) );
 }
 
 void Keyboard::OnKeyReleased( unsigned char keycode )
 {
 	keystates[ keycode ] = false;
-	keybuffer.push( Keyboard::Event( Keyboard::Event::Type::Release,keycode ) );
-	TrimBuffer( keybuffer );
+	keybuffer.Push( Keyboard::Event( Keyboard::Event::Type::Release,keycode ) );
 }
 
 void Keyboard::OnChar( char character )
 {
-	charbuffer.push( character );
-	TrimBuffer( charbuffer );
-}
-
-template<typename T>
-void Keyboard::TrimBuffer( std::queue<T>& buffer )
-{
-	while( buffer.size() > bufferSize )
-	{
-		buffer.pop();
-	}
+	charbuffer.Push( character );
 }
 
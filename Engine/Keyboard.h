@@ -19,7 +19,7 @@
  *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
  ******************************************************************************************/
 #pragma once
-#include <queue>
+#include "FixedQueue.h"
 #include <bitset>
 
 class Keyboard
@@ -85,13 +85,12 @@ private:
 	void OnKeyPressed( unsigned char keycode );
 	void OnKeyReleased( unsigned char keycode );
 	void OnChar( char character );
-	template<typename T>
-	void TrimBuffer( std::queue<T>& buffer );
 private:
 	static constexpr unsigned int nKeys = 256u;
 	static constexpr unsigned int bufferSize = 4u;
 	bool autorepeatEnabled = false;
 	std::bitset<nKeys> keystates;
-	std::queue<Event> keybuffer;
-	std::queue<char> charbuffer;
+	// only the latest bufferSize events and chars are kept
+	FixedQueue<Event,bufferSize> keybuffer;
+	FixedQueue<char,bufferSize> charbuffer;
 };
\ No newline at end of file
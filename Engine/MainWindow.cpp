@@ -23,6 +23,8 @@
 #include "Graphics.h"
 #include "ChiliException.h"
 #include "Game.h"
+#include "StartupProfiler.h"
+#include "AllocTracker.h"
 #include <assert.h>
 
 MainWindow::MainWindow( HINSTANCE hInst,wchar_t * pArgs )
@@ -30,6 +32,8 @@ MainWindow::MainWindow( HINSTANCE hInst,wchar_t * pArgs )
 	args( pArgs ),
 	hInst( hInst )
 {
+	StartupProfiler::Phase phase( "window" );
+
 	// register window class
 	WNDCLASSEX wc = { sizeof( WNDCLASSEX ),CS_CLASSDC,_HandleMsgSetup,0,0,
 		hInst,nullptr,nullptr,nullptr,nullptr,
@@ -86,6 +90,7 @@ void MainWindow::ShowMessageBox( const std::wstring& title,const std::wstring& m
 
 bool MainWindow::ProcessMessage()
 {
+	CHILI_ALLOC_SCOPE( Input );
 	MSG msg;
 	while( PeekMessage( &msg,nullptr,0,0,PM_REMOVE ) )
 	{
@@ -1,9 +1,18 @@
 #include "MemeField.h"
 #include <assert.h>
-#include <random>
 #include "Vei2.h"
 #include "SpriteCodex.h"
 #include <algorithm>
+#include <limits>
+#include "HotCounters.h"
+#include "Trace.h"
+#include "ThreadPool.h"
+#include "CounterRng.h"
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#define CHILI_FIELD_SSE2
+#include <emmintrin.h>
+#endif
 
 void MemeField::Tile::SpawnMeme()
 {
@@ -115,56 +124,288 @@ bool MemeField::Tile::HasNoNeighborMemes() const
 	return nNeighborMemes == 0;
 }
 
+int MemeField::Tile::GetNeighborMemeCount() const
+{
+	return nNeighborMemes;
+}
+
 void MemeField::Tile::SetNeighborMemeCount( int memeCount )
 {
 	assert( nNeighborMemes == -1 );
 	nNeighborMemes = memeCount;
 }
 
+namespace
+{
+	// boards are generated in stripes of whole rows about this many tiles big, the stripes only
+	// depend on the width, so a seed makes the same board however many threads build it
+	constexpr int stripeTiles = 64 * 1024;
+
+	// while the opening index is built, every tile not inside an opening holds notInside, or for a
+	// border tile what it borders, all of it below what any inside tile holds
+	constexpr int notInside = std::numeric_limits<int>::min();
+	constexpr int bordersSeveral = notInside + 1;
+	// the passes of the index that go over the rows (union-find, border count and fill), the flat
+	// ones in between are quick
+	constexpr int nOpeningPasses = 3;
+
+	int GetStripeRows( int width )
+	{
+		return std::max( stripeTiles / width,1 );
+	}
+
+	// a stripe gets the memes of its share of the tiles (rounded so the shares add up to nMemes)
+	// and places them with a stream of counters of its own, hasMeme and spawn take the index in
+	// the stripe, returns how many it placed
+	template<typename HasMeme,typename Spawn>
+	int PlaceStripeMemes( const CounterRng& rng,int stripe,int width,int height,int nMemes,HasMeme hasMeme,Spawn spawn )
+	{
+		const int stripeRows = GetStripeRows( width );
+		const int yStart = stripe * stripeRows;
+		const int yEnd = std::min( yStart + stripeRows,height );
+		const int nStripeTiles = (yEnd - yStart) * width;
+		const int64_t nTiles = int64_t( width ) * int64_t( height );
+		const int nStripeMemes = int( int64_t( nMemes ) * (yEnd * width) / nTiles -
+			int64_t( nMemes ) * (yStart * width) / nTiles );
+		uint64_t counter = CounterRng::StreamStart( static_cast<uint32_t>( stripe ) );
+		for( int nSpawned = 0; nSpawned < nStripeMemes; ++nSpawned )
+		{
+			int i;
+			do
+			{
+				i = int( rng.Below( counter++,static_cast<uint32_t>( nStripeTiles ) ) );
+			}
+			while( hasMeme( i ) );
+
+			spawn( i );
+		}
+		return nStripeMemes;
+	}
+}
+
+float MemeField::Progress::Get() const
+{
+	const int64_t n = nSteps.load( std::memory_order_relaxed );
+	return n > 0 ? float( double( nDone.load( std::memory_order_relaxed ) ) / double( n ) ) : 0.0f;
+}
+
+void MemeField::Progress::Cancel()
+{
+	cancelled = true;
+}
+
+bool MemeField::Progress::IsCancelled() const
+{
+	return cancelled;
+}
+
+void MemeField::Progress::Reset()
+{
+	nDone = 0;
+	nSteps = 0;
+	cancelled = false;
+}
+
 MemeField::MemeField( const Vei2& center,int width,int height,int nMemes )
+	:
+	MemeField( center,width,height,nMemes,CounterRng::RandomSeed() )
+{
+}
+
+MemeField::MemeField( const Vei2& center,int width,int height,int nMemes,uint64_t seed )
+	:
+	MemeField( center,width,height,nMemes,seed,nullptr,nullptr,nullptr )
+{
+}
+
+MemeField::MemeField( const Vei2& center,int width,int height,int nMemes,uint64_t seed,FieldArena& arena,Progress* pProgress,ThreadPool* pPool )
+	:
+	MemeField( center,width,height,nMemes,seed,&arena,pProgress,pPool )
+{
+}
+
+MemeField::MemeField( const Vei2& center,int width,int height,int nMemes,uint64_t seed,FieldArena* pArena,Progress* pProgress,ThreadPool* pPool )
 	:
 	width( width ),
 	height( height ),
-	field( new Tile[width * height] ),
-	topLeft( center - Vei2( width * SpriteCodex::tileSize,height * SpriteCodex::tileSize ) / 2 )
+	seed( seed ),
+	topLeft( center - Vei2( width * SpriteCodex::tileSize,height * SpriteCodex::tileSize ) / 2 ),
+	field( AllocateArray<Tile>( pArena,size_t( width * height ) ) ),
+	ownsTiles( pArena == nullptr )
 {
+	CHILI_TRACE_ZONE( "MemeField::MemeField" );
 	assert( nMemes > 0 && nMemes < width * height );
-	std::random_device rd;
-	std::mt19937 rng( rd() );
-	std::uniform_int_distribution<int> xDist( 0,width - 1 );
-	std::uniform_int_distribution<int> yDist( 0,height - 1 );
+	if( pProgress )
+	{
+		// counting and each pass of the opening index over the rows are a step a tile
+		pProgress->nSteps = int64_t( nMemes ) + (1 + nOpeningPasses) * int64_t( width ) * height;
+	}
+	const int stripeRows = GetStripeRows( width );
+	const int nStripes = (height + stripeRows - 1) / stripeRows;
+
+	const CounterRng rng( seed );
+	ForEachStripe( nStripes,pPool,[&]( size_t stripe )
+	{
+		if( pProgress && pProgress->IsCancelled() )
+		{
+			return;
+		}
+		const int yStart = int( stripe ) * stripeRows;
+		const int yEnd = std::min( yStart + stripeRows,height );
+		Tile* const pStripe = &field[yStart * width];
+		ResetTiles( pStripe,size_t( (yEnd - yStart) * width ) );
+		const int nStripeMemes = PlaceStripeMemes( rng,int( stripe ),width,height,nMemes,
+			[pStripe]( int i ) { return pStripe[i].HasMeme(); },
+			[pStripe]( int i ) { pStripe[i].SpawnMeme(); } );
+		if( pProgress )
+		{
+			pProgress->nDone.fetch_add( nStripeMemes,std::memory_order_relaxed );
+		}
+	} );
+	if( pProgress && pProgress->IsCancelled() )
+	{
+		return;
+	}
 
-	for( int nSpawned = 0; nSpawned < nMemes; ++nSpawned )
+	// the rows next to a stripe (its halo) belong to the neighbor stripes, all placed by now
+	ForEachStripe( nStripes,pPool,[&]( size_t stripe )
 	{
-		Vei2 spawnPos;
-		do
+		if( pProgress && pProgress->IsCancelled() )
+		{
+			return;
+		}
+		const int yStart = int( stripe ) * stripeRows;
+		const int yEnd = std::min( yStart + stripeRows,height );
+		for( Vei2 gridPos = { 0,yStart }; gridPos.y < yEnd; gridPos.y++ )
+		{
+			for( gridPos.x = 0; gridPos.x < width; gridPos.x++ )
+			{
+				TileAt( gridPos ).SetNeighborMemeCount( CountNeighborMemes( gridPos ) );
+			}
+		}
+		if( pProgress )
 		{
-			spawnPos = { xDist( rng ),yDist( rng ) };
+			pProgress->nDone.fetch_add( int64_t( yEnd - yStart ) * width,std::memory_order_relaxed );
 		}
-		while( TileAt( spawnPos ).HasMeme() );
+	} );
+	if( pProgress && pProgress->IsCancelled() )
+	{
+		return;
+	}
+
+	BuildOpenings( pArena,pProgress );
+}
 
-		TileAt( spawnPos ).SpawnMeme();
+template<typename T>
+T* MemeField::AllocateArray( FieldArena* pArena,size_t n )
+{
+	if( pArena )
+	{
+		return pArena->Allocate<T>( n );
 	}
+	return static_cast<T*>( ::operator new( sizeof( T ) * n ) );
+}
 
-	for( Vei2 gridPos = { 0,0 }; gridPos.y < height; gridPos.y++ )
+void MemeField::PlaceMemes( int width,int height,int nMemes,uint64_t seed,unsigned char* pMemes )
+{
+	assert( nMemes > 0 && nMemes < width * height );
+	std::fill( pMemes,pMemes + width * height,static_cast<unsigned char>( 0u ) );
+	const CounterRng rng( seed );
+	const int stripeRows = GetStripeRows( width );
+	for( int stripe = 0; stripe * stripeRows < height; stripe++ )
 	{
-		for( gridPos.x = 0; gridPos.x < width; gridPos.x++ )
+		unsigned char* const pStripe = &pMemes[stripe * stripeRows * width];
+		PlaceStripeMemes( rng,stripe,width,height,nMemes,
+			[pStripe]( int i ) { return pStripe[i] != 0u; },
+			[pStripe]( int i ) { pStripe[i] = 1u; } );
+	}
+}
+
+void MemeField::ForEachStripe( int nStripes,ThreadPool* pPool,const std::function<void( size_t )>& f )
+{
+	if( pPool )
+	{
+		pPool->ParallelFor( size_t( nStripes ),f );
+	}
+	else
+	{
+		for( size_t stripe = 0u; stripe < size_t( nStripes ); stripe++ )
+		{
+			f( stripe );
+		}
+	}
+}
+
+bool MemeField::ForEachStripeInOrder( Progress* pProgress,const std::function<void( int,int )>& f ) const
+{
+	const int stripeRows = GetStripeRows( width );
+	for( int yStart = 0; yStart < height; yStart += stripeRows )
+	{
+		if( pProgress && pProgress->IsCancelled() )
+		{
+			return false;
+		}
+		const int yEnd = std::min( yStart + stripeRows,height );
+		f( yStart,yEnd );
+		if( pProgress )
 		{
-			TileAt( gridPos ).SetNeighborMemeCount( CountNeighborMemes( gridPos ) );
+			pProgress->nDone.fetch_add( int64_t( yEnd - yStart ) * width,std::memory_order_relaxed );
 		}
 	}
+	return true;
+}
+
+size_t MemeField::GetArenaBytes( int width,int height )
+{
+	const size_t fieldBytes = (sizeof( MemeField ) + alignof( Tile ) - 1u) / alignof( Tile ) * alignof( Tile );
+	const size_t nTiles = size_t( width * height );
+	// the lists hold each inside tile once and most border tiles once or twice, together with the
+	// counts that's under 1.5 entries a tile on anything but a nearly empty board
+	return fieldBytes + sizeof( Tile ) * nTiles + sizeof( int ) * (nTiles + nTiles * 3u / 2u + 1u);
 }
 
 MemeField::~MemeField()
 {
-	delete[] field;
+	if( ownsTiles )
+	{
+		::operator delete( field );
+		::operator delete( openingOf );
+		::operator delete( openingTiles );
+	}
 	field = nullptr;
+	openingOf = nullptr;
+	openingTiles = nullptr;
+}
+
+void MemeField::ResetTiles( Tile* pTiles,size_t nTiles )
+{
+	// a fresh tile isn't all zeros (no neighbor count is -1), so it's copies of one stamped out
+	const Tile fresh;
+	size_t i = 0u;
+#ifdef CHILI_FIELD_SSE2
+	// 4 tiles fill 3 vectors exactly, so that's 48 bytes a store round
+	static_assert( sizeof( Tile ) * 4u == sizeof( __m128i ) * 3u,"tile pattern doesn't fill whole vectors" );
+	alignas( 16 ) Tile four[4] = { fresh,fresh,fresh,fresh };
+	const __m128i* const pPattern = reinterpret_cast<const __m128i*>( four );
+	const __m128i v0 = _mm_load_si128( &pPattern[0] );
+	const __m128i v1 = _mm_load_si128( &pPattern[1] );
+	const __m128i v2 = _mm_load_si128( &pPattern[2] );
+	for( ; i + 4u <= nTiles; i += 4u )
+	{
+		__m128i* const pDst = reinterpret_cast<__m128i*>( &pTiles[i] );
+		_mm_storeu_si128( &pDst[0],v0 );
+		_mm_storeu_si128( &pDst[1],v1 );
+		_mm_storeu_si128( &pDst[2],v2 );
+	}
+#endif
+	std::fill( &pTiles[i],&pTiles[nTiles],fresh );
 }
 
 void MemeField::Draw( Graphics& gfx ) const
 {
 	gfx.DrawRect( GetRect().GetExpanded( borderThickness ),borderColor );
 	gfx.DrawRect( GetRect(),SpriteCodex::baseColor );
+	CHILI_HOT_COUNT( TilesDrawn,width * height );
 	for( Vei2 gridPos = { 0,0 }; gridPos.y < height; gridPos.y++ )
 	{
 		for( gridPos.x = 0; gridPos.x < width; gridPos.x++ )
@@ -185,7 +426,11 @@ void MemeField::OnRevealClick( const Vei2& screenPos )
 	{
 		const Vei2 gridPos = ScreenToGrid( screenPos );
 		assert( gridPos.x >= 0 && gridPos.x < width && gridPos.y >= 0 && gridPos.y < height );
-		RevealTile( gridPos );
+		CHILI_HOT_COUNT( RevealCascades,1u );
+		{
+			CHILI_TRACE_ZONE( "RevealTile cascade" );
+			RevealTile( gridPos );
+		}
 		if( GameIsWon() )
 		{
 			state = State::Winrar;
@@ -203,6 +448,10 @@ void MemeField::OnFlagClick( const Vei2 & screenPos )
 		if( !tile.IsRevealed() )
 		{
 			tile.ToggleFlag();
+			if( IsInsideOpening( tile ) )
+			{
+				openingFlagged = true;
+			}
 			if( tile.IsFlagged() && GameIsWon() )
 			{
 				state = State::Winrar;
@@ -216,31 +465,314 @@ MemeField::State MemeField::GetState() const
 	return state;
 }
 
+void MemeField::BuildOpenings( FieldArena* pArena,Progress* pProgress )
+{
+	CHILI_TRACE_ZONE( "MemeField::BuildOpenings" );
+	const int nTiles = width * height;
+	// a tile is in at most 4 lists and every list has its count, so there are under 5 entries a
+	// tile, the roots' -3 - offset have to stay above what the border tiles hold
+	assert( nTiles <= std::numeric_limits<int>::max() / 8 );
+	// union-find in row order, a set's root is its first tile and holds -2 - its tile count, the
+	// other inside tiles their parent (always an earlier tile), every other tile notInside
+	// (plain ints in here, the Vei2 operators don't inline across files)
+	openingOf = AllocateArray<int>( pArena,size_t( nTiles ) );
+	const bool joined = ForEachStripeInOrder( pProgress,[this]( int yStart,int yEnd )
+	{
+		for( int y = yStart; y < yEnd; y++ )
+		{
+			for( int x = 0; x < width; x++ )
+			{
+				const int i = y * width + x;
+				if( !IsInsideOpening( field[i] ) )
+				{
+					openingOf[i] = notInside;
+					continue;
+				}
+				openingOf[i] = -3;
+				// of the neighbors visited already (left and the three above), the one above touches
+				// the other two, so they're in its set if inside, otherwise up left touches left
+				const bool hasAbove = y > 0;
+				const bool hasLeft = x > 0;
+				const bool hasRight = x < width - 1;
+				if( hasAbove && openingOf[i - width] != notInside )
+				{
+					Join( i,i - width );
+				}
+				else
+				{
+					if( hasAbove && hasLeft && openingOf[i - width - 1] != notInside )
+					{
+						Join( i,i - width - 1 );
+					}
+					else if( hasLeft && openingOf[i - 1] != notInside )
+					{
+						Join( i,i - 1 );
+					}
+					if( hasAbove && hasRight && openingOf[i - width + 1] != notInside )
+					{
+						Join( i,i - width + 1 );
+					}
+				}
+			}
+		}
+	} );
+	if( !joined )
+	{
+		return;
+	}
+	// point every inside tile right at its root, parents come first so theirs is done already
+	for( int i = 0; i < nTiles; i++ )
+	{
+		const int parent = openingOf[i];
+		if( parent >= 0 && openingOf[parent] >= 0 )
+		{
+			openingOf[i] = openingOf[parent];
+		}
+	}
+	if( pProgress && pProgress->IsCancelled() )
+	{
+		return;
+	}
+	// the border tiles count toward every opening they touch, and keep what they border for the
+	// fill (the root of the one opening over bordersSeveral, or bordersSeveral to look again)
+	int openings[4];
+	const bool counted = ForEachStripeInOrder( pProgress,[this,&openings]( int yStart,int yEnd )
+	{
+		for( int y = yStart; y < yEnd; y++ )
+		{
+			for( int x = 0; x < width; x++ )
+			{
+				const int i = y * width + x;
+				if( openingOf[i] == notInside && !field[i].HasMeme() )
+				{
+					const int nOpenings = GetBorderedOpenings( x,y,openings );
+					for( int k = 0; k < nOpenings; k++ )
+					{
+						openingOf[openings[k]]--;
+					}
+					// no branch on the count, none or one goes either way all the time
+					const int bordered = nOpenings == 1 ? bordersSeveral + 1 + openings[0] : bordersSeveral;
+					openingOf[i] = nOpenings == 0 ? notInside : bordered;
+				}
+			}
+		}
+	} );
+	if( !counted || (pProgress && pProgress->IsCancelled()) )
+	{
+		return;
+	}
+	// roots swap their count for -3 - the offset of their list
+	int nEntries = 0;
+	for( int i = 0; i < nTiles; i++ )
+	{
+		if( openingOf[i] < -2 && IsInsideEntry( openingOf[i] ) )
+		{
+			const int nOpeningTiles = -2 - openingOf[i];
+			openingOf[i] = -3 - nEntries;
+			nEntries += 1 + nOpeningTiles;
+		}
+	}
+	// fill the lists, the counts go up as tiles are added
+	openingTiles = AllocateArray<int>( pArena,size_t( std::max( nEntries,1 ) ) );
+	std::fill( openingTiles,openingTiles + nEntries,0 );
+	const auto addToList = [this]( int root,int i )
+	{
+		const int offset = -3 - openingOf[root];
+		openingTiles[offset + ++openingTiles[offset]] = i;
+	};
+	const bool filled = ForEachStripeInOrder( pProgress,[this,&openings,&addToList]( int yStart,int yEnd )
+	{
+		for( int y = yStart; y < yEnd; y++ )
+		{
+			for( int x = 0; x < width; x++ )
+			{
+				const int i = y * width + x;
+				const int entry = openingOf[i];
+				if( IsInsideEntry( entry ) )
+				{
+					addToList( entry >= 0 ? entry : i,i );
+				}
+				else if( entry > bordersSeveral )
+				{
+					addToList( entry - bordersSeveral - 1,i );
+				}
+				else if( entry == bordersSeveral )
+				{
+					const int nOpenings = GetBorderedOpenings( x,y,openings );
+					for( int k = 0; k < nOpenings; k++ )
+					{
+						addToList( openings[k],i );
+					}
+				}
+			}
+		}
+	} );
+	if( !filled )
+	{
+		return;
+	}
+	// what the reveals go by, the offset of every inside tile's list, noOpening for the rest (roots
+	// come first, so theirs is done already)
+	for( int i = 0; i < nTiles; i++ )
+	{
+		const int entry = openingOf[i];
+		if( !IsInsideEntry( entry ) )
+		{
+			openingOf[i] = noOpening;
+		}
+		else if( entry < 0 )
+		{
+			openingOf[i] = -3 - entry;
+		}
+		else
+		{
+			openingOf[i] = openingOf[entry];
+		}
+	}
+}
+
+void MemeField::Join( int i,int j )
+{
+	const int rootA = FindRoot( openingOf,i );
+	const int rootB = FindRoot( openingOf,j );
+	if( rootA != rootB )
+	{
+		const int first = std::min( rootA,rootB );
+		const int last = std::max( rootA,rootB );
+		openingOf[first] -= -2 - openingOf[last];
+		openingOf[last] = first;
+	}
+}
+
+int MemeField::FindRoot( int* pParents,int i )
+{
+	int root = i;
+	while( pParents[root] >= 0 )
+	{
+		root = pParents[root];
+	}
+	while( pParents[i] >= 0 )
+	{
+		const int next = pParents[i];
+		pParents[i] = root;
+		i = next;
+	}
+	return root;
+}
+
+int MemeField::GetBorderedOpenings( int x,int y,int* pOpenings ) const
+{
+	const int xStart = std::max( 0,x - 1 );
+	const int yStart = std::max( 0,y - 1 );
+	const int xEnd = std::min( width - 1,x + 1 );
+	const int yEnd = std::min( height - 1,y + 1 );
+
+	int nOpenings = 0;
+	for( int ny = yStart; ny <= yEnd; ny++ )
+	{
+		for( int nx = xStart; nx <= xEnd; nx++ )
+		{
+			const int i = ny * width + nx;
+			const int entry = openingOf[i];
+			if( !IsInsideEntry( entry ) )
+			{
+				continue;
+			}
+			// a root stands for itself
+			const int opening = entry >= 0 ? entry : i;
+			if( std::find( pOpenings,pOpenings + nOpenings,opening ) == pOpenings + nOpenings )
+			{
+				pOpenings[nOpenings++] = opening;
+			}
+		}
+	}
+	return nOpenings;
+}
+
+bool MemeField::IsInsideEntry( int entry ) const
+{
+	return entry > bordersSeveral + width * height;
+}
+
+bool MemeField::IsInsideOpening( const Tile& tile )
+{
+	return !tile.HasMeme() && tile.HasNoNeighborMemes();
+}
+
+void MemeField::RevealOpening( int offset )
+{
+	const int nTiles = openingTiles[offset];
+	const int* const pTiles = &openingTiles[offset + 1];
+	int nRevealed = 0;
+	for( int k = 0; k < nTiles; k++ )
+	{
+		Tile& tile = field[pTiles[k]];
+		if( !tile.IsRevealed() && !tile.IsFlagged() )
+		{
+			tile.Reveal();
+			nRevealed++;
+		}
+	}
+	CHILI_HOT_COUNT( TilesRevealed,nRevealed );
+}
+
 void MemeField::RevealTile( const Vei2& gridPos )
 {
 	Tile& tile = TileAt( gridPos );
 	if( !tile.IsRevealed() && !tile.IsFlagged() )
 	{
+		// the whole opening from its list, unless a flag may have made the cascade stop short
+		const int opening = openingOf[gridPos.y * width + gridPos.x];
+		if( opening != noOpening && !openingFlagged )
+		{
+			RevealOpening( opening );
+			return;
+		}
 		tile.Reveal();
+		CHILI_HOT_COUNT( TilesRevealed,1u );
 		if( tile.HasMeme() )
 		{
 			state = State::Fucked;
-			sndLose.Play();
 		}
 		else if( tile.HasNoNeighborMemes() )
 		{
-			const int xStart = std::max( 0,gridPos.x - 1 );
-			const int yStart = std::max( 0,gridPos.y - 1 );
-			const int xEnd = std::min( width - 1,gridPos.x + 1 );
-			const int yEnd = std::min( height - 1,gridPos.y + 1 );
-
-			for( Vei2 gridPos = { xStart,yStart }; gridPos.y <= yEnd; gridPos.y++ )
+			// only gets here with openingFlagged (the tile is inside an opening), so the lists are
+			// done with and make the stack of inside tiles still to spread from (each goes on once,
+			// when it's revealed, so there's never more on it than the lists held inside tiles)
+			assert( openingFlagged );
+			int* const pStack = openingTiles;
+			int nStack = 0;
+			pStack[nStack++] = gridPos.y * width + gridPos.x;
+			int nRevealed = 0;
+			while( nStack > 0 )
 			{
-				for( gridPos.x = xStart; gridPos.x <= xEnd; gridPos.x++ )
+				const int i = pStack[--nStack];
+				const int x = i % width;
+				const int y = i / width;
+				const int xStart = std::max( 0,x - 1 );
+				const int yStart = std::max( 0,y - 1 );
+				const int xEnd = std::min( width - 1,x + 1 );
+				const int yEnd = std::min( height - 1,y + 1 );
+				for( int ny = yStart; ny <= yEnd; ny++ )
 				{
-					RevealTile( gridPos );
+					for( int nx = xStart; nx <= xEnd; nx++ )
+					{
+						const int n = ny * width + nx;
+						Tile& neighbor = field[n];
+						// next to a tile without neighbor memes, so never a meme itself
+						if( !neighbor.IsRevealed() && !neighbor.IsFlagged() )
+						{
+							neighbor.Reveal();
+							nRevealed++;
+							if( neighbor.HasNoNeighborMemes() )
+							{
+								pStack[nStack++] = n;
+							}
+						}
+					}
 				}
 			}
+			CHILI_HOT_COUNT( TilesRevealed,nRevealed );
 		}
 	}
 }
@@ -255,11 +787,52 @@ const MemeField::Tile& MemeField::TileAt( const Vei2 & gridPos ) const
 	return field[gridPos.y * width + gridPos.x];
 }
 
-Vei2 MemeField::ScreenToGrid( const Vei2& screenPos )
+Vei2 MemeField::ScreenToGrid( const Vei2& screenPos ) const
 {
 	return (screenPos - topLeft) / SpriteCodex::tileSize;
 }
 
+Vei2 MemeField::GridToScreen( const Vei2& gridPos ) const
+{
+	return topLeft + gridPos * SpriteCodex::tileSize;
+}
+
+int MemeField::GetWidth() const
+{
+	return width;
+}
+
+int MemeField::GetHeight() const
+{
+	return height;
+}
+
+uint64_t MemeField::GetSeed() const
+{
+	return seed;
+}
+
+bool MemeField::TileHasMeme( const Vei2& gridPos ) const
+{
+	return TileAt( gridPos ).HasMeme();
+}
+
+bool MemeField::TileIsRevealed( const Vei2& gridPos ) const
+{
+	return TileAt( gridPos ).IsRevealed();
+}
+
+bool MemeField::TileIsFlagged( const Vei2& gridPos ) const
+{
+	return TileAt( gridPos ).IsFlagged();
+}
+
+int MemeField::TileNeighborMemes( const Vei2& gridPos ) const
+{
+	assert( TileAt( gridPos ).IsRevealed() );
+	return TileAt( gridPos ).GetNeighborMemeCount();
+}
+
 int MemeField::CountNeighborMemes( const Vei2 & gridPos )
 {
 	const int xStart = std::max( 0,gridPos.x - 1 );
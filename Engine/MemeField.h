@@ -1,7 +1,12 @@
 #pragma once
 
 #include "Graphics.h"
-#include "Sound.h"
+#include "FieldArena.h"
+#include <cstdint>
+#include <atomic>
+#include <functional>
+
+class ThreadPool;
 
 class MemeField
 {
@@ -31,34 +36,122 @@ private:
 		void ToggleFlag();
 		bool IsFlagged() const;
 		bool HasNoNeighborMemes() const;
+		int GetNeighborMemeCount() const;
 		void SetNeighborMemeCount( int memeCount );
 	private:
 		State state = State::Hidden;
 		bool hasMeme = false;
 		int nNeighborMemes = -1;
 	};
+public:
+	// lets another thread follow the construction of a big board and call it off (looked at once
+	// per stripe of the board, a cancelled field is left half built, all it's good for is destroying)
+	class Progress
+	{
+		friend MemeField;
+	public:
+		Progress() = default;
+		Progress( const Progress& ) = delete;
+		Progress& operator=( const Progress& ) = delete;
+		// 0 to 1
+		float Get() const;
+		void Cancel();
+		bool IsCancelled() const;
+		// for the next board, not while one is being built
+		void Reset();
+	private:
+		// steps are memes placed plus tiles counted and gone over by each pass of the opening
+		// index, 64-bit because four times the tiles of a big board is past what an int holds
+		std::atomic<int64_t> nDone = { 0 };
+		std::atomic<int64_t> nSteps = { 0 };
+		std::atomic<bool> cancelled = { false };
+	};
 public:
 	MemeField( const Vei2& center,int width,int height,int nMemes );
+	// same seed, same board (for benchmarks, replays and bug reports)
+	MemeField( const Vei2& center,int width,int height,int nMemes,uint64_t seed );
+	// tiles out of the arena (reused from the last game when it was big enough), the arena has to
+	// outlive the field and is only reset after it's gone
+	// with a pool the stripes of the board are generated in parallel, the board comes out the same
+	MemeField( const Vei2& center,int width,int height,int nMemes,uint64_t seed,FieldArena& arena,
+		Progress* pProgress = nullptr,ThreadPool* pPool = nullptr );
+	// what a field of this size (the field, its tiles and the opening index) usually takes out of an
+	// empty arena, a board with unusually many openings takes a little more
+	static size_t GetArenaBytes( int width,int height );
+	// the memes a field of this seed gets, 1 for a meme tile in row order, for tools that need
+	// layouts by the million and no field around them
+	static void PlaceMemes( int width,int height,int nMemes,uint64_t seed,unsigned char* pMemes );
+	MemeField( const MemeField& ) = delete;
+	MemeField& operator=( const MemeField& ) = delete;
 	~MemeField();
 	void Draw( Graphics& gfx ) const;
 	RectI GetRect() const;
 	void OnRevealClick( const Vei2& screenPos );
 	void OnFlagClick( const Vei2& screenPos );
 	State GetState() const;
+	// read-only view of the board for tools (benchmarks, bots), the game itself only clicks
+	int GetWidth() const;
+	int GetHeight() const;
+	// builds this board again
+	uint64_t GetSeed() const;
+	Vei2 ScreenToGrid( const Vei2& screenPos ) const;
+	// top left of the tile
+	Vei2 GridToScreen( const Vei2& gridPos ) const;
+	bool TileHasMeme( const Vei2& gridPos ) const;
+	bool TileIsRevealed( const Vei2& gridPos ) const;
+	bool TileIsFlagged( const Vei2& gridPos ) const;
+	// the number a revealed tile shows (bots go by what a player sees, so revealed tiles only)
+	int TileNeighborMemes( const Vei2& gridPos ) const;
 private:
+	// out of the arena, or owned without one
+	MemeField( const Vei2& center,int width,int height,int nMemes,uint64_t seed,FieldArena* pArena,
+		Progress* pProgress,ThreadPool* pPool );
+	template<typename T>
+	static T* AllocateArray( FieldArena* pArena,size_t n );
+	// on the pool and the calling thread, or just the calling thread without a pool
+	static void ForEachStripe( int nStripes,ThreadPool* pPool,const std::function<void( size_t )>& f );
+	// f( yStart,yEnd ) for the stripes top to bottom on the calling thread, their tiles counted as
+	// done, false (and the rest not run) once the build is cancelled
+	bool ForEachStripeInOrder( Progress* pProgress,const std::function<void( int,int )>& f ) const;
+	// storage of a used field holds whatever the last game left, so every tile is overwritten
+	static void ResetTiles( Tile* pTiles,size_t nTiles );
+	// the openings (8-connected tiles without neighbor memes, with the number tiles around them) by
+	// union-find once the tiles are counted, left unfinished when the build is cancelled
+	void BuildOpenings( FieldArena* pArena,Progress* pProgress );
+	// the sets of two inside tiles become one
+	void Join( int i,int j );
+	static int FindRoot( int* pParents,int i );
+	// the distinct openings around a number tile (at most 4) by their roots, while building
+	int GetBorderedOpenings( int x,int y,int* pOpenings ) const;
+	// whether what openingOf holds for a tile while building is an inside tile's (a parent, or a
+	// root's count or offset)
+	bool IsInsideEntry( int entry ) const;
+	static bool IsInsideOpening( const Tile& tile );
+	void RevealOpening( int offset );
 	void RevealTile( const Vei2& gridPos );
 	Tile& TileAt( const Vei2& gridPos );
 	const Tile& TileAt( const Vei2& gridPos ) const;
-	Vei2 ScreenToGrid( const Vei2& screenPos );
 	int CountNeighborMemes( const Vei2& gridPos );
 	bool GameIsWon() const;
 private:
 	int width;
 	int height;
+	uint64_t seed;
 	static constexpr int borderThickness = 10;
 	static constexpr Color borderColor = Colors::Blue;
-	Sound sndLose = Sound( L"spayed.wav" );
 	Vei2 topLeft;
 	State state = State::Memeing;
 	Tile* field = nullptr;
+	// per tile the offset of its opening in openingTiles, noOpening for tiles not inside one
+	// (number tiles can border several, they're only in the lists)
+	static constexpr int noOpening = -1;
+	int* openingOf = nullptr;
+	// per opening its tile count, then its tiles (inside and border) in row order
+	int* openingTiles = nullptr;
+	// the cascade stops at a flag (and later at the tiles it revealed, even once the flag's gone),
+	// so after a flag went on an opening's inside tile this board cascades tile by tile (with
+	// openingTiles as its stack, the lists aren't looked at again)
+	bool openingFlagged = false;
+	// false when the tiles and the index are in an arena
+	bool ownsTiles;
 };
\ No newline at end of file
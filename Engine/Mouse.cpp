@@ -53,10 +53,10 @@ bool Mouse::IsInWindow() const
 
 Mouse::Event Mouse::Read()
 {
-	if( buffer.size() > 0u )
+	if( !buffer.IsEmpty() )
 	{
-		Mouse::Event e = buffer.front();
-		buffer.pop();
+		Mouse::Event e = buffer.Front();
+		buffer.Pop();
 		return e;
 	}
 	else
@@ -67,7 +67,7 @@ Mouse::Event Mouse::Read()
 
 void Mouse::Flush()
 {
-	buffer = std::queue<Event>();
+	buffer.Clear();
 }
 
 void Mouse::OnMouseLeave()
@@ -85,58 +85,43 @@ void Mouse::OnMouseMove( int newx,int newy )
 	x = newx;
 	y = newy;
 
-	buffer.push( Mouse::Event( Mouse::Event::Type::Move,*this ) );
-	TrimBuffer();
+	buffer.Push( Mouse::Event( Mouse::Event::Type::Move,*this ) );
 }
 
 void Mouse::OnLeftPressed( int x,int y )
 {
 	leftIsPressed = true;
 
-	buffer.push( Mouse::Event( Mouse::Event::Type::LPress,*this ) );
-	TrimBuffer();
+	buffer.Push( Mouse::Event( Mouse::Event::Type::LPress,*this ) );
 }
 
 void Mouse::OnLeftReleased( int x,int y )
 {
 	leftIsPressed = false;
 
-	buffer.push( Mouse::Event( Mouse::Event::Type::LRelease,*this ) );
-	TrimBuffer();
+	buffer.Push( Mouse::Event( Mouse::Event::Type::LRelease,*this ) );
 }
 
 void Mouse::OnRightPressed( int x,int y )
 {
 	rightIsPressed = true;
 
-	buffer.push( Mouse::Event( Mouse::Event::Type::RPress,*this ) );
-	TrimBuffer();
+	buffer.Push( Mouse::Event( Mouse::Event::Type::RPress,*this ) );
 }
 
 void Mouse::OnRightReleased( int x,int y )
 {
 	rightIsPressed = false;
 
-	buffer.push( Mouse::Event( Mouse::Event::Type::RRelease,*this ) );
-	TrimBuffer();
+	buffer.Push( Mouse::Event( Mouse::Event::Type::RRelease,*this ) );
 }
 
 void Mouse::OnWheelUp( int x,int y )
 {
-	buffer.push( Mouse::Event( Mouse::Event::Type::WheelUp,*this ) );
-	TrimBuffer();
+	buffer.Push( Mouse::Event( Mouse::Event::Type::WheelUp,*this ) );
 }
 
 void Mouse::OnWheelDown( int x,int y )
 {
-	buffer.push( Mouse::Event( Mouse::Event::Type::WheelDown,*this ) );
-	TrimBuffer();
-}
-
-void Mouse::TrimBuffer()
-{
-	while( buffer.size() > bufferSize )
-	{
-		buffer.pop();
-	}
+	buffer.Push( Mouse::Event( Mouse::Event::Type::WheelDown,*this ) );
 }
\ No newline at end of file
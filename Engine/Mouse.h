@@ -19,7 +19,7 @@
  *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
  ******************************************************************************************/
 #pragma once
-#include <queue>
+#include "FixedQueue.h"
 #include "Vei2.h"
 
 class Mouse
@@ -105,7 +105,7 @@ public:
 	Mouse::Event Read();
 	bool IsEmpty() const
 	{
-		return buffer.empty();
+		return buffer.IsEmpty();
 	}
 	void Flush();
 private:
@@ -118,7 +118,6 @@ private:
 	void OnRightReleased( int x,int y );
 	void OnWheelUp( int x,int y );
 	void OnWheelDown( int x,int y );
-	void TrimBuffer();
 private:
 	static constexpr unsigned int bufferSize = 4u;
 	int x;
@@ -126,5 +125,6 @@ private:
 	bool leftIsPressed = false;
 	bool rightIsPressed = false;
 	bool isInWindow = false;
-	std::queue<Event> buffer;
+	// only the latest bufferSize events are kept
+	FixedQueue<Event,bufferSize> buffer;
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "RiffReader.h"
+#include <assert.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+	bool FourCCEquals( const char* pId,const char* pFourcc )
+	{
+		assert( strlen( pFourcc ) == 4 );
+		return memcmp( pId,pFourcc,4 ) == 0;
+	}
+}
+
+bool RiffReader::Chunk::Is( const char* fourcc ) const
+{
+	return FourCCEquals( id,fourcc );
+}
+
+RiffReader::RiffReader( std::istream& file,const char* formType_in )
+	:
+	file( file )
+{
+	file.seekg( 0,std::ios::end );
+	const std::streamoff fileSize = file.tellg();
+	file.seekg( 0 );
+
+	char header[12];
+	if( fileSize < std::streamoff( sizeof( header ) ) )
+	{
+		throw std::runtime_error( "file too small" );
+	}
+	file.read( header,sizeof( header ) );
+	if( !FourCCEquals( header,"RIFF" ) )
+	{
+		throw std::runtime_error( "Bad fourcc code" );
+	}
+	memcpy( formType,&header[8],sizeof( formType ) );
+	if( !FormTypeIs( formType_in ) )
+	{
+		throw std::runtime_error( "Bad RIFF form type" );
+	}
+	uint32_t riffSize;
+	memcpy( &riffSize,&header[4],sizeof( riffSize ) );
+	// don't trust the header past the end of the file
+	pos = std::streamoff( sizeof( header ) );
+	end = std::min( std::streamoff( riffSize ) + 8,fileSize );
+}
+
+RiffReader::RiffReader( std::istream& file,std::streamoff begin,std::streamoff end )
+	:
+	file( file ),
+	pos( begin ),
+	end( end )
+{}
+
+RiffReader RiffReader::OpenList( const Chunk& list ) const
+{
+	assert( list.Is( "LIST" ) );
+	if( list.size < 4u )
+	{
+		throw std::runtime_error( "LIST chunk too small" );
+	}
+	RiffReader reader( file,list.offset + 4,list.offset + list.size );
+	Read( list,0u,reader.formType,sizeof( reader.formType ) );
+	return reader;
+}
+
+bool RiffReader::FormTypeIs( const char* fourcc ) const
+{
+	return FourCCEquals( formType,fourcc );
+}
+
+bool RiffReader::Next( Chunk& chunk )
+{
+	if( pos + 8 > end )
+	{
+		return false;
+	}
+	char header[8];
+	file.seekg( pos );
+	file.read( header,sizeof( header ) );
+	uint32_t size;
+	memcpy( chunk.id,header,sizeof( chunk.id ) );
+	memcpy( &size,&header[4],sizeof( size ) );
+	chunk.offset = pos + 8;
+	chunk.size = uint32_t( std::min( std::streamoff( size ),end - chunk.offset ) );
+	// chunk bodies are padded to an even size
+	pos = chunk.offset + std::streamoff( size ) + (size & 1u);
+	return true;
+}
+
+size_t RiffReader::Read( const Chunk& chunk,size_t offset,void* pDst,size_t nBytes ) const
+{
+	if( offset >= chunk.size )
+	{
+		return 0u;
+	}
+	const size_t nRead = std::min( nBytes,size_t( chunk.size ) - offset );
+	file.seekg( chunk.offset + std::streamoff( offset ) );
+	file.read( reinterpret_cast<char*>( pDst ),nRead );
+	return nRead;
+}
+
+MemoryStreamBuf::MemoryStreamBuf( const void* pData,size_t size )
+{
+	// the get area is the whole image, nothing ever writes through these pointers
+	char* const pBegin = const_cast<char*>( static_cast<const char*>( pData ) );
+	setg( pBegin,pBegin,pBegin + size );
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff( off_type off,std::ios_base::seekdir dir,std::ios_base::openmode which )
+{
+	off_type base = 0;
+	if( dir == std::ios_base::cur )
+	{
+		base = gptr() - eback();
+	}
+	else if( dir == std::ios_base::end )
+	{
+		base = egptr() - eback();
+	}
+	return seekpos( pos_type( base + off ),which );
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos( pos_type pos,std::ios_base::openmode which )
+{
+	const off_type offset = off_type( pos );
+	if( !(which & std::ios_base::in) || offset < 0 || offset > egptr() - eback() )
+	{
+		return pos_type( off_type( -1 ) );
+	}
+	setg( eback(),eback() + offset,egptr() );
+	return pos;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <streambuf>
+
+// walks the chunks of a RIFF file header by header, seeking over the chunk bodies
+// (finding a chunk costs the same no matter how much sample data sits in front of it)
+// malformed files throw std::runtime_error
+class RiffReader
+{
+public:
+	struct Chunk
+	{
+		bool Is( const char* fourcc ) const;
+		char id[4];
+		// clamped to what is actually in the file
+		uint32_t size;
+		// where the chunk body starts
+		std::streamoff offset;
+	};
+public:
+	// reads the RIFF header and checks its form type (e.g. "WAVE")
+	RiffReader( std::istream& file,const char* formType );
+	// reader over the sub-chunks of a LIST chunk (its form type is the list type, e.g. "adtl")
+	RiffReader OpenList( const Chunk& list ) const;
+	bool FormTypeIs( const char* fourcc ) const;
+	// false when there are no more chunks
+	bool Next( Chunk& chunk );
+	// reads up to nBytes of a chunk body starting offset bytes in, returns the number of bytes read
+	size_t Read( const Chunk& chunk,size_t offset,void* pDst,size_t nBytes ) const;
+private:
+	RiffReader( std::istream& file,std::streamoff begin,std::streamoff end );
+private:
+	std::istream& file;
+	char formType[4] = {};
+	std::streamoff pos;
+	std::streamoff end;
+};
+
+// read-only seekable stream buffer over a file image that is already in memory
+// (wrap it in a std::istream to hand a mapped file to a RiffReader)
+class MemoryStreamBuf : public std::streambuf
+{
+public:
+	MemoryStreamBuf( const void* pData,size_t size );
+protected:
+	pos_type seekoff( off_type off,std::ios_base::seekdir dir,std::ios_base::openmode which ) override;
+	pos_type seekpos( pos_type pos,std::ios_base::openmode which ) override;
+};
\ No newline at end of file
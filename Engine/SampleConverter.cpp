@@ -0,0 +1,333 @@
+#include "SampleConverter.h"
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#define CHILI_CONVERTER_SSE2
+#include <emmintrin.h>
+#endif
+
+bool SampleConverter::GetEncoding( unsigned int formatTag,unsigned int bitsPerSample,Encoding& encoding )
+{
+	// WAVE_FORMAT_PCM / WAVE_FORMAT_IEEE_FLOAT
+	if( formatTag == 1u )
+	{
+		switch( bitsPerSample )
+		{
+		case 8u:
+			encoding = Encoding::UInt8;
+			return true;
+		case 16u:
+			encoding = Encoding::Int16;
+			return true;
+		case 24u:
+			encoding = Encoding::Int24;
+			return true;
+		case 32u:
+			encoding = Encoding::Int32;
+			return true;
+		}
+	}
+	else if( formatTag == 3u && bitsPerSample == 32u )
+	{
+		encoding = Encoding::Float32;
+		return true;
+	}
+	return false;
+}
+
+size_t SampleConverter::GetBytesPerSample( Encoding encoding )
+{
+	switch( encoding )
+	{
+	case Encoding::UInt8:
+		return 1u;
+	case Encoding::Int16:
+		return 2u;
+	case Encoding::Int24:
+		return 3u;
+	default:
+		return 4u;
+	}
+}
+
+std::unique_ptr<unsigned char[]> SampleConverter::Convert( const unsigned char* pSrc,size_t nSrcBytes,
+	const Format& srcFormat,unsigned int dstSampleRate,size_t& nDstBytes )
+{
+	assert( srcFormat.nChannels > 0u && srcFormat.sampleRate > 0u );
+	const size_t nSrcFrames = nSrcBytes / (GetBytesPerSample( srcFormat.encoding ) * srcFormat.nChannels);
+
+	std::unique_ptr<unsigned char[]> pDst;
+	if( srcFormat.sampleRate == dstSampleRate )
+	{
+		std::vector<float> left( nSrcFrames );
+		std::vector<float> right( nSrcFrames );
+		Decode( pSrc,nSrcFrames,srcFormat,left.data(),right.data() );
+		nDstBytes = nSrcFrames * 2u * sizeof( int16_t );
+		pDst = std::make_unique<unsigned char[]>( nDstBytes );
+		Pack( left.data(),right.data(),nSrcFrames,reinterpret_cast<int16_t*>( pDst.get() ) );
+	}
+	else
+	{
+		const Resampler resampler( srcFormat.sampleRate,dstSampleRate );
+		const size_t pad = resampler.GetPadding();
+		std::vector<float> left( nSrcFrames + 2u * pad );
+		std::vector<float> right( nSrcFrames + 2u * pad );
+		Decode( pSrc,nSrcFrames,srcFormat,&left[pad],&right[pad] );
+
+		const size_t nDstFrames = resampler.GetOutputFrames( nSrcFrames );
+		std::vector<float> leftOut( nDstFrames );
+		std::vector<float> rightOut( nDstFrames );
+		resampler.Process( &left[pad],nSrcFrames,leftOut.data() );
+		resampler.Process( &right[pad],nSrcFrames,rightOut.data() );
+		nDstBytes = nDstFrames * 2u * sizeof( int16_t );
+		pDst = std::make_unique<unsigned char[]>( nDstBytes );
+		Pack( leftOut.data(),rightOut.data(),nDstFrames,reinterpret_cast<int16_t*>( pDst.get() ) );
+	}
+	return pDst;
+}
+
+void SampleConverter::Decode( const unsigned char* pSrc,size_t nFrames,const Format& srcFormat,float* pLeft,float* pRight )
+{
+	const size_t nChannels = srcFormat.nChannels;
+	const size_t iRight = nChannels > 1u ? 1u : 0u;
+	size_t n = 0u;
+	switch( srcFormat.encoding )
+	{
+	case Encoding::UInt8:
+		for( ; n < nFrames; n++ )
+		{
+			pLeft[n] = (float( pSrc[n * nChannels] ) - 128.0f) * (1.0f / 128.0f);
+			pRight[n] = (float( pSrc[n * nChannels + iRight] ) - 128.0f) * (1.0f / 128.0f);
+		}
+		break;
+	case Encoding::Int16:
+	{
+		const int16_t* const pIn = reinterpret_cast<const int16_t*>( pSrc );
+#ifdef CHILI_CONVERTER_SSE2
+		const __m128 vScale = _mm_set1_ps( 1.0f / 32768.0f );
+		if( nChannels == 2u )
+		{
+			// 4 frames per iteration: sign extend, convert, split into left and right
+			for( ; n + 4u <= nFrames; n += 4u )
+			{
+				const __m128i s = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &pIn[n * 2u] ) );
+				const __m128 lo = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( s,s ),16 ) ),vScale );
+				const __m128 hi = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( s,s ),16 ) ),vScale );
+				_mm_storeu_ps( &pLeft[n],_mm_shuffle_ps( lo,hi,_MM_SHUFFLE( 2,0,2,0 ) ) );
+				_mm_storeu_ps( &pRight[n],_mm_shuffle_ps( lo,hi,_MM_SHUFFLE( 3,1,3,1 ) ) );
+			}
+		}
+		else if( nChannels == 1u )
+		{
+			for( ; n + 8u <= nFrames; n += 8u )
+			{
+				const __m128i s = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &pIn[n] ) );
+				const __m128 lo = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( s,s ),16 ) ),vScale );
+				const __m128 hi = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( s,s ),16 ) ),vScale );
+				_mm_storeu_ps( &pLeft[n],lo );
+				_mm_storeu_ps( &pLeft[n + 4u],hi );
+				_mm_storeu_ps( &pRight[n],lo );
+				_mm_storeu_ps( &pRight[n + 4u],hi );
+			}
+		}
+#endif
+		for( ; n < nFrames; n++ )
+		{
+			pLeft[n] = float( pIn[n * nChannels] ) * (1.0f / 32768.0f);
+			pRight[n] = float( pIn[n * nChannels + iRight] ) * (1.0f / 32768.0f);
+		}
+		break;
+	}
+	case Encoding::Int24:
+	{
+		const auto Read24 = [pSrc]( size_t i )
+		{
+			// top byte into the top of an int32, then shift back down to sign extend
+			const int32_t v = int32_t( uint32_t( pSrc[i * 3u] ) << 8 |
+				uint32_t( pSrc[i * 3u + 1u] ) << 16 |
+				uint32_t( pSrc[i * 3u + 2u] ) << 24 );
+			return float( v >> 8 ) * (1.0f / 8388608.0f);
+		};
+		for( ; n < nFrames; n++ )
+		{
+			pLeft[n] = Read24( n * nChannels );
+			pRight[n] = Read24( n * nChannels + iRight );
+		}
+		break;
+	}
+	case Encoding::Int32:
+	{
+		const int32_t* const pIn = reinterpret_cast<const int32_t*>( pSrc );
+#ifdef CHILI_CONVERTER_SSE2
+		if( nChannels == 2u )
+		{
+			const __m128 vScale = _mm_set1_ps( 1.0f / 2147483648.0f );
+			for( ; n + 4u <= nFrames; n += 4u )
+			{
+				const __m128 a = _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( &pIn[n * 2u] ) ) ),vScale );
+				const __m128 b = _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( &pIn[n * 2u + 4u] ) ) ),vScale );
+				_mm_storeu_ps( &pLeft[n],_mm_shuffle_ps( a,b,_MM_SHUFFLE( 2,0,2,0 ) ) );
+				_mm_storeu_ps( &pRight[n],_mm_shuffle_ps( a,b,_MM_SHUFFLE( 3,1,3,1 ) ) );
+			}
+		}
+#endif
+		for( ; n < nFrames; n++ )
+		{
+			pLeft[n] = float( pIn[n * nChannels] ) * (1.0f / 2147483648.0f);
+			pRight[n] = float( pIn[n * nChannels + iRight] ) * (1.0f / 2147483648.0f);
+		}
+		break;
+	}
+	case Encoding::Float32:
+	{
+		const float* const pIn = reinterpret_cast<const float*>( pSrc );
+#ifdef CHILI_CONVERTER_SSE2
+		if( nChannels == 2u )
+		{
+			for( ; n + 4u <= nFrames; n += 4u )
+			{
+				const __m128 a = _mm_loadu_ps( &pIn[n * 2u] );
+				const __m128 b = _mm_loadu_ps( &pIn[n * 2u + 4u] );
+				_mm_storeu_ps( &pLeft[n],_mm_shuffle_ps( a,b,_MM_SHUFFLE( 2,0,2,0 ) ) );
+				_mm_storeu_ps( &pRight[n],_mm_shuffle_ps( a,b,_MM_SHUFFLE( 3,1,3,1 ) ) );
+			}
+		}
+#endif
+		for( ; n < nFrames; n++ )
+		{
+			pLeft[n] = pIn[n * nChannels];
+			pRight[n] = pIn[n * nChannels + iRight];
+		}
+		break;
+	}
+	}
+}
+
+void SampleConverter::Pack( const float* pLeft,const float* pRight,size_t nFrames,int16_t* pDst )
+{
+	size_t n = 0u;
+#ifdef CHILI_CONVERTER_SSE2
+	// cvtps rounds to nearest, packs saturates to int16
+	const __m128 vScale = _mm_set1_ps( 32768.0f );
+	for( ; n + 4u <= nFrames; n += 4u )
+	{
+		const __m128 l = _mm_mul_ps( _mm_loadu_ps( &pLeft[n] ),vScale );
+		const __m128 r = _mm_mul_ps( _mm_loadu_ps( &pRight[n] ),vScale );
+		const __m128i lo = _mm_cvtps_epi32( _mm_unpacklo_ps( l,r ) );
+		const __m128i hi = _mm_cvtps_epi32( _mm_unpackhi_ps( l,r ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( &pDst[n * 2u] ),_mm_packs_epi32( lo,hi ) );
+	}
+#endif
+	const auto ToInt16 = []( float s )
+	{
+		return int16_t( std::max( std::min( std::lrint( s * 32768.0f ),32767l ),-32768l ) );
+	};
+	for( ; n < nFrames; n++ )
+	{
+		pDst[n * 2u] = ToInt16( pLeft[n] );
+		pDst[n * 2u + 1u] = ToInt16( pRight[n] );
+	}
+}
+
+SampleConverter::Resampler::Resampler( unsigned int srcRate,unsigned int dstRate )
+	:
+	srcRate( srcRate ),
+	dstRate( dstRate )
+{
+	assert( srcRate > 0u && dstRate > 0u );
+	// cutoff relative to the source nyquist, pulled in a bit to leave room for the transition band
+	const double cutoff = 0.95 * std::min( 1.0,double( dstRate ) / double( srcRate ) );
+	const double halfWidth = double( nZeroCrossings ) / cutoff;
+	// round the tap count up to whole simd vectors
+	nTaps = (size_t( std::ceil( halfWidth ) ) * 2u + 3u) & ~size_t( 3u );
+
+	// kaiser window
+	const double beta = 8.0;
+	const auto BesselI0 = []( double x )
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for( int k = 1; k < 32; k++ )
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	};
+	const double pi = 3.14159265358979323846;
+	const double i0Beta = BesselI0( beta );
+	const double center = double( nTaps / 2u - 1u );
+
+	// one row of taps per fractional position, phase nPhases is the next sample's phase 0
+	coefficients.resize( (nPhases + 1u) * nTaps );
+	for( size_t p = 0u; p <= nPhases; p++ )
+	{
+		const double frac = double( p ) / double( nPhases );
+		float* const pRow = &coefficients[p * nTaps];
+		double sum = 0.0;
+		for( size_t k = 0u; k < nTaps; k++ )
+		{
+			// distance of tap k from the output position
+			const double t = double( k ) - center - frac;
+			const double x = cutoff * t;
+			const double sinc = x == 0.0 ? 1.0 : std::sin( pi * x ) / (pi * x);
+			const double w = t / halfWidth;
+			const double window = std::abs( w ) >= 1.0 ? 0.0 : BesselI0( beta * std::sqrt( 1.0 - w * w ) ) / i0Beta;
+			pRow[k] = float( sinc * window );
+			sum += sinc * window;
+		}
+		// unity gain at dc for every phase
+		for( size_t k = 0u; k < nTaps; k++ )
+		{
+			pRow[k] = float( pRow[k] / sum );
+		}
+	}
+}
+
+size_t SampleConverter::Resampler::GetOutputFrames( size_t nSrcFrames ) const
+{
+	return size_t( (uint64_t( nSrcFrames ) * dstRate + srcRate - 1u) / srcRate );
+}
+
+size_t SampleConverter::Resampler::GetPadding() const
+{
+	return nTaps;
+}
+
+void SampleConverter::Resampler::Process( const float* pSrc,size_t nSrcFrames,float* pDst ) const
+{
+	const size_t nDstFrames = GetOutputFrames( nSrcFrames );
+	// 32.32 fixed point source position
+	const uint64_t step = (uint64_t( srcRate ) << 32) / dstRate;
+	uint64_t pos = 0u;
+	for( size_t n = 0u; n < nDstFrames; n++,pos += step )
+	{
+		const size_t i = size_t( pos >> 32 );
+		const size_t phase = size_t( ((pos & 0xFFFFFFFFu) * nPhases + 0x80000000u) >> 32 );
+		const float* const pRow = &coefficients[phase * nTaps];
+		// first tap sits center samples before i
+		const float* const pIn = &pSrc[i] - (nTaps / 2u - 1u);
+		size_t k = 0u;
+		float sum;
+#ifdef CHILI_CONVERTER_SSE2
+		__m128 acc = _mm_setzero_ps();
+		for( ; k < nTaps; k += 4u )
+		{
+			acc = _mm_add_ps( acc,_mm_mul_ps( _mm_loadu_ps( &pIn[k] ),_mm_loadu_ps( &pRow[k] ) ) );
+		}
+		acc = _mm_add_ps( acc,_mm_movehl_ps( acc,acc ) );
+		acc = _mm_add_ss( acc,_mm_shuffle_ps( acc,acc,_MM_SHUFFLE( 1,1,1,1 ) ) );
+		sum = _mm_cvtss_f32( acc );
+#else
+		sum = 0.0f;
+		for( ; k < nTaps; k++ )
+		{
+			sum += pIn[k] * pRow[k];
+		}
+#endif
+		pDst[n] = sum;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// turns pcm in whatever format a wave file comes in into the interleaved 16-bit stereo
+// the mixer plays, at the mixer's sample rate (done once at load time)
+// decode / pack kernels are SSE2 with scalar fallbacks, the resampler is a windowed sinc
+class SampleConverter
+{
+public:
+	enum class Encoding
+	{
+		UInt8,
+		Int16,
+		Int24,
+		Int32,
+		Float32
+	};
+	struct Format
+	{
+		Encoding encoding;
+		unsigned int nChannels;
+		unsigned int sampleRate;
+	};
+public:
+	// returns false for formats we can't convert
+	static bool GetEncoding( unsigned int formatTag,unsigned int bitsPerSample,Encoding& encoding );
+	static size_t GetBytesPerSample( Encoding encoding );
+	// more than two channels keeps the first two (front left / right)
+	static std::unique_ptr<unsigned char[]> Convert( const unsigned char* pSrc,size_t nSrcBytes,
+		const Format& srcFormat,unsigned int dstSampleRate,size_t& nDstBytes );
+	// the stages Convert is made of
+	// decode to planar float [-1,1), mono is duplicated into both channels
+	static void Decode( const unsigned char* pSrc,size_t nFrames,const Format& srcFormat,float* pLeft,float* pRight );
+	// saturating float -> interleaved int16
+	static void Pack( const float* pLeft,const float* pRight,size_t nFrames,int16_t* pDst );
+	class Resampler
+	{
+	public:
+		Resampler( unsigned int srcRate,unsigned int dstRate );
+		size_t GetOutputFrames( size_t nSrcFrames ) const;
+		// source arrays need GetPadding() readable (zero) samples before and after them
+		size_t GetPadding() const;
+		void Process( const float* pSrc,size_t nSrcFrames,float* pDst ) const;
+	private:
+		static constexpr size_t nPhases = 512u;
+		// zero crossings of the sinc on each side of the center
+		static constexpr size_t nZeroCrossings = 16u;
+		unsigned int srcRate;
+		unsigned int dstRate;
+		size_t nTaps;
+		std::vector<float> coefficients;
+	};
+};
\ No newline at end of file
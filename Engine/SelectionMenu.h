@@ -126,6 +126,13 @@ public:
 		}
 		return Size::Invalid;
 	}
+	// hover stays silent until its sound has finished loading
+	void SetHoverSound( Sound snd )
+	{
+		hover = std::move( snd );
+		// hover spam gives way to anything else that wants a channel
+		hover.SetPriority( Sound::Priority::Low );
+	}
 	void Draw( Graphics& gfx ) const
 	{
 		for( const auto& n : entries )
@@ -143,6 +150,6 @@ private:
 	}
 private:
 	static constexpr int verticalSpacing = SpriteCodex::sizeselHeight * 2;
-	Sound hover = { L"menu_boop.wav" };
+	Sound hover;
 	Entry entries[int( Size::Count )];
 };
\ No newline at end of file
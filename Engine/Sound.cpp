@@ -19,16 +19,51 @@
  *	along with this source code.  If not, see <http://www.gnu.org/licenses/>.			  *
  ******************************************************************************************/
 #include "Sound.h"
+#include "RiffReader.h"
+#include "SampleConverter.h"
+#include "StartupProfiler.h"
+#include "HotCounters.h"
+#include "Trace.h"
+#include "AllocTracker.h"
+#include "WideFile.h"
+#include "XAudioSink.h"
 #include <assert.h>
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <fstream>
-#include <array>
-#include <functional>
-#include "XAudio\XAudio2.h"
-#include "DXErr.h"
+#include <vector>
+#include <string>
+#include <chrono>
 
-#define CHILI_SOUND_API_EXCEPTION( hr,note ) SoundSystem::APIException( hr,_CRT_WIDE(__FILE__),__LINE__,note )
-#define CHILI_SOUND_FILE_EXCEPTION( filename,note ) SoundSystem::FileException( _CRT_WIDE(__FILE__),__LINE__,note,filename )
+// _CRT_WIDE( __FILE__ ) without needing the msvc crt for it
+#define CHILI_SOUND_WIDEN2( s ) L ## s
+#define CHILI_SOUND_WIDEN( s ) CHILI_SOUND_WIDEN2( s )
+#define CHILI_SOUND_FILE_EXCEPTION( filename,note ) SoundSystem::FileException( CHILI_SOUND_WIDEN( __FILE__ ),__LINE__,note,filename )
+
+namespace
+{
+	// format tags of the fmt chunk (mmreg.h calls them WAVE_FORMAT_PCM and WAVE_FORMAT_EXTENSIBLE)
+	constexpr uint16_t waveFormatPcm = 1u;
+	constexpr uint16_t waveFormatExtensible = 0xFFFEu;
+	static_assert(sizeof( SoundSystem::WaveFormat ) == 18u,"WaveFormat has to match the fmt chunk layout");
+
+	// ascii only, which is all cue labels ever are
+	bool EqualsNoCase( const char* a,const char* b )
+	{
+		for( ; *a && *b; a++,b++ )
+		{
+			if( std::tolower( static_cast<unsigned char>( *a ) ) != std::tolower( static_cast<unsigned char>( *b ) ) )
+			{
+				return false;
+			}
+		}
+		return *a == *b;
+	}
+}
+
+SoundSystem::Device SoundSystem::device = SoundSystem::Device::XAudio2;
+std::string SoundSystem::deviceFileName;
 
 SoundSystem& SoundSystem::Get()
 {
@@ -36,284 +71,800 @@ SoundSystem& SoundSystem::Get()
 	return instance;
 }
 
- void SoundSystem::SetMasterVolume( float vol )
- {
-	 HRESULT hr;
-	 if( FAILED( hr = Get().pMaster->SetVolume( vol ) ) )
-	 {
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Setting master volume" );
-	 }
- }
+void SoundSystem::SetDevice( Device device_in,const std::string& waveFileName )
+{
+	device = device_in;
+	deviceFileName = waveFileName;
+}
+
+void SoundSystem::SetMasterVolume( float vol )
+{
+	Get().masterVolume = vol;
+}
+
+const SoundSystem::WaveFormat& SoundSystem::GetFormat()
+{
+	return Get().format;
+}
+
+SoundSystem::MixStats SoundSystem::GetMixStats()
+{
+	const SoundSystem& sys = Get();
+	return { sys.nBlocksMixed,sys.nVoiceBlocksMixed,sys.mixNanoseconds,sys.nDecodedFrames,sys.decodeNanoseconds };
+}
 
-const WAVEFORMATEX& SoundSystem::GetFormat()
+SoundSystem::ChannelStats SoundSystem::GetChannelStats()
 {
-	return *Get().format;
+	const SoundSystem& sys = Get();
+	return { sys.nChannelsStarted,sys.nStolen,sys.nDropped,sys.nAcquireRetries,sys.nReleaseRetries };
 }
 
 void SoundSystem::PlaySoundBuffer( Sound & s,float freqMod,float vol )
 {
-	std::lock_guard<std::mutex> lock( mutex );
-	if( idleChannelPtrs.size() > 0 )
+	CHILI_ALLOC_SCOPE( Sound );
+	uint32_t i = AcquireChannel();
+	if( i == nullChannel )
+	{
+		i = StealChannel( s.priority );
+		if( i == nullChannel )
+		{
+			nDropped.fetch_add( 1u,std::memory_order_relaxed );
+			return;
+		}
+		nStolen.fetch_add( 1u,std::memory_order_relaxed );
+	}
+	try
 	{
-		activeChannelPtrs.push_back( std::move( idleChannelPtrs.back() ) );
-		idleChannelPtrs.pop_back();
-		activeChannelPtrs.back()->PlaySoundBuffer( s,freqMod,vol );
+		pChannels[i].PlaySoundBuffer( s,freqMod,vol );
 	}
+	catch( ... )
+	{
+		ReleaseChannel( pChannels[i] );
+		throw;
+	}
+	if( s.storage == Sound::Storage::Streaming )
+	{
+		WakeStreamThread();
+	}
+	else
+	{
+		// a thief can find it right away, not only once the mixer got around to listing it
+		PushStarted( i,s.priority );
+	}
+	nChannelsStarted.fetch_add( 1u,std::memory_order_relaxed );
+	CHILI_HOT_COUNT( VoicesStarted,1u );
 }
 
-SoundSystem::XAudioDll::XAudioDll()
+uint32_t SoundSystem::AcquireChannel()
 {
-	LoadType type = LoadType::System;
+	uint64_t head = freeHead;
+	uint32_t i;
 	while( true )
 	{
-		hModule = LoadLibrary( GetDllPath( type ) );
-		if( hModule != 0 )
+		i = uint32_t( head );
+		if( i == nullChannel )
 		{
-			return;
+			return nullChannel;
+		}
+		const uint64_t next = (((head >> 32) + 1u) << 32) | pChannels[i].nextFree;
+		if( freeHead.compare_exchange_strong( head,next ) )
+		{
+			break;
+		}
+		nAcquireRetries.fetch_add( 1u,std::memory_order_relaxed );
+	}
+	pChannels[i].state = Channel::State::Starting;
+	return i;
+}
+
+uint32_t SoundSystem::StealChannel( Priority priority )
+{
+	// first voice we found the mixer holding, asked to go if nothing else turns up
+	uint32_t held = nullChannel;
+	uint32_t heldSerial = 0u;
+	for( int p = 0; p <= int( priority ); p++ )
+	{
+		// start at the oldest voice of this priority, whatever the (possibly stale) links
+		// lead us to is validated after claiming it
+		uint32_t i = oldestChannels[p];
+		for( size_t n = 0u; i != nullChannel && n < nStealCandidates; n++ )
+		{
+			const uint32_t next = pChannels[i].newer;
+			if( ClaimVictim( i,p,held,heldSerial ) )
+			{
+				return i;
+			}
+			i = next;
+		}
+		// a burst of starts within one block leaves the lists short, so also look at the
+		// voices the mixer hasn't listed yet (newest first, same validation)
+		i = startedChannels[p];
+		for( size_t n = 0u; i != nullChannel && n < nStealCandidates; n++ )
+		{
+			const uint32_t next = pChannels[i].nextStarted;
+			if( ClaimVictim( i,p,held,heldSerial ) )
+			{
+				return i;
+			}
+			i = next;
+		}
+	}
+	if( priority == Priority::Critical )
+	{
+		return StealAnyChannel();
+	}
+	if( held != nullChannel )
+	{
+		// the mixer frees it once it's done with the block, rather than us waiting on that
+		pChannels[held].stealSerial = heldSerial;
+	}
+	return nullChannel;
+}
+
+uint32_t SoundSystem::StealAnyChannel()
+{
+	while( true )
+	{
+		uint32_t victim = nullChannel;
+		int victimPriority = int( Priority::Count );
+		bool held = false;
+		for( uint32_t i = 0u; i < nChannels; i++ )
+		{
+			const Channel& chan = pChannels[i];
+			const Channel::State state = chan.state;
+			const int p = int( chan.priority.load() );
+			if( state == Channel::State::Playing && p < victimPriority )
+			{
+				victim = i;
+				victimPriority = p;
+			}
+			else if( state == Channel::State::Mixing )
+			{
+				held = true;
+			}
+		}
+		if( victim != nullChannel )
+		{
+			Channel& chan = pChannels[victim];
+			Channel::State expected = Channel::State::Playing;
+			if( chan.state.compare_exchange_strong( expected,Channel::State::Starting ) )
+			{
+				Sound* const pSound = chan.pSound.exchange( nullptr );
+				if( pSound )
+				{
+					DropVoice( *pSound );
+				}
+				return victim;
+			}
+		}
+		else if( !held )
+		{
+			// everything is streaming or on its way in or out
+			return AcquireChannel();
 		}
 		else
 		{
-			switch( type )
+			// the mixer only holds a voice for as long as it takes to mix it
+			std::this_thread::yield();
+		}
+		// it might have let go by retiring it
+		const uint32_t i = AcquireChannel();
+		if( i != nullChannel )
+		{
+			return i;
+		}
+	}
+}
+
+bool SoundSystem::ClaimVictim( uint32_t i,int p,uint32_t& held,uint32_t& heldSerial )
+{
+	Channel& chan = pChannels[i];
+	const uint32_t serial = chan.serial;
+	Channel::State expected = Channel::State::Playing;
+	if( !chan.state.compare_exchange_strong( expected,Channel::State::Starting ) )
+	{
+		if( expected == Channel::State::Mixing && held == nullChannel && int( chan.priority.load() ) == p )
+		{
+			held = i;
+			heldSerial = serial;
+		}
+		return false;
+	}
+	// might have been restarted since it was listed, fine as long as the
+	// new voice isn't more important than the list it's sitting in
+	if( int( chan.priority.load() ) != p )
+	{
+		chan.state = Channel::State::Playing;
+		return false;
+	}
+	Sound* const pSound = chan.pSound.exchange( nullptr );
+	if( pSound )
+	{
+		DropVoice( *pSound );
+	}
+	return true;
+}
+
+void SoundSystem::ReleaseChannel( Channel& channel )
+{
+	channel.pStream.reset();
+	channel.pStreamSource.reset();
+	// whoever swaps the sound out owns the decrement (see RetargetChannels)
+	Sound* const pSound = channel.pSound.exchange( nullptr );
+	if( pSound )
+	{
+		// can't touch the sound after this, it might be destroyed right away
+		DropVoice( *pSound );
+	}
+	channel.state = Channel::State::Free;
+
+	const uint32_t i = uint32_t( &channel - pChannels.get() );
+	uint64_t head = freeHead;
+	while( true )
+	{
+		channel.nextFree = uint32_t( head );
+		const uint64_t next = (((head >> 32) + 1u) << 32) | i;
+		if( freeHead.compare_exchange_strong( head,next ) )
+		{
+			break;
+		}
+		nReleaseRetries.fetch_add( 1u,std::memory_order_relaxed );
+	}
+}
+
+void SoundSystem::StopChannels( const Sound& s,bool all )
+{
+	for( size_t i = 0u; i < nChannels; i++ )
+	{
+		Channel& chan = pChannels[i];
+		if( chan.pSound == &s )
+		{
+			// when stopping one, skip voices that are already on their way out
+			if( all )
+			{
+				chan.stopRequested = true;
+			}
+			else if( !chan.stopRequested.exchange( true ) )
 			{
-			case LoadType::System:
-				type = LoadType::Folder;
-				break;
-			case LoadType::Folder:
-				type = LoadType::Local;
-				break;
-			case LoadType::Local:
-				throw CHILI_SOUND_API_EXCEPTION(
-					HRESULT_FROM_WIN32( GetLastError() ),
-					std::wstring(
-						L"The XAudio2 DLL Could not be loaded. It is required that:\n"
-						L"A) [ " ) + std::wstring( GetDllPath( LoadType::Folder ) ) +
-					std::wstring( L" ] exist in the same folder as this executable;\n"
-						L"B) [ " ) + std::wstring( GetDllPath( LoadType::Local ) ) +
-					std::wstring( L" ] exist in the same folder as this executable; or\n"
-						L"C) [ XAudio2_7.dll ] be installed on this system via the DirectX"
-						L" Redistributable Installer Version June 2010\n" ) );
-			default:
-				assert( false && "Bad LoadType encountered in XAudio Dll loading sequence loop" );
+				return;
 			}
 		}
 	}
 }
 
-SoundSystem::XAudioDll::~XAudioDll()
+void SoundSystem::RetargetChannels( Sound& from,Sound& to )
 {
-	if( hModule != 0 )
+	for( size_t i = 0u; i < nChannels; i++ )
 	{
-		FreeLibrary( hModule );
-		hModule = 0;
+		Channel& chan = pChannels[i];
+		Sound* pExpected = &from;
+		if( chan.pSound == pExpected )
+		{
+			// count first so the new owner never reads zero while the voice is still going
+			to.nActiveChannels++;
+			if( chan.pSound.compare_exchange_strong( pExpected,&to ) )
+			{
+				DropVoice( from );
+			}
+			else
+			{
+				// lost to the voice retiring, which decrements the old owner instead
+				DropVoice( to );
+			}
+		}
 	}
 }
 
-SoundSystem::XAudioDll::operator HMODULE() const
+void SoundSystem::DropVoice( Sound& s )
 {
-	return hModule;
+	// both sides are seq_cst: either we see the waiter, or the waiter sees the zero
+	if( --s.nActiveChannels == 0 && nIdleWaiters > 0 )
+	{
+		// locking orders the notify after the waiter's check, so it can't slip in between
+		std::lock_guard<std::mutex> lock( idleMutex );
+		cvIdle.notify_all();
+	}
 }
 
-const wchar_t* SoundSystem::XAudioDll::GetDllPath( LoadType type )
+void SoundSystem::WaitForVoices( const Sound& s )
 {
-	switch( type )
+	nIdleWaiters++;
 	{
-	case LoadType::System:
-		return systemPath;
-	case LoadType::Folder:
-		return folderPath;
-	case LoadType::Local:
-		return localPath;
-	default:
-		assert( false && "Bad LoadType in GetDllPath function" );
-		return nullptr;
+		std::unique_lock<std::mutex> lock( idleMutex );
+		cvIdle.wait( lock,[&s] { return s.nActiveChannels == 0; } );
 	}
+	nIdleWaiters--;
 }
 
 SoundSystem::SoundSystem()
 	:
-	format( std::make_unique<WAVEFORMATEX>() )
+	pBus( std::make_unique<float[]>( nBlockFrames * SoundMixer::nChannels ) )
 {
-	// setup wave format info structure
-	static_assert(nChannelsPerSound > 0u,"WAVE File Format Error: At least one channel required per audio stream");
-	static_assert(nChannelsPerSound <= XAUDIO2_MAX_AUDIO_CHANNELS,"WAVE File Format Error: Maximum audio channels per audio stream exceeded");
-	static_assert(nSamplesPerSec >= XAUDIO2_MIN_SAMPLE_RATE,"WAVE File Format Error: Sample rate lower than minimum allowed");
-	static_assert(nSamplesPerSec <= XAUDIO2_MAX_SAMPLE_RATE,"WAVE File Format Error: Sample rate exceeds maximum allowed");
-	static_assert(nBitsPerSample > 0u,"WAVE File Format Error: Bit depth of 0 bits per sample is not allowed");
-	static_assert(nBitsPerSample % 8u == 0,"WAVE File Format Error: Bit depth must be multiple of 8");
-	format->nChannels = nChannelsPerSound;
-	format->nSamplesPerSec = nSamplesPerSec;
-	format->wBitsPerSample = nBitsPerSample;
-	format->nBlockAlign = (nBitsPerSample / 8) * nChannelsPerSound;
-	format->nAvgBytesPerSec = format->nBlockAlign * nSamplesPerSec;
-	format->cbSize = 0;
-	format->wFormatTag = WAVE_FORMAT_PCM;
-	
-	// find address of DllGetClassObject() function in the dll
-	const std::function<HRESULT(REFCLSID,REFIID,LPVOID)> DllGetClassObject =
-        reinterpret_cast<HRESULT(WINAPI*)(REFCLSID,REFIID,LPVOID)>( 
-		GetProcAddress( xaudio_dll,"DllGetClassObject" ) );
-	if( !DllGetClassObject )
-	{		
-		throw CHILI_SOUND_API_EXCEPTION( 
-			HRESULT_FROM_WIN32( GetLastError() ),
-			L"Getting process address of 'DllGetClassObject' function" );
-	}
+	StartupProfiler::Phase phase( "sound system" );
 
-	// create the factory class for the XAudio2 component object
-	Microsoft::WRL::ComPtr<IClassFactory> pClassFactory;
-	HRESULT hr;
-	if( FAILED( hr = DllGetClassObject( 
-		 __uuidof( XAudio2 ),
-		IID_IClassFactory,
-		pClassFactory.ReleaseAndGetAddressOf() ) ) )
+	// setup wave format info structure
+	static_assert(nChannelsPerSound == SoundMixer::nChannels,"WAVE File Format Error: Software mixer requires stereo sounds");
+	static_assert(nBitsPerSample == 16u,"WAVE File Format Error: Software mixer requires 16-bit sounds");
+	format.nChannels = nChannelsPerSound;
+	format.nSamplesPerSec = nSamplesPerSec;
+	format.wBitsPerSample = nBitsPerSample;
+	format.nBlockAlign = (nBitsPerSample / 8) * nChannelsPerSound;
+	format.nAvgBytesPerSec = format.nBlockAlign * nSamplesPerSec;
+	format.cbSize = 0;
+	format.wFormatTag = waveFormatPcm;
+
+	// open the output device
+	switch( device )
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Creating factory for XAudio2 object" );
+	case Device::XAudio2:
+#ifdef _WIN32
+		pSink = std::make_unique<XAudioSink>( uint32_t( nSamplesPerSec ),size_t( nBlockFrames ) );
+#else
+		// there is no XAudio2 to play it on, the mix still runs at device pace
+		pSink = std::make_unique<NullSink>( uint32_t( nSamplesPerSec ) );
+#endif
+		break;
+	case Device::Null:
+		pSink = std::make_unique<NullSink>( uint32_t( nSamplesPerSec ) );
+		break;
+	case Device::WaveFile:
+		try
+		{
+			pSink = std::make_unique<WaveFileSink>( deviceFileName,uint32_t( nSamplesPerSec ),true );
+		}
+		catch( const std::exception& )
+		{
+			throw CHILI_SOUND_FILE_EXCEPTION( std::wstring( deviceFileName.begin(),deviceFileName.end() ),L"Could not open wave file output device" );
+		}
+		break;
+	default:
+		assert( false && "Bad Device in SoundSystem constructor" );
 	}
 
-	// create the XAudio2 component object itself
-	if( FAILED( hr = pClassFactory->CreateInstance( nullptr,
-		__uuidof( IXAudio2 ),&pEngine ) ) )
+	// create channel objects, all chained into the free list
+	pChannels = std::make_unique<Channel[]>( nChannels );
+	for( uint32_t i = 0u; i < nChannels; i++ )
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Creating XAudio2 object" );
+		pChannels[i].nextFree = i + 1u < nChannels ? i + 1u : nullChannel;
 	}
-
-	// initialize the XAudio2 component object
-	if( FAILED( hr = pEngine->Initialize( 0,XAUDIO2_DEFAULT_PROCESSOR ) ) )
+	freeHead = 0u;
+	for( int p = 0; p < int( Priority::Count ); p++ )
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Initializing XAudio2 object" );
+		oldestChannels[p] = nullChannel;
+		newestChannels[p] = nullChannel;
+		startedChannels[p] = nullChannel;
 	}
 
-	// create the mastering voice
-	if( FAILED( hr = pEngine->CreateMasteringVoice( &pMaster ) ) )
+	streamThread = std::thread( &SoundSystem::StreamThreadProc,this );
+	mixerThread = std::thread( &SoundSystem::MixerThreadProc,this );
+}
+
+SoundSystem::~SoundSystem()
+{
+	mixerQuitting = true;
+	mixerThread.join();
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Creating mastering voice" );
+		std::lock_guard<std::mutex> lock( streamMutex );
+		streamQuitting = true;
+		cvStream.notify_all();
 	}
+	streamThread.join();
+}
 
-	// create channel objects
-	for( int i = 0; i < nChannels; i++ )
+void SoundSystem::MixerThreadProc()
+{
+	Trace::SetThreadName( "mixer" );
+	CHILI_ALLOC_SCOPE( Sound );
+	while( !mixerQuitting )
 	{
-		idleChannelPtrs.push_back( std::make_unique<Channel>( *this ) );
+		MixBlock();
+		try
+		{
+			pSink->Submit( pBus.get(),nBlockFrames );
+		}
+		catch( ... )
+		{
+			// output device died on us, keep mixing into the void so voices still play out
+			// (otherwise anybody waiting on a sound to finish would wait forever)
+			pSink = std::make_unique<NullSink>( uint32_t( nSamplesPerSec ) );
+		}
 	}
 }
 
-void SoundSystem::DeactivateChannel( Channel & channel )
+void SoundSystem::MixBlock()
 {
-	std::lock_guard<std::mutex> lock( mutex );
-	auto i = std::find_if( activeChannelPtrs.begin(),activeChannelPtrs.end(),
-		[&channel]( const std::unique_ptr<Channel>& pChan ) -> bool
+	const auto start = std::chrono::steady_clock::now();
+
+	SoundMixer::Clear( pBus.get(),nBlockFrames );
+	ListStartedChannels();
+	size_t nMixChannels = 0u;
+	for( uint32_t i = 0u; i < nChannels; i++ )
 	{
-		return &channel == pChan.get();
-	} );
-	idleChannelPtrs.push_back( std::move( *i ) );
-	activeChannelPtrs.erase( i );
+		Channel& chan = pChannels[i];
+		Channel::State state = chan.state;
+		// keep the steal lists in start order, voices taken over by a thief get moved to the back
+		if( chan.listed && (state != Channel::State::Playing || chan.serial != chan.listedSerial) )
+		{
+			UnlistChannel( i );
+		}
+		if( state == Channel::State::Playing )
+		{
+			if( !chan.listed )
+			{
+				ListChannel( i );
+			}
+			// claim it so that nobody steals it out from under the mixer
+			if( !chan.state.compare_exchange_strong( state,Channel::State::Mixing ) )
+			{
+				continue;
+			}
+		}
+		else if( state != Channel::State::Streaming )
+		{
+			continue;
+		}
+		nMixChannels++;
+		if( chan.stopRequested || !chan.Mix( pBus.get(),nBlockFrames ) ||
+			(state == Channel::State::Playing && chan.stealSerial == chan.serial) )
+		{
+			RetireChannel( chan );
+		}
+		else if( state == Channel::State::Playing )
+		{
+			chan.state = Channel::State::Playing;
+		}
+	}
+	SoundMixer::Finalize( pBus.get(),nBlockFrames,masterVolume );
+
+	nBlocksMixed++;
+	nVoiceBlocksMixed += nMixChannels;
+	mixNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start ).count();
 }
 
-SoundSystem::Channel::Channel( SoundSystem & sys )
-	:
-	xaBuffer( std::make_unique<XAUDIO2_BUFFER>() )
+void SoundSystem::StreamThreadProc()
 {
-	class VoiceCallback : public IXAudio2VoiceCallback
+	Trace::SetThreadName( "stream" );
+	CHILI_ALLOC_SCOPE( Sound );
+	std::unique_lock<std::mutex> lock( streamMutex );
+	while( true )
 	{
-	public:
-		void STDMETHODCALLTYPE OnStreamEnd() override
-		{}
-		void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override
-		{}
-		void STDMETHODCALLTYPE OnVoiceProcessingPassStart( UINT32 SamplesRequired ) override
-		{}
-		void STDMETHODCALLTYPE OnBufferEnd( void* pBufferContext ) override
+		// timeout covers a wakeup lost between the mixer setting the flag and us waiting
+		cvStream.wait_for( lock,std::chrono::milliseconds( 5 ),
+			[this] { return streamWorkPending || streamQuitting; } );
+		if( streamQuitting )
 		{
-			Channel& chan = *reinterpret_cast<Channel*>( pBufferContext );
-			chan.Stop();
+			return;
+		}
+		streamWorkPending = false;
+		// only this thread moves a channel out of Streaming/Retired, so the stream can't
+		// be pulled out from under us while we fill it
+		for( size_t i = 0u; i < nChannels; i++ )
+		{
+			Channel& chan = pChannels[i];
+			const Channel::State state = chan.state;
+			if( state == Channel::State::Opening )
 			{
-				std::lock_guard<std::mutex> lock( chan.pSound->mutex );
-				chan.pSound->activeChannelPtrs.erase( std::find(
-					chan.pSound->activeChannelPtrs.begin(),chan.pSound->activeChannelPtrs.end(),&chan ) );
-				// notify any thread that might be waiting for activeChannels
-				// to become zero (i.e. thread calling destructor)
-				chan.pSound->cvDeath.notify_all();
+				OpenChannelStream( chan );
+			}
+			else if( state == Channel::State::Streaming )
+			{
+				chan.pStream->Fill();
+			}
+			else if( state == Channel::State::Retired )
+			{
+				ReleaseChannel( chan );
 			}
-			chan.pSound = nullptr;
-			SoundSystem::Get().DeactivateChannel( chan );
 		}
-		void STDMETHODCALLTYPE OnBufferStart( void* pBufferContext ) override
-		{}
-		void STDMETHODCALLTYPE OnLoopEnd( void* pBufferContext ) override
-		{}
-		void STDMETHODCALLTYPE OnVoiceError( void* pBufferContext,HRESULT Error ) override
-		{}
-	};
-	static VoiceCallback vcb;
-	ZeroMemory( xaBuffer.get(),sizeof( *xaBuffer ) );
-	xaBuffer->pContext = this;
-	HRESULT hr;
-	if( FAILED( hr = sys.pEngine->CreateSourceVoice( &pSource,sys.format.get(),0u,2.0f,&vcb ) ) )
+	}
+}
+
+void SoundSystem::OpenChannelStream( Channel& channel )
+{
+	// stopped before it got going
+	if( channel.stopRequested )
+	{
+		ReleaseChannel( channel );
+		return;
+	}
+	try
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Creating source voice for channel" );
+		channel.pStream = std::make_unique<WaveStream>( *channel.pStreamSource );
+		channel.pStream->Fill();
+	}
+	catch( const std::exception& )
+	{
+		// the file went away since the sound was loaded, the voice never starts
+		nDropped.fetch_add( 1u,std::memory_order_relaxed );
+		ReleaseChannel( channel );
+		return;
 	}
+	channel.state = Channel::State::Streaming;
 }
 
-SoundSystem::Channel::~Channel()
+void SoundSystem::WakeStreamThread()
 {
-	assert( !pSound );
-	if( pSource )
+	// deliberately lock-free, the mixer thread must not wait on the stream thread's file io
+	streamWorkPending = true;
+	cvStream.notify_one();
+}
+
+void SoundSystem::ListChannel( uint32_t i )
+{
+	Channel& chan = pChannels[i];
+	const int p = int( chan.priority.load() );
+	chan.listedPriority = Priority( p );
+	chan.listedSerial = chan.serial.load();
+	chan.older = newestChannels[p];
+	chan.newer = nullChannel;
+	if( newestChannels[p] != nullChannel )
+	{
+		pChannels[newestChannels[p]].newer = i;
+	}
+	else
 	{
-		pSource->DestroyVoice();
-		pSource = nullptr;
+		oldestChannels[p] = i;
 	}
+	newestChannels[p] = i;
+	chan.listed = true;
 }
 
-void SoundSystem::Channel::PlaySoundBuffer( Sound& s,float freqMod,float vol )
+void SoundSystem::PushStarted( uint32_t i,Priority priority )
 {
-	assert( pSource && !pSound );
+	Channel& chan = pChannels[i];
+	// already on a stack if a thief restarted it before the mixer got to it, it keeps its
+	// old place there (and the mixer lists it by the priority it has by then)
+	if( chan.onStarted.exchange( true ) )
+	{
+		return;
+	}
+	// only the mixer ever pops, and it takes the whole stack at once, so no ABA tag needed
+	std::atomic<uint32_t>& top = startedChannels[int( priority )];
+	uint32_t next = top;
+	do
 	{
-		std::lock_guard<std::mutex> lock( s.mutex );
-		s.activeChannelPtrs.push_back( this );
+		chan.nextStarted = next;
 	}
-	// callback thread not running yet, so no sync necessary for pSound
-	pSound = &s;
-	xaBuffer->pAudioData = s.pData.get();
-	xaBuffer->AudioBytes = s.nBytes;
-	if( s.looping )
+	while( !top.compare_exchange_weak( next,i ) );
+}
+
+void SoundSystem::ListStartedChannels()
+{
+	for( int p = 0; p < int( Priority::Count ); p++ )
 	{
-		xaBuffer->LoopBegin = s.loopStart;
-		xaBuffer->LoopLength = s.loopEnd - s.loopStart;
-		xaBuffer->LoopCount = XAUDIO2_LOOP_INFINITE;
+		// newest first on the stack, flip it to list them in start order
+		uint32_t order[nChannels];
+		size_t n = 0u;
+		for( uint32_t i = startedChannels[p].exchange( nullChannel ); i != nullChannel; )
+		{
+			Channel& chan = pChannels[i];
+			order[n++] = i;
+			i = chan.nextStarted;
+			// a start that misses the stack because of this race gets listed in MixBlock
+			chan.onStarted = false;
+		}
+		while( n > 0u )
+		{
+			const uint32_t i = order[--n];
+			Channel& chan = pChannels[i];
+			if( chan.listed )
+			{
+				UnlistChannel( i );
+			}
+			if( chan.state == Channel::State::Playing )
+			{
+				ListChannel( i );
+			}
+		}
+	}
+}
+
+void SoundSystem::UnlistChannel( uint32_t i )
+{
+	Channel& chan = pChannels[i];
+	const int p = int( chan.listedPriority );
+	const uint32_t newer = chan.newer;
+	if( chan.older != nullChannel )
+	{
+		pChannels[chan.older].newer = newer;
 	}
 	else
 	{
-		xaBuffer->LoopCount = 0u;
+		oldestChannels[p] = newer;
 	}
-	HRESULT hr;
-	if( FAILED( hr = pSource->SubmitSourceBuffer( xaBuffer.get(),nullptr ) ) )
+	if( newer != nullChannel )
+	{
+		pChannels[newer].older = chan.older;
+	}
+	else
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Starting playback - submitting source buffer" );
+		newestChannels[p] = chan.older;
 	}
-	if( FAILED( hr = pSource->SetFrequencyRatio( freqMod ) ) )
+	chan.listed = false;
+}
+
+void SoundSystem::RetireChannel( Channel& channel )
+{
+	if( channel.listed )
+	{
+		UnlistChannel( uint32_t( &channel - pChannels.get() ) );
+	}
+	if( channel.state == Channel::State::Streaming )
+	{
+		// stream thread closes the stream and puts the channel back in the pool
+		channel.state = Channel::State::Retired;
+		WakeStreamThread();
+	}
+	else
+	{
+		ReleaseChannel( channel );
+	}
+}
+
+SoundSystem::Channel::~Channel()
+{
+	assert( !pSound );
+}
+
+void SoundSystem::Channel::PlaySoundBuffer( Sound& s,float freqMod,float vol_in )
+{
+	assert( state == State::Starting );
+	// mixer thread doesn't look at this channel until it's Playing, so no sync necessary here
+	stopRequested = false;
+	pos = 0u;
+	step = SoundMixer::StepFromRatio( freqMod );
+	vol = vol_in;
+	priority = s.priority;
+	serial++;
+	looping = s.looping;
+	loopStart = s.loopStart;
+	loopEnd = s.loopEnd;
+	pAdpcm = nullptr;
+	if( s.storage == Sound::Storage::Streaming )
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Starting playback - setting frequency" );
+		// the stream thread opens it and reads the first chunks, so starting a voice never
+		// waits on the disk (the mixer picks it up once it's Streaming)
+		pStreamSource = s.pStreamSource;
 	}
-	if( FAILED( hr = pSource->SetVolume( vol ) ) )
+	else if( s.adpcm )
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Starting playback - setting volume" );
+		pAdpcm = s.pSamples;
+		adpcmLayout = s.adpcmLayout;
+		nAdpcmBlocks = s.nBytes / adpcmLayout.blockAlign;
+		nFrames = s.nAdpcmFrames;
+		// only grows, so after the first few plays the mixer's buffers are all in place
+		const size_t nBatchBlocks = ImaAdpcm::GetBlocksPerBatch( adpcmLayout );
+		decoded.resize( std::max( decoded.size(),nBatchBlocks * adpcmLayout.framesPerBlock * SoundMixer::nChannels ) );
+		nDecodedBlocks = 0u;
+		if( looping )
+		{
+			// the frame the loop wraps to, for interpolating across the loop end
+			const size_t block = loopStart / adpcmLayout.framesPerBlock;
+			ImaAdpcm::Decode( &pAdpcm[block * adpcmLayout.blockAlign],1u,adpcmLayout,decoded.data() );
+			const size_t i = (loopStart - block * adpcmLayout.framesPerBlock) * SoundMixer::nChannels;
+			loopStartFrame[0] = decoded[i];
+			loopStartFrame[1] = decoded[i + 1u];
+		}
 	}
-	if( FAILED( hr = pSource->Start() ) )
+	else
 	{
-		throw CHILI_SOUND_API_EXCEPTION( hr,L"Starting playback - starting" );
+		pSamples = reinterpret_cast<const int16_t*>( s.pSamples );
+		nFrames = s.nBytes / (SoundMixer::nChannels * sizeof( int16_t ));
 	}
+	// count before publishing so a sound waiting on its voices can't miss this one
+	s.nActiveChannels++;
+	pSound = &s;
+	state = pStreamSource ? State::Opening : State::Playing;
 }
 
 void SoundSystem::Channel::Stop()
 {
-	assert( pSource && pSound );
-	pSource->Stop();
-	pSource->FlushSourceBuffers();
+	// the mixer thread retires the channel at the start of its next block
+	stopRequested = true;
 }
 
-void SoundSystem::Channel::RetargetSound( const Sound* pOld,Sound* pNew )
+bool SoundSystem::Channel::Mix( float* pBus,size_t nBusFrames )
 {
-	assert( pOld == pSound );
-	pSound = pNew;
+	const size_t frameSize = SoundMixer::nChannels * sizeof( int16_t );
+	size_t nDone = 0u;
+	while( nDone < nBusFrames )
+	{
+		if( pStream )
+		{
+			if( pStream->GetReadyCount() == 0u )
+			{
+				// either the stream thread fell behind (sit this block out) or we're done
+				return !pStream->IsExhausted();
+			}
+			size_t nBytes;
+			const int16_t* const pSrc = reinterpret_cast<const int16_t*>( pStream->GetChunk( 0u,nBytes ) );
+			const size_t nSrcFrames = nBytes / frameSize;
+			const int16_t* pNext = &pSrc[(nSrcFrames - 1u) * SoundMixer::nChannels];
+			if( pStream->GetReadyCount() > 1u )
+			{
+				size_t nNextBytes;
+				pNext = reinterpret_cast<const int16_t*>( pStream->GetChunk( 1u,nNextBytes ) );
+			}
+			nDone += SoundMixer::MixPcm16( &pBus[nDone * SoundMixer::nChannels],nBusFrames - nDone,
+				pSrc,nSrcFrames,pNext,pos,step,vol );
+			if( (pos >> SoundMixer::fracBits) >= nSrcFrames )
+			{
+				pos -= uint64_t( nSrcFrames ) << SoundMixer::fracBits;
+				pStream->PopChunk();
+				SoundSystem::Get().WakeStreamThread();
+			}
+		}
+		else if( pAdpcm )
+		{
+			// pos is in frames of the whole sound here, the decoded span is a window into it
+			const size_t nSrcFrames = looping ? loopEnd : nFrames;
+			if( nSrcFrames == 0u )
+			{
+				return false;
+			}
+			const size_t blockFrames = adpcmLayout.framesPerBlock;
+			const size_t block = size_t( pos >> SoundMixer::fracBits ) / blockFrames;
+			if( nDecodedBlocks == 0u || block < decodedBlock || block >= decodedBlock + nDecodedBlocks )
+			{
+				const auto start = std::chrono::steady_clock::now();
+				decodedBlock = block;
+				nDecodedBlocks = std::min( ImaAdpcm::GetBlocksPerBatch( adpcmLayout ),nAdpcmBlocks - block );
+				ImaAdpcm::Decode( &pAdpcm[block * adpcmLayout.blockAlign],nDecodedBlocks,adpcmLayout,decoded.data() );
+				SoundSystem& sys = SoundSystem::Get();
+				sys.nDecodedFrames.fetch_add( nDecodedBlocks * blockFrames,std::memory_order_relaxed );
+				sys.decodeNanoseconds.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start ).count(),std::memory_order_relaxed );
+			}
+			const size_t spanStart = decodedBlock * blockFrames;
+			const size_t spanEnd = std::min( spanStart + nDecodedBlocks * blockFrames,nSrcFrames );
+			int16_t nextFrame[SoundMixer::nChannels];
+			const int16_t* pNext = nextFrame;
+			if( spanEnd == nSrcFrames )
+			{
+				pNext = looping ? loopStartFrame : &decoded[(spanEnd - spanStart - 1u) * SoundMixer::nChannels];
+			}
+			else
+			{
+				// next block's header has its first frame in the clear
+				ImaAdpcm::GetFirstFrame( &pAdpcm[(decodedBlock + nDecodedBlocks) * adpcmLayout.blockAlign],
+					adpcmLayout,nextFrame );
+			}
+			uint64_t spanPos = pos - (uint64_t( spanStart ) << SoundMixer::fracBits);
+			nDone += SoundMixer::MixPcm16( &pBus[nDone * SoundMixer::nChannels],nBusFrames - nDone,
+				decoded.data(),spanEnd - spanStart,pNext,spanPos,step,vol );
+			pos = spanPos + (uint64_t( spanStart ) << SoundMixer::fracBits);
+			if( (pos >> SoundMixer::fracBits) >= nSrcFrames )
+			{
+				if( !looping )
+				{
+					return false;
+				}
+				pos -= uint64_t( loopEnd - loopStart ) << SoundMixer::fracBits;
+			}
+		}
+		else
+		{
+			const size_t nSrcFrames = looping ? loopEnd : nFrames;
+			if( nSrcFrames == 0u )
+			{
+				return false;
+			}
+			const int16_t* const pNext = looping ?
+				&pSamples[loopStart * SoundMixer::nChannels] :
+				&pSamples[(nSrcFrames - 1u) * SoundMixer::nChannels];
+			nDone += SoundMixer::MixPcm16( &pBus[nDone * SoundMixer::nChannels],nBusFrames - nDone,
+				pSamples,nSrcFrames,pNext,pos,step,vol );
+			if( (pos >> SoundMixer::fracBits) >= nSrcFrames )
+			{
+				if( !looping )
+				{
+					return false;
+				}
+				pos -= uint64_t( loopEnd - loopStart ) << SoundMixer::fracBits;
+			}
+		}
+	}
+	return true;
 }
 
 Sound::Sound( const std::wstring& fileName,bool loopingWithAutoCueDetect )
@@ -323,28 +874,39 @@ Sound::Sound( const std::wstring& fileName,bool loopingWithAutoCueDetect )
 {
 }
 
-Sound::Sound( const std::wstring& fileName,LoopType loopType )
+Sound::Sound( const std::wstring& fileName,LoopType loopType,Storage storage )
+	:
+	Sound( fileName,loopType,storage,nullSample,nullSample,nullSeconds,nullSeconds )
+{
+}
+
+Sound::Sound( const std::wstring& fileName,unsigned int loopStart,unsigned int loopEnd,Storage storage )
 	:
-	Sound( fileName,loopType,nullSample,nullSample,nullSeconds,nullSeconds )
+	Sound( fileName,LoopType::ManualSample,storage,loopStart,loopEnd,nullSeconds,nullSeconds )
 {
 }
 
-Sound::Sound( const std::wstring& fileName,unsigned int loopStart,unsigned int loopEnd )
+Sound::Sound( const std::wstring& fileName,float loopStart,float loopEnd,Storage storage )
 	:
-	Sound( fileName,LoopType::ManualSample,loopStart,loopEnd,nullSeconds,nullSeconds )
+	Sound( fileName,LoopType::ManualFloat,storage,nullSample,nullSample,loopStart,loopEnd )
 {
 }
 
-Sound::Sound( const std::wstring& fileName,float loopStart,float loopEnd )
+Sound::Sound( const unsigned char* pImage,size_t imageSize,const std::wstring& name,LoopType loopType )
 	:
-	Sound( fileName,LoopType::ManualFloat,nullSample,nullSample,loopStart,loopEnd )
+	Sound( name,loopType,Storage::Resident,nullSample,nullSample,nullSeconds,nullSeconds,pImage,imageSize )
 {
 }
 
-Sound::Sound( const std::wstring& fileName,LoopType loopType,
+Sound::Sound( const std::wstring& fileName,LoopType loopType,Storage storage,
 	unsigned int loopStartSample,unsigned int loopEndSample,
-	float loopStartSeconds,float loopEndSeconds )
+	float loopStartSeconds,float loopEndSeconds,
+	const unsigned char* pImage,size_t imageSize )
+	:
+	storage( storage )
 {
+	StartupProfiler::Phase phase( (pImage ? L"wave (packed) " : L"wave ") + fileName );
+	CHILI_TRACE_ZONE( "Sound load" );
 	// if manual float looping, second inputs cannot be null
 	assert( (loopType == LoopType::ManualFloat) !=
 		(loopStartSeconds == nullSeconds || loopEndSeconds == nullSeconds) &&
@@ -354,126 +916,251 @@ Sound::Sound( const std::wstring& fileName,LoopType loopType,
 		(loopStartSample == nullSample || loopEndSample == nullSample) &&
 		"Did you pass a LoopType::Manual to the constructor? (BAD!)" );
 
-	const auto IsFourCC = []( const BYTE* pData,const char* pFourcc )
+	try
 	{
-		assert( strlen( pFourcc ) == 4 );
-		for( int i = 0; i < 4; i++ )
+		std::ifstream file;
+		MemoryStreamBuf imageBuffer( pImage,imageSize );
+		std::istream image( &imageBuffer );
+		if( pImage )
 		{
-			if( char( pData[i] ) != pFourcc[i] )
-			{
-				return false;
-			}
+			image.exceptions( std::istream::failbit | std::istream::badbit );
 		}
-		return true;
-	};
-
-	unsigned int fileSize = 0;
-	std::unique_ptr<BYTE[]> pFileIn;
-	try
-	{
+		else
 		{
-			std::ifstream file;
 			file.exceptions( std::ifstream::failbit | std::ifstream::badbit );
-			file.open( fileName,std::ios::binary );
+			OpenWideFile( file,fileName,std::ios::binary );
+		}
 
+		// walk the chunk headers, only reading the bodies of the chunks we care about
+		// (the payload is never touched here, so parse time doesn't depend on its size)
+		RiffReader riff( pImage ? image : file,"WAVE" );
+		SoundSystem::WaveFormat format;
+		bool bFilledFormat = false;
+		RiffReader::Chunk dataChunk;
+		bool bFilledData = false;
+		// compressed formats only: samples per block (fmt extra bytes) and frame count (fact)
+		uint16_t samplesPerBlock = 0u;
+		uint32_t nFactFrames = 0u;
+		bool bFilledFact = false;
+		struct CuePoint
+		{
+			unsigned int cuePtId;
+			unsigned int pop;
+			unsigned int dataChunkId;
+			unsigned int chunkStart;
+			unsigned int blockStart;
+			unsigned int frameOffset;
+		};
+		std::vector<CuePoint> cuePts;
+		// cue point id -> label, from LIST adtl
+		std::vector<std::pair<unsigned int,std::string>> cueLabels;
+		struct SamplerLoop
+		{
+			unsigned int cuePtId;
+			unsigned int type;
+			unsigned int start;
+			// inclusive
+			unsigned int end;
+			unsigned int fraction;
+			unsigned int playCount;
+		};
+		SamplerLoop smplLoop;
+		bool bFilledSmpl = false;
+		for( RiffReader::Chunk chunk; riff.Next( chunk ); )
+		{
+			if( chunk.Is( "fmt " ) )
 			{
-				BYTE fourcc[4];
-				file.read( reinterpret_cast<char*>(fourcc),4u );
-				if( !IsFourCC( fourcc,"RIFF" ) )
+				format = {};
+				riff.Read( chunk,0u,&format,sizeof( format ) );
+				// extensible format keeps the real format tag at the front of its sub format guid
+				if( format.wFormatTag == waveFormatExtensible )
+				{
+					riff.Read( chunk,24u,&format.wFormatTag,sizeof( format.wFormatTag ) );
+				}
+				else if( format.wFormatTag == ImaAdpcm::formatTag && format.cbSize >= sizeof( samplesPerBlock ) )
 				{
-					throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"Bad fourcc code" );
+					riff.Read( chunk,sizeof( format ),&samplesPerBlock,sizeof( samplesPerBlock ) );
 				}
+				bFilledFormat = true;
 			}
-
-			file.read( reinterpret_cast<char*>(&fileSize),sizeof( fileSize ) );
-			fileSize += 8u; // entry doesn't include the fourcc or itself
-			if( fileSize <= 44u )
+			else if( chunk.Is( "fact" ) )
 			{
-				throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"file too small" );
+				bFilledFact = riff.Read( chunk,0u,&nFactFrames,sizeof( nFactFrames ) ) == sizeof( nFactFrames );
+			}
+			else if( chunk.Is( "data" ) )
+			{
+				dataChunk = chunk;
+				bFilledData = true;
+			}
+			else if( chunk.Is( "cue " ) && loopType == LoopType::AutoEmbeddedCuePoints )
+			{
+				uint32_t nCuePts = 0u;
+				riff.Read( chunk,0u,&nCuePts,sizeof( nCuePts ) );
+				// count can't be more than the chunk holds
+				nCuePts = std::min( nCuePts,uint32_t( (chunk.size - sizeof( nCuePts )) / sizeof( CuePoint ) ) );
+				cuePts.resize( nCuePts );
+				riff.Read( chunk,sizeof( nCuePts ),cuePts.data(),nCuePts * sizeof( CuePoint ) );
+			}
+			else if( chunk.Is( "LIST" ) && loopType == LoopType::AutoEmbeddedCuePoints )
+			{
+				RiffReader list = riff.OpenList( chunk );
+				if( list.FormTypeIs( "adtl" ) )
+				{
+					for( RiffReader::Chunk sub; list.Next( sub ); )
+					{
+						if( sub.Is( "labl" ) && sub.size > 4u )
+						{
+							unsigned int cuePtId;
+							std::string text( sub.size - 4u,'\0' );
+							list.Read( sub,0u,&cuePtId,sizeof( cuePtId ) );
+							list.Read( sub,4u,&text[0],text.size() );
+							text.resize( strnlen( text.c_str(),text.size() ) );
+							cueLabels.emplace_back( cuePtId,std::move( text ) );
+						}
+					}
+				}
+			}
+			else if( chunk.Is( "smpl" ) && loopType == LoopType::AutoEmbeddedSmplLoop )
+			{
+				// 9 dwords of sampler info, the 8th is the loop count
+				unsigned int header[9] = {};
+				riff.Read( chunk,0u,header,sizeof( header ) );
+				if( header[7] > 0u &&
+					riff.Read( chunk,sizeof( header ),&smplLoop,sizeof( smplLoop ) ) == sizeof( smplLoop ) )
+				{
+					bFilledSmpl = true;
+				}
 			}
-
-			file.seekg( 0,std::ios::beg );
-			pFileIn = std::make_unique<BYTE[]>( fileSize );
-			file.read( reinterpret_cast<char*>(pFileIn.get()),fileSize );
 		}
-
-		if( !IsFourCC( &pFileIn[8],"WAVE" ) )
+		if( !bFilledFormat )
 		{
-			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"format not WAVE" );
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"fmt chunk not found" );
 		}
 
-		//look for 'fmt ' chunk id
-		WAVEFORMATEX format;
-		bool bFilledFormat = false;
-		for( size_t i = 12u; i < fileSize; )
+		// anything not already in the system format goes through the converter at load time
+		const SoundSystem::WaveFormat& sysFormat = SoundSystem::GetFormat();
+		SampleConverter::Format srcFormat;
+		adpcm = format.wFormatTag == ImaAdpcm::formatTag;
+		if( adpcm )
 		{
-			if( IsFourCC( &pFileIn[i],"fmt " ) )
+			if( format.wBitsPerSample != 4u ||
+				!ImaAdpcm::MakeLayout( format.nChannels,format.nBlockAlign,samplesPerBlock,adpcmLayout ) )
 			{
-				memcpy( &format,&pFileIn[i + 8u],sizeof( format ) );
-				bFilledFormat = true;
-				break;
+				throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"unsupported IMA ADPCM layout (mono/stereo 4-bit only)" );
 			}
-			// chunk size + size entry size + chunk id entry size + word padding
-			unsigned int chunkSize;
-			memcpy( &chunkSize,&pFileIn[i + 4u],sizeof( chunkSize ) );
-			i += (chunkSize + 9u) & 0xFFFFFFFEu;
+			// what the blocks decode to, in case they need converting
+			srcFormat.encoding = SampleConverter::Encoding::Int16;
 		}
-		if( !bFilledFormat )
+		else if( !SampleConverter::GetEncoding( format.wFormatTag,format.wBitsPerSample,srcFormat.encoding ) )
 		{
-			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"fmt chunk not found" );
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"unsupported wave format (wFormatTag/wBitsPerSample)" );
+		}
+		srcFormat.nChannels = format.nChannels;
+		srcFormat.sampleRate = format.nSamplesPerSec;
+		if( srcFormat.nChannels == 0u )
+		{
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (nChannels)" );
+		}
+		else if( srcFormat.sampleRate == 0u )
+		{
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (nSamplesPerSec)" );
+		}
+		else if( !adpcm && format.nBlockAlign != srcFormat.nChannels * SampleConverter::GetBytesPerSample( srcFormat.encoding ) )
+		{
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (nBlockAlign)" );
+		}
+		const bool isSystemFormat =
+			format.wFormatTag == sysFormat.wFormatTag &&
+			format.nChannels == sysFormat.nChannels &&
+			format.wBitsPerSample == sysFormat.wBitsPerSample &&
+			format.nSamplesPerSec == sysFormat.nSamplesPerSec;
+		if( adpcm && storage == Storage::Streaming )
+		{
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"IMA ADPCM can't be streamed (load it Resident, it stays compressed)" );
 		}
+		else if( !isSystemFormat && storage == Storage::Streaming )
+		{
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"streaming needs the system wave format (load it Resident to convert)" );
+		}
+		// embedded loop points are in source frames
+		const auto ToSystemFrames = [&]( unsigned int frame )
+		{
+			return uint32_t( uint64_t( frame ) * sysFormat.nSamplesPerSec / srcFormat.sampleRate );
+		};
 
-		// compare format with sound system format
+		if( !bFilledData )
 		{
-			const WAVEFORMATEX& sysFormat = SoundSystem::GetFormat();
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"data chunk not found" );
+		}
+		// reader has already clamped the size to the end of the file
+		nBytes = dataChunk.size;
 
-			if( format.nChannels != sysFormat.nChannels )
-			{
-				throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (nChannels)" );
-			}
-			else if( format.wBitsPerSample != sysFormat.wBitsPerSample )
-			{
-				throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (wBitsPerSample)" );
-			}
-			else if( format.nSamplesPerSec != sysFormat.nSamplesPerSec )
-			{
-				throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (nSamplesPerSec)" );
-			}
-			else if( format.wFormatTag != sysFormat.wFormatTag )
-			{
-				throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (wFormatTag)" );
-			}
-			else if( format.nBlockAlign != sysFormat.nBlockAlign )
+		if( adpcm && format.nSamplesPerSec == sysFormat.nSamplesPerSec && pImage &&
+			nBytes % adpcmLayout.blockAlign == 0u )
+		{
+			// whole blocks already, the mixer can decode them right out of the image
+			nAdpcmFrames = uint32_t( ImaAdpcm::GetFrameCount( adpcmLayout,nBytes ) );
+			if( bFilledFact )
 			{
-				throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (nBlockAlign)" );
+				nAdpcmFrames = std::min( nAdpcmFrames,nFactFrames );
 			}
-			else if( format.nAvgBytesPerSec != sysFormat.nAvgBytesPerSec )
+			pSamples = pImage + dataChunk.offset;
+		}
+		else if( adpcm && format.nSamplesPerSec == sysFormat.nSamplesPerSec )
+		{
+			// keep it compressed, padded out to whole blocks so the mixer only ever decodes whole ones
+			const size_t nBlocks = (size_t( nBytes ) + adpcmLayout.blockAlign - 1u) / adpcmLayout.blockAlign;
+			size_t nFrames = ImaAdpcm::GetFrameCount( adpcmLayout,nBytes );
+			if( bFilledFact )
 			{
-				throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"bad wave format (nAvgBytesPerSec)" );
+				nFrames = std::min( nFrames,size_t( nFactFrames ) );
 			}
+			pData = std::make_unique<unsigned char[]>( nBlocks * adpcmLayout.blockAlign );
+			riff.Read( dataChunk,0u,pData.get(),nBytes );
+			std::fill( &pData[nBytes],&pData[nBlocks * adpcmLayout.blockAlign],static_cast<unsigned char>( 0u ) );
+			nBytes = uint32_t( nBlocks * adpcmLayout.blockAlign );
+			nAdpcmFrames = uint32_t( nFrames );
 		}
-
-		//look for 'data' chunk id
-		bool bFilledData = false;
-		for( size_t i = 12u; i < fileSize; )
+		else if( adpcm )
 		{
-			unsigned int chunkSize;
-			memcpy( &chunkSize,&pFileIn[i + 4u],sizeof( chunkSize ) );
-			if( IsFourCC( &pFileIn[i],"data" ) )
+			// needs resampling, which means decoding all of it up front (no savings on these)
+			std::vector<unsigned char> raw( nBytes );
+			riff.Read( dataChunk,0u,raw.data(),nBytes );
+			const size_t nWholeBlocks = raw.size() / adpcmLayout.blockAlign;
+			size_t nFrames = nWholeBlocks * adpcmLayout.framesPerBlock;
+			if( bFilledFact )
 			{
-				pData = std::make_unique<BYTE[]>( chunkSize );
-				nBytes = chunkSize;
-				memcpy( pData.get(),&pFileIn[i + 8u],nBytes );
-
-				bFilledData = true;
-				break;
+				nFrames = std::min( nFrames,size_t( nFactFrames ) );
 			}
-			// chunk size + size entry size + chunk id entry size + word padding
-			i += (chunkSize + 9u) & 0xFFFFFFFEu;
+			std::vector<int16_t> pcm( nWholeBlocks * adpcmLayout.framesPerBlock * SoundMixer::nChannels );
+			ImaAdpcm::Decode( raw.data(),nWholeBlocks,adpcmLayout,pcm.data() );
+			srcFormat.nChannels = SoundMixer::nChannels;
+			size_t nConvertedBytes;
+			pData = SampleConverter::Convert( reinterpret_cast<const unsigned char*>( pcm.data() ),
+				nFrames * SoundMixer::nChannels * sizeof( int16_t ),srcFormat,sysFormat.nSamplesPerSec,nConvertedBytes );
+			nBytes = uint32_t( nConvertedBytes );
+			adpcm = false;
 		}
-		if( !bFilledData )
+		else if( storage == Storage::Resident && isSystemFormat && pImage )
 		{
-			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"data chunk not found" );
+			pSamples = pImage + dataChunk.offset;
+		}
+		else if( storage == Storage::Resident && isSystemFormat )
+		{
+			pData = std::make_unique<unsigned char[]>( nBytes );
+			riff.Read( dataChunk,0u,pData.get(),nBytes );
+		}
+		else if( storage == Storage::Resident )
+		{
+			std::vector<unsigned char> raw( nBytes );
+			riff.Read( dataChunk,0u,raw.data(),nBytes );
+			size_t nConvertedBytes;
+			pData = SampleConverter::Convert( raw.data(),raw.size(),srcFormat,sysFormat.nSamplesPerSec,nConvertedBytes );
+			nBytes = uint32_t( nConvertedBytes );
+		}
+		if( pData )
+		{
+			pSamples = pData.get();
 		}
 
 		switch( loopType )
@@ -481,57 +1168,60 @@ Sound::Sound( const std::wstring& fileName,LoopType loopType,
 		case LoopType::AutoEmbeddedCuePoints:
 			{
 				looping = true;
-
-				//look for 'cue' chunk id
-				bool bFilledCue = false;
-				for( size_t i = 12u; i < fileSize; )
+				const auto FindLabelled = [&]( const char* pLabel ) -> const CuePoint*
 				{
-					unsigned int chunkSize;
-					memcpy( &chunkSize,&pFileIn[i + 4u],sizeof( chunkSize ) );
-					if( IsFourCC( &pFileIn[i],"cue " ) )
+					for( const auto& l : cueLabels )
 					{
-						struct CuePoint
-						{
-							unsigned int cuePtId;
-							unsigned int pop;
-							unsigned int dataChunkId;
-							unsigned int chunkStart;
-							unsigned int blockStart;
-							unsigned int frameOffset;
-						};
-
-						unsigned int nCuePts;
-						memcpy( &nCuePts,&pFileIn[i + 8u],sizeof( nCuePts ) );
-						if( nCuePts == 2u )
+						if( EqualsNoCase( l.second.c_str(),pLabel ) )
 						{
-							CuePoint cuePts[2];
-							memcpy( cuePts,&pFileIn[i + 12u],sizeof( cuePts ) );
-							loopStart = cuePts[0].frameOffset;
-							loopEnd = cuePts[1].frameOffset;
-							bFilledCue = true;
-							break;
+							for( const auto& c : cuePts )
+							{
+								if( c.cuePtId == l.first )
+								{
+									return &c;
+								}
+							}
 						}
 					}
-					// chunk size + size entry size + chunk id entry size + word padding
-					i += (chunkSize + 9u) & 0xFFFFFFFEu;
+					return nullptr;
+				};
+				const CuePoint* pStart = FindLabelled( "loop start" );
+				const CuePoint* pEnd = FindLabelled( "loop end" );
+				if( (!pStart || !pEnd) && cuePts.size() == 2u )
+				{
+					pStart = &cuePts[0];
+					pEnd = &cuePts[1];
 				}
-				if( !bFilledCue )
+				if( !pStart || !pEnd )
 				{
 					throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"loop cue chunk not found" );
 				}
+				loopStart = ToSystemFrames( pStart->frameOffset );
+				loopEnd = ToSystemFrames( pEnd->frameOffset );
+			}
+			break;
+		case LoopType::AutoEmbeddedSmplLoop:
+			{
+				looping = true;
+				if( !bFilledSmpl )
+				{
+					throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"smpl loop not found" );
+				}
+				loopStart = ToSystemFrames( smplLoop.start );
+				loopEnd = ToSystemFrames( smplLoop.end + 1u );
 			}
 			break;
 		case LoopType::ManualFloat:
 			{
 				looping = true;
 
-				const WAVEFORMATEX& sysFormat = SoundSystem::GetFormat();
-				const unsigned int nFrames = nBytes / sysFormat.nBlockAlign;
+				const SoundSystem::WaveFormat& sysFormat = SoundSystem::GetFormat();
+				const unsigned int nFrames = GetFrameCount();
 
 				const unsigned int nFramesPerSec = sysFormat.nAvgBytesPerSec / sysFormat.nBlockAlign;
-				loopStart = unsigned int( loopStartSeconds * float( nFramesPerSec ) );
+				loopStart = static_cast<unsigned int>( loopStartSeconds * float( nFramesPerSec ) );
 				assert( loopStart < nFrames );
-				loopEnd = unsigned int( loopEndSeconds * float( nFramesPerSec ) );
+				loopEnd = static_cast<unsigned int>( loopEndSeconds * float( nFramesPerSec ) );
 				assert( loopEnd > loopStart && loopEnd < nFrames );
 
 				// just in case ;)
@@ -543,8 +1233,7 @@ Sound::Sound( const std::wstring& fileName,LoopType loopType,
 			{
 				looping = true;
 
-				const WAVEFORMATEX& sysFormat = SoundSystem::GetFormat();
-				const unsigned int nFrames = nBytes / sysFormat.nBlockAlign;
+				const unsigned int nFrames = GetFrameCount();
 
 				assert( loopStartSample < nFrames );
 				loopStart = loopStartSample;
@@ -560,7 +1249,7 @@ Sound::Sound( const std::wstring& fileName,LoopType loopType,
 			{
 				looping = true;
 
-				const unsigned int nFrames = nBytes / SoundSystem::GetFormat().nBlockAlign;
+				const unsigned int nFrames = GetFrameCount();
 				assert( nFrames != 0u && "Cannot auto full-loop on zero-length sound!" );
 				loopStart = 0u;
 				loopEnd = nFrames != 0u ? nFrames - 1u : 0u;
@@ -572,19 +1261,35 @@ Sound::Sound( const std::wstring& fileName,LoopType loopType,
 			assert( "Bad LoopType encountered!" && false );
 			break;
 		}
+		// embedded loop points come from the file, so don't just assert on them
+		if( looping &&
+			(loopStart >= loopEnd || loopEnd > GetFrameCount()) )
+		{
+			throw CHILI_SOUND_FILE_EXCEPTION( fileName,L"loop points out of range" );
+		}
+		if( storage == Storage::Streaming )
+		{
+			const size_t blockAlign = sysFormat.nBlockAlign;
+			pStreamSource = std::make_shared<WaveStream::Source>( WaveStream::Source{ fileName,dataChunk.offset,nBytes,
+				blockAlign,looping,size_t( loopStart ) * blockAlign,size_t( loopEnd ) * blockAlign } );
+		}
 	}
 	catch( const SoundSystem::FileException& e )
 	{
 		nBytes = 0u;
 		looping = false;
-		pData.release();
+		adpcm = false;
+		pData.reset();
+		pSamples = nullptr;
 		throw e;
 	}
 	catch( const std::exception& e )
 	{
 		nBytes = 0u;
 		looping = false;
-		pData.release();
+		adpcm = false;
+		pData.reset();
+		pSamples = nullptr;
 		// needed for conversion to wide string
 		const std::string what = e.what();
 		throw CHILI_SOUND_FILE_EXCEPTION( fileName,std::wstring( what.begin(),what.end() ) );
@@ -593,126 +1298,114 @@ Sound::Sound( const std::wstring& fileName,LoopType loopType,
 
 Sound::Sound( Sound&& donor )
 {
-	std::lock_guard<std::mutex> lock( donor.mutex );
 	nBytes = donor.nBytes;
 	donor.nBytes = 0u;
 	looping = donor.looping;
 	loopStart = donor.loopStart;
 	loopEnd = donor.loopEnd;
 	pData = std::move( donor.pData );
-	activeChannelPtrs = std::move( donor.activeChannelPtrs );
-	for( auto& pChan : activeChannelPtrs )
+	pSamples = donor.pSamples;
+	donor.pSamples = nullptr;
+	adpcm = donor.adpcm;
+	adpcmLayout = donor.adpcmLayout;
+	nAdpcmFrames = donor.nAdpcmFrames;
+	storage = donor.storage;
+	priority = donor.priority;
+	pStreamSource = std::move( donor.pStreamSource );
+	// voices keep pointing at the same sample buffer, they just report to us now
+	if( donor.nActiveChannels > 0 )
 	{
-		pChan->RetargetSound( &donor,this );
+		SoundSystem::Get().RetargetChannels( donor,*this );
 	}
-	donor.cvDeath.notify_all();
 }
 
 Sound& Sound::operator=( Sound && donor )
 {	
-	// make sure nobody messes with our shit (also needed for cv.wait())
-	std::unique_lock<std::mutex> lock( mutex );
 	// check if there are even any active channels playing our jam
-	if( activeChannelPtrs.size() != 0u )
+	if( nActiveChannels > 0 )
 	{
 		// stop all channels currently playing our jam
-		for( auto pChannel : activeChannelPtrs )
-		{
-			pChannel->Stop();
-		}
+		SoundSystem::Get().StopChannels( *this,true );
 		// wait for those channels to actually stop playing our jam
-		cvDeath.wait( lock,[this] { return activeChannelPtrs.size() == 0u; } );
+		SoundSystem::Get().WaitForVoices( *this );
 	}
 
-	std::lock_guard<std::mutex> lock_donor( donor.mutex );
 	nBytes = donor.nBytes;
 	donor.nBytes = 0u;
 	looping = donor.looping;
 	loopStart = donor.loopStart;
 	loopEnd = donor.loopEnd;
 	pData = std::move( donor.pData );
-	activeChannelPtrs = std::move( donor.activeChannelPtrs );	
-	for( auto& pChan : activeChannelPtrs )
+	pSamples = donor.pSamples;
+	donor.pSamples = nullptr;
+	adpcm = donor.adpcm;
+	adpcmLayout = donor.adpcmLayout;
+	nAdpcmFrames = donor.nAdpcmFrames;
+	storage = donor.storage;
+	priority = donor.priority;
+	pStreamSource = std::move( donor.pStreamSource );
+	if( donor.nActiveChannels > 0 )
 	{
-		pChan->RetargetSound( &donor,this );
+		SoundSystem::Get().RetargetChannels( donor,*this );
 	}
-	donor.cvDeath.notify_all();
 	return *this;
 }
 
 void Sound::Play( float freqMod,float vol )
 {
+	// nothing loaded (default constructed or moved from)
+	if( nBytes == 0u )
+	{
+		return;
+	}
 	SoundSystem::Get().PlaySoundBuffer( *this,freqMod,vol );
 }
 
+void Sound::SetPriority( Priority p )
+{
+	priority = p;
+}
+
+Sound::Priority Sound::GetPriority() const
+{
+	return priority;
+}
+
+unsigned int Sound::GetFrameCount() const
+{
+	return adpcm ? nAdpcmFrames : nBytes / SoundSystem::GetFormat().nBlockAlign;
+}
+
 void Sound::StopOne()
 {
-	std::lock_guard<std::mutex> lock( mutex );
-	if( activeChannelPtrs.size() > 0u )
+	if( nActiveChannels > 0 )
 	{
-		activeChannelPtrs.front()->Stop();
+		SoundSystem::Get().StopChannels( *this,false );
 	}
 }
 
 void Sound::StopAll()
 {
-	std::lock_guard<std::mutex> lock( mutex );
-	for( auto pChannel : activeChannelPtrs )
+	if( nActiveChannels > 0 )
 	{
-		pChannel->Stop();
+		SoundSystem::Get().StopChannels( *this,true );
 	}
 }
 
 Sound::~Sound()
 {
-	// make sure nobody messes with our shit (also needed for cv.wait())
-	std::unique_lock<std::mutex> lock( mutex );
-
 	// check if there are even any active channels playing our jam
-	if( activeChannelPtrs.size() == 0u )
+	if( nActiveChannels == 0 )
 	{
 		return;
 	}
 
 	// stop all channels currently playing our jam
-	for( auto pChannel : activeChannelPtrs )
-	{
-		pChannel->Stop();
-	}
+	SoundSystem::Get().StopChannels( *this,true );
 
 	// wait for those channels to actually stop playing our jam
-	cvDeath.wait( lock,[this] { return activeChannelPtrs.size() == 0u; } );
-}
-
-SoundSystem::APIException::APIException( HRESULT hr,const wchar_t * file,unsigned int line,const std::wstring & note )
-	:
-	hr( hr ),
-	ChiliException( file,line,note )
-{}
-
-std::wstring SoundSystem::APIException::GetFullMessage() const
-{
-	return L"Error Name: " + GetErrorName() + L"\n\n" +
-		L"Error Description: " + GetErrorDescription() + L"\n\n" +
-		L"Note: " + GetNote() + L"\n\n" +
-		L"Location: " + GetLocation();
-}
-
-std::wstring SoundSystem::APIException::GetExceptionType() const
-{
-	return L"Sound System API Exception";
-}
-
-std::wstring SoundSystem::APIException::GetErrorName() const
-{
-	return DXGetErrorString( hr );
-}
-
-std::wstring SoundSystem::APIException::GetErrorDescription() const
-{
-	std::array<wchar_t,512> wideDescription;
-	DXGetErrorDescription( hr,wideDescription.data(),wideDescription.size() );
-	return wideDescription.data();
+	// (the mixer gets to them within a block and signals when the last one is gone)
+	SoundSystem::Get().WaitForVoices( *this );
 }
 
 SoundSystem::FileException::FileException( const wchar_t* file,unsigned int line,const std::wstring& note,const std::wstring& filename )
@@ -19,33 +19,22 @@
  *	along with this source code.  If not, see <http://www.gnu.org/licenses/>.			  *
  ******************************************************************************************/
 #pragma once
-#include "ChiliWin.h"
 #include <memory>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
+#include <cstdint>
 #include "ChiliException.h"
-#include <wrl\client.h>
-
-// forward declare WAVEFORMATEX so we don't have to include bullshit headers
-struct tWAVEFORMATEX;
-typedef tWAVEFORMATEX WAVEFORMATEX;
+#include "WaveStream.h"
+#include "SoundMixer.h"
+#include "ImaAdpcm.h"
 
 class SoundSystem
 {
+	friend class Sound;
 public:
-	class APIException : public ChiliException
-	{
-	public:
-		APIException( HRESULT hr,const wchar_t * file,unsigned int line,const std::wstring& note );
-		std::wstring GetErrorName() const;
-		std::wstring GetErrorDescription() const;
-		virtual std::wstring GetFullMessage() const override;
-		virtual std::wstring GetExceptionType() const override;
-	private:
-		HRESULT hr;
-	};
 	class FileException : public ChiliException
 	{
 	public:
@@ -55,118 +44,299 @@ public:
 	private:
 		std::wstring filename;
 	};
-private:
-	class XAudioDll
+	// the body of a fmt chunk, laid out like WAVEFORMATEX so it can be read straight in
+#pragma pack(push,1)
+	struct WaveFormat
 	{
-	private:
-		enum class LoadType
-		{
-			Folder,
-			Local,
-			System,
-			Invalid
-		};
-	public:
-		XAudioDll();
-		~XAudioDll();
-		operator HMODULE() const;
-	private:
-		static const wchar_t* GetDllPath( LoadType type );
-	private:
-		HMODULE hModule = 0;
-		static constexpr wchar_t* systemPath = L"XAudio2_7.dll";
-#ifdef _M_X64
-		static constexpr wchar_t* folderPath = L"XAudio\\XAudio2_7_64.dll";
-		static constexpr wchar_t* localPath = L"XAudio2_7_64.dll";
-#else
-		static constexpr wchar_t* folderPath = L"XAudio\\XAudio2_7_32.dll";
-		static constexpr wchar_t* localPath = L"XAudio2_7_32.dll";
-#endif
+		uint16_t wFormatTag;
+		uint16_t nChannels;
+		uint32_t nSamplesPerSec;
+		uint32_t nAvgBytesPerSec;
+		uint16_t nBlockAlign;
+		uint16_t wBitsPerSample;
+		uint16_t cbSize;
 	};
+#pragma pack(pop)
+private:
+	static constexpr uint32_t nullChannel = 0xFFFFFFFFu;
 public:
+	// when every channel is busy, a new voice steals the oldest voice of the lowest priority
+	// that is not above its own (if there is none the new voice is dropped)
+	// keep Critical for the few cues that must always be heard, those take any voice that
+	// isn't streaming and are only dropped when there is none
+	enum class Priority : unsigned char
+	{
+		Low,
+		Normal,
+		High,
+		Critical,
+		Count
+	};
+	// a voice of the software mixer
+	// Free (pooled) -> Starting (claimed by a player) -> Playing/Streaming (mixed) -> Free
+	// streaming voices wait in Opening until the stream thread has opened and primed their stream
+	// Playing voices are Mixing while the mixer works on them, a player can only steal one
+	// out of Playing (streaming voices are never stolen, and go through Retired so that
+	// the stream thread can close the stream)
 	class Channel
 	{
 		friend class Sound;
+		friend SoundSystem;
 	public:
-		Channel( SoundSystem& sys );
+		Channel() = default;
 		Channel( const Channel& ) = delete;
 		~Channel();
 		void PlaySoundBuffer( class Sound& s,float freqMod,float vol );
 		void Stop();
 	private:
-		void RetargetSound( const Sound* pOld,Sound* pNew );
+		enum class State
+		{
+			Free,
+			Starting,
+			Playing,
+			Mixing,
+			Opening,
+			Streaming,
+			Retired
+		};
+		// adds this voice to the bus, returns false once the sound has played out
+		bool Mix( float* pBus,size_t nBusFrames );
 	private:
-		std::unique_ptr<struct XAUDIO2_BUFFER> xaBuffer;
-		struct IXAudio2SourceVoice* pSource = nullptr;
-		class Sound* pSound = nullptr;
+		std::atomic<State> state = { State::Free };
+		std::atomic<uint32_t> nextFree = { nullChannel };
+		std::atomic<class Sound*> pSound = { nullptr };
+		std::atomic<bool> stopRequested = { false };
+		std::atomic<Priority> priority = { Priority::Normal };
+		// bumped on every start, tells the mixer a listed voice was restarted by a thief
+		std::atomic<uint32_t> serial = { 0u };
+		// serial of the voice a thief wants gone at the end of the block it's being mixed in
+		// (a request for an earlier start of the channel doesn't match and is ignored)
+		std::atomic<uint32_t> stealSerial = { 0u };
+		// start order list links, one list per priority (the mixer maintains them,
+		// players only ever follow newer links)
+		std::atomic<uint32_t> newer = { nullChannel };
+		// link in the stack of voices started since the mixer last listed, set while on it
+		std::atomic<uint32_t> nextStarted = { nullChannel };
+		std::atomic<bool> onStarted = { false };
+		uint32_t older = nullChannel;
+		std::atomic<uint32_t> listedSerial = { 0u };
+		Priority listedPriority = Priority::Normal;
+		bool listed = false;
+		// copied from the sound on start so the mixer never has to look at the Sound itself
+		const int16_t* pSamples = nullptr;
+		size_t nFrames = 0u;
+		bool looping = false;
+		size_t loopStart = 0u;
+		size_t loopEnd = 0u;
+		uint64_t pos = 0u;
+		uint64_t step = SoundMixer::unityStep;
+		float vol = 1.0f;
+		// only used when playing a streaming sound, the stream is opened off the source on the
+		// stream thread (the source is shared with the sound, so the player needn't allocate)
+		std::shared_ptr<const WaveStream::Source> pStreamSource;
+		std::unique_ptr<WaveStream> pStream;
+		// only used when playing an ADPCM sound, decoded a batch of blocks at a time
+		const unsigned char* pAdpcm = nullptr;
+		ImaAdpcm::Layout adpcmLayout = {};
+		size_t nAdpcmBlocks = 0u;
+		std::vector<int16_t> decoded;
+		size_t decodedBlock = 0u;
+		size_t nDecodedBlocks = 0u;
+		int16_t loopStartFrame[SoundMixer::nChannels] = {};
+	};
+	enum class Device
+	{
+		XAudio2,
+		Null,
+		WaveFile
+	};
+	struct MixStats
+	{
+		unsigned long long nBlocks;
+		unsigned long long nVoiceBlocks;
+		unsigned long long mixNanoseconds;
+		// ADPCM decoding done by the mixer (part of mixNanoseconds)
+		unsigned long long nDecodedFrames;
+		unsigned long long decodeNanoseconds;
+	};
+	// retries count the times a thread lost a compare-exchange race on the channel pool
+	// (that is all contention costs now, nobody ever sleeps on a lock to start or retire a voice)
+	struct ChannelStats
+	{
+		unsigned long long nStarted;
+		unsigned long long nStolen;
+		unsigned long long nDropped;
+		unsigned long long nAcquireRetries;
+		unsigned long long nReleaseRetries;
 	};
 public:
 	SoundSystem( const SoundSystem& ) = delete;
+	~SoundSystem();
 	static SoundSystem& Get();
+	// choose where the mix goes, must be called before the sound system is first used
+	// (Null and WaveFile need no audio hardware, handy for testing and benchmarking)
+	static void SetDevice( Device device,const std::string& waveFileName = "" );
 	static void SetMasterVolume( float vol = 1.0f );
-	static const WAVEFORMATEX& GetFormat();
+	static const WaveFormat& GetFormat();
+	static MixStats GetMixStats();
+	static ChannelStats GetChannelStats();
 	void PlaySoundBuffer( class Sound& s,float freqMod,float vol );
 private:
 	SoundSystem();
-	void DeactivateChannel( Channel& channel );
+	// lock-free pool of channel indices (Treiber stack, top 32 bits of the head are an ABA tag)
+	uint32_t AcquireChannel();
+	// O(1) per priority level and never waits below Critical: the oldest listed voices are the
+	// victims, then the ones started since the mixer last listed, one the mixer is holding is
+	// asked to go at the end of its block instead (and the new voice is dropped, the next one
+	// finds the channel free)
+	uint32_t StealChannel( Priority priority );
+	// Critical only: scans every voice for the lowest priority one that isn't streaming and
+	// waits out the mixer if it holds the only one
+	uint32_t StealAnyChannel();
+	// claims i for a thief if it's Playing a voice of priority p, otherwise notes it in held
+	// when the mixer has it
+	bool ClaimVictim( uint32_t i,int p,uint32_t& held,uint32_t& heldSerial );
+	void ReleaseChannel( Channel& channel );
+	// stream thread: file open and first chunks of a voice in Opening
+	void OpenChannelStream( Channel& channel );
+	void RetireChannel( Channel& channel );
+	void ListChannel( uint32_t i );
+	// players push the voices they start, the mixer lists them in start order every block
+	void PushStarted( uint32_t i,Priority priority );
+	void ListStartedChannels();
+	void UnlistChannel( uint32_t i );
+	void StopChannels( const Sound& s,bool all );
+	void RetargetChannels( Sound& from,Sound& to );
+	// a voice stops counting against s, wakes whoever waits on s if it was the last
+	void DropVoice( Sound& s );
+	// blocks until no voice plays s (stop them first)
+	void WaitForVoices( const Sound& s );
+	void MixerThreadProc();
+	void MixBlock();
+	void StreamThreadProc();
+	void WakeStreamThread();
 private:
-	XAudioDll xaudio_dll;
-	Microsoft::WRL::ComPtr<struct IXAudio2> pEngine;
-	struct IXAudio2MasteringVoice* pMaster = nullptr;
-	std::unique_ptr<WAVEFORMATEX> format;
-	std::mutex mutex;
-	std::vector<std::unique_ptr<Channel>> idleChannelPtrs;
-	std::vector<std::unique_ptr<Channel>> activeChannelPtrs;
+	static Device device;
+	static std::string deviceFileName;
+	WaveFormat format = {};
+	std::unique_ptr<AudioSink> pSink;
+	std::unique_ptr<Channel[]> pChannels;
+	std::atomic<uint64_t> freeHead = { 0u };
+	std::atomic<uint32_t> oldestChannels[int( Priority::Count )];
+	uint32_t newestChannels[int( Priority::Count )];
+	std::atomic<uint32_t> startedChannels[int( Priority::Count )];
+	std::unique_ptr<float[]> pBus;
+	std::atomic<float> masterVolume = { 1.0f };
+	std::atomic<unsigned long long> nBlocksMixed = { 0u };
+	std::atomic<unsigned long long> nVoiceBlocksMixed = { 0u };
+	std::atomic<unsigned long long> mixNanoseconds = { 0u };
+	std::atomic<unsigned long long> nDecodedFrames = { 0u };
+	std::atomic<unsigned long long> decodeNanoseconds = { 0u };
+	std::atomic<unsigned long long> nChannelsStarted = { 0u };
+	std::atomic<unsigned long long> nStolen = { 0u };
+	std::atomic<unsigned long long> nDropped = { 0u };
+	std::atomic<unsigned long long> nAcquireRetries = { 0u };
+	std::atomic<unsigned long long> nReleaseRetries = { 0u };
+	// refilling stream buffers happens on its own thread so that the
+	// mixer thread never has to wait on file io
+	std::mutex streamMutex;
+	std::condition_variable cvStream;
+	std::atomic<bool> streamWorkPending = { false };
+	bool streamQuitting = false;
+	std::thread streamThread;
+	std::atomic<bool> mixerQuitting = { false };
+	std::thread mixerThread;
+	// sounds being destroyed or assigned to wait here for their last voice to retire
+	// (the retiring thread only takes the lock when somebody is waiting)
+	std::mutex idleMutex;
+	std::condition_variable cvIdle;
+	std::atomic<int> nIdleWaiters = { 0 };
 private:
-	// change these values to match the format of the wav files you are loading
-	// all wav files must have the same format!! (no mixing and matching)
-	static constexpr WORD nChannelsPerSound = 2u;
-	static constexpr DWORD nSamplesPerSec = 44100u;
-	static constexpr WORD nBitsPerSample = 16u;
+	// format the mixer plays, resident wav files in other formats are converted to it on load
+	// (streamed wav files must already match it, IMA ADPCM at this rate is kept compressed)
+	// (the software mixer works on 16-bit stereo)
+	static constexpr uint16_t nChannelsPerSound = 2u;
+	static constexpr uint32_t nSamplesPerSec = 44100u;
+	static constexpr uint16_t nBitsPerSample = 16u;
 	// change this value to increase/decrease the maximum polyphony	
 	static constexpr size_t nChannels = 64u;
+	// voices a thief looks at per priority level, oldest first
+	static constexpr size_t nStealCandidates = 2u;
+	// frames mixed per block (~11.6ms at 44.1kHz)
+	static constexpr size_t nBlockFrames = 512u;
 };
 
 class Sound
 {
+	friend SoundSystem;
 	friend SoundSystem::Channel;
 public:
 	enum class LoopType
 	{
 		NotLooping,
+		// two cue points, or the cues labelled "loop start" / "loop end" in a LIST adtl chunk
 		AutoEmbeddedCuePoints,
+		// first loop of the smpl chunk (what most sample editors write)
+		AutoEmbeddedSmplLoop,
 		AutoFullSound,
 		ManualFloat,
 		ManualSample,
 		Invalid
 	};
+	// Resident sounds load the entire payload into memory on construction
+	// Streaming sounds only parse the header and read the payload in chunks while playing
+	// (use for long tracks: memory per voice is bounded and start latency doesn't depend on length)
+	enum class Storage
+	{
+		Resident,
+		Streaming
+	};
+	typedef SoundSystem::Priority Priority;
 public:
 	Sound() = default;
 	// for backwards compatibility--2nd parameter false -> NotLooping
 	Sound( const std::wstring& fileName,bool loopingWithAutoCueDetect );
 	// do not pass this function Manual LoopTypes!
-	Sound( const std::wstring& fileName,LoopType loopType = LoopType::NotLooping );
-	Sound( const std::wstring& fileName,unsigned int loopStart,unsigned int loopEnd );
-	Sound( const std::wstring& fileName,float loopStart,float loopEnd );
+	Sound( const std::wstring& fileName,LoopType loopType = LoopType::NotLooping,Storage storage = Storage::Resident );
+	Sound( const std::wstring& fileName,unsigned int loopStart,unsigned int loopEnd,Storage storage = Storage::Resident );
+	Sound( const std::wstring& fileName,float loopStart,float loopEnd,Storage storage = Storage::Resident );
+	// from a wave file image already in memory (e.g. an AssetPack), name is just for error messages
+	// sample data the mixer can take as it is gets played straight out of the image,
+	// so the image has to outlive the sound
+	Sound( const unsigned char* pImage,size_t imageSize,const std::wstring& name,LoopType loopType = LoopType::NotLooping );
 	Sound( Sound&& donor );
 	Sound& operator=( Sound&& donor );
 	void Play( float freqMod = 1.0f,float vol = 1.0f );
+	void SetPriority( Priority p );
+	Priority GetPriority() const;
 	void StopOne();
 	void StopAll();
 	~Sound();
 private:	
-	Sound( const std::wstring& fileName,LoopType loopType,
+	Sound( const std::wstring& fileName,LoopType loopType,Storage storage,
 		unsigned int loopStartSample,unsigned int loopEndSample,
-		float loopStartSeconds,float loopEndSeconds );
+		float loopStartSeconds,float loopEndSeconds,
+		const unsigned char* pImage = nullptr,size_t imageSize = 0u );
+	unsigned int GetFrameCount() const;
 private:
-	UINT32 nBytes = 0u;
+	uint32_t nBytes = 0u;
 	bool looping = false;
 	unsigned int loopStart;
 	unsigned int loopEnd;
-	std::unique_ptr<BYTE[]> pData;
-	std::mutex mutex;
-	std::condition_variable cvDeath;
-	std::vector<SoundSystem::Channel*> activeChannelPtrs;
+	std::unique_ptr<unsigned char[]> pData;
+	// what the mixer plays: pData, or the data chunk of the image the sound was made from
+	const unsigned char* pSamples = nullptr;
+	// IMA ADPCM sounds keep their blocks in pData and nBytes counts the compressed bytes
+	// (about a quarter of the 16-bit pcm), the mixer decodes them as it plays
+	bool adpcm = false;
+	ImaAdpcm::Layout adpcmLayout = {};
+	unsigned int nAdpcmFrames = 0u;
+	Storage storage = Storage::Resident;
+	Priority priority = Priority::Normal;
+	// only for streaming sounds
+	std::shared_ptr<const WaveStream::Source> pStreamSource;
+	// voices playing this sound, the destructor waits for it to hit zero
+	std::atomic<int> nActiveChannels = { 0 };
 	static constexpr unsigned int nullSample = 0xFFFFFFFFu;
 	static constexpr float nullSeconds = -1.0f;
 };
\ No newline at end of file
@@ -30,7 +30,7 @@ public:
 	SoundEffect( const std::initializer_list<std::wstring>& wavFiles,bool soft_fail = false,float freqStdDevFactor = 0.06f )
 		:
 		freqDist( 0.0f,freqStdDevFactor ),
-		soundDist( 0,unsigned int( wavFiles.size() - 1 ) )
+		soundDist( 0,static_cast<unsigned int>( wavFiles.size() - 1 ) )
 	{
 		sounds.reserve( wavFiles.size() );
 		for( auto& f : wavFiles )
@@ -0,0 +1,209 @@
+#include "SoundMixer.h"
+#include <assert.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#define CHILI_MIXER_SSE2
+#include <emmintrin.h>
+#endif
+
+NullSink::NullSink( unsigned int sampleRate,bool realTime )
+	:
+	sampleRate( sampleRate ),
+	realTime( realTime )
+{}
+
+void NullSink::Submit( const float* pFrames,size_t nFrames )
+{
+	if( realTime )
+	{
+		// sleep until the block would have finished playing on a real device
+		if( !started )
+		{
+			deadline = std::chrono::steady_clock::now();
+			started = true;
+		}
+		deadline += std::chrono::microseconds( nFrames * 1000000u / sampleRate );
+		std::this_thread::sleep_until( deadline );
+	}
+}
+
+WaveFileSink::WaveFileSink( const std::string& fileName,unsigned int sampleRate,bool realTime )
+	:
+	sampleRate( sampleRate ),
+	pacer( sampleRate,realTime )
+{
+	file.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+	file.open( fileName,std::ios::binary );
+	WriteHeader();
+}
+
+WaveFileSink::~WaveFileSink()
+{
+	try
+	{
+		file.seekp( 0 );
+		WriteHeader();
+	}
+	catch( const std::exception& )
+	{}
+}
+
+void WaveFileSink::Submit( const float* pFrames,size_t nFrames )
+{
+	const size_t nBytes = nFrames * SoundMixer::nChannels * sizeof( float );
+	file.write( reinterpret_cast<const char*>( pFrames ),nBytes );
+	nDataBytes += nBytes;
+	pacer.Submit( pFrames,nFrames );
+}
+
+void WaveFileSink::WriteHeader()
+{
+	const auto Write32 = [this]( uint32_t v )
+	{
+		file.write( reinterpret_cast<const char*>( &v ),sizeof( v ) );
+	};
+	const auto Write16 = [this]( uint16_t v )
+	{
+		file.write( reinterpret_cast<const char*>( &v ),sizeof( v ) );
+	};
+	const uint16_t blockAlign = uint16_t( SoundMixer::nChannels * sizeof( float ) );
+	file.write( "RIFF",4 );
+	Write32( uint32_t( 36u + nDataBytes ) );
+	file.write( "WAVEfmt ",8 );
+	Write32( 16u );
+	Write16( 3u ); // ieee float
+	Write16( uint16_t( SoundMixer::nChannels ) );
+	Write32( sampleRate );
+	Write32( sampleRate * blockAlign );
+	Write16( blockAlign );
+	Write16( 32u );
+	file.write( "data",4 );
+	Write32( uint32_t( nDataBytes ) );
+}
+
+uint64_t SoundMixer::StepFromRatio( float freqRatio )
+{
+	assert( freqRatio > 0.0f );
+	return uint64_t( double( freqRatio ) * double( unityStep ) );
+}
+
+void SoundMixer::Clear( float* pBus,size_t nFrames )
+{
+	memset( pBus,0,nFrames * nChannels * sizeof( float ) );
+}
+
+size_t SoundMixer::MixPcm16( float* pBus,size_t nBusFrames,
+	const int16_t* pSrc,size_t nSrcFrames,const int16_t* pNextFrame,
+	uint64_t& pos,uint64_t step,float vol )
+{
+	static_assert( nChannels == 2u,"Mixing kernels are written for interleaved stereo" );
+	const float scale = vol * (1.0f / 32768.0f);
+	const uint64_t fracMask = unityStep - 1u;
+	size_t n = 0u;
+
+	// unity pitch and whole-frame position: straight convert and accumulate
+	if( step == unityStep && (pos & fracMask) == 0u )
+	{
+		const size_t iStart = size_t( pos >> fracBits );
+		if( iStart >= nSrcFrames )
+		{
+			return 0u;
+		}
+		const size_t nMix = std::min( nBusFrames,nSrcFrames - iStart );
+		const int16_t* const pIn = &pSrc[iStart * nChannels];
+#ifdef CHILI_MIXER_SSE2
+		const __m128 vScale = _mm_set1_ps( scale );
+		for( ; n + 4u <= nMix; n += 4u )
+		{
+			// 4 stereo frames -> 8 samples, sign extend to 32 bits then convert
+			const __m128i s = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &pIn[n * nChannels] ) );
+			const __m128 lo = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( s,s ),16 ) );
+			const __m128 hi = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( s,s ),16 ) );
+			float* const pOut = &pBus[n * nChannels];
+			_mm_storeu_ps( pOut,_mm_add_ps( _mm_loadu_ps( pOut ),_mm_mul_ps( lo,vScale ) ) );
+			_mm_storeu_ps( pOut + 4,_mm_add_ps( _mm_loadu_ps( pOut + 4 ),_mm_mul_ps( hi,vScale ) ) );
+		}
+#endif
+		for( ; n < nMix; n++ )
+		{
+			pBus[n * nChannels] += float( pIn[n * nChannels] ) * scale;
+			pBus[n * nChannels + 1] += float( pIn[n * nChannels + 1] ) * scale;
+		}
+		pos += uint64_t( nMix ) << fracBits;
+		return nMix;
+	}
+
+	// resampling: linear interpolation between frame i and i + 1
+#ifdef CHILI_MIXER_SSE2
+	// frames where i + 1 is still inside the span can be done two at a time
+	size_t nSafe = 0u;
+	const uint64_t safeLimit = nSrcFrames > 1u ? uint64_t( nSrcFrames - 1u ) << fracBits : 0u;
+	if( pos < safeLimit )
+	{
+		nSafe = size_t( std::min( uint64_t( nBusFrames ),(safeLimit - pos + step - 1u) / step ) );
+	}
+	const __m128 vScale = _mm_set1_ps( scale );
+	const float fracScale = 1.0f / float( unityStep );
+	for( ; n + 2u <= nSafe; n += 2u )
+	{
+		const size_t i0 = size_t( pos >> fracBits );
+		const float t0 = float( pos & fracMask ) * fracScale;
+		pos += step;
+		const size_t i1 = size_t( pos >> fracBits );
+		const float t1 = float( pos & fracMask ) * fracScale;
+		pos += step;
+		// each load grabs frame i and i + 1 (4 samples)
+		const __m128i p0 = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( &pSrc[i0 * nChannels] ) );
+		const __m128i p1 = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( &pSrc[i1 * nChannels] ) );
+		const __m128 f0 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( p0,p0 ),16 ) );
+		const __m128 f1 = _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( p1,p1 ),16 ) );
+		const __m128 a = _mm_shuffle_ps( f0,f1,_MM_SHUFFLE( 1,0,1,0 ) );
+		const __m128 b = _mm_shuffle_ps( f0,f1,_MM_SHUFFLE( 3,2,3,2 ) );
+		const __m128 t = _mm_set_ps( t1,t1,t0,t0 );
+		const __m128 mixed = _mm_mul_ps( _mm_add_ps( a,_mm_mul_ps( _mm_sub_ps( b,a ),t ) ),vScale );
+		float* const pOut = &pBus[n * nChannels];
+		_mm_storeu_ps( pOut,_mm_add_ps( _mm_loadu_ps( pOut ),mixed ) );
+	}
+#endif
+	for( ; n < nBusFrames; n++ )
+	{
+		const size_t i = size_t( pos >> fracBits );
+		if( i >= nSrcFrames )
+		{
+			break;
+		}
+		const int16_t* const pA = &pSrc[i * nChannels];
+		const int16_t* const pB = i + 1u < nSrcFrames ? pA + nChannels : pNextFrame;
+		const float t = float( pos & fracMask ) / float( unityStep );
+		for( unsigned int c = 0u; c < nChannels; c++ )
+		{
+			const float a = float( pA[c] );
+			pBus[n * nChannels + c] += (a + (float( pB[c] ) - a) * t) * scale;
+		}
+		pos += step;
+	}
+	return n;
+}
+
+void SoundMixer::Finalize( float* pBus,size_t nFrames,float gain )
+{
+	const size_t nSamples = nFrames * nChannels;
+	size_t i = 0u;
+#ifdef CHILI_MIXER_SSE2
+	const __m128 vGain = _mm_set1_ps( gain );
+	const __m128 vMax = _mm_set1_ps( 1.0f );
+	const __m128 vMin = _mm_set1_ps( -1.0f );
+	for( ; i + 4u <= nSamples; i += 4u )
+	{
+		const __m128 s = _mm_mul_ps( _mm_loadu_ps( &pBus[i] ),vGain );
+		_mm_storeu_ps( &pBus[i],_mm_max_ps( _mm_min_ps( s,vMax ),vMin ) );
+	}
+#endif
+	for( ; i < nSamples; i++ )
+	{
+		pBus[i] = std::max( std::min( pBus[i] * gain,1.0f ),-1.0f );
+	}
+}
\ No newline at end of file
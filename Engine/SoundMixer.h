@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+// receives blocks of mixed audio (interleaved stereo float) from the sound system
+class AudioSink
+{
+public:
+	virtual ~AudioSink() = default;
+	// may block until the device can take more, which is what paces the mixer thread
+	virtual void Submit( const float* pFrames,size_t nFrames ) = 0;
+};
+
+// throws the mix away, optionally sleeping so the mixer runs at device pace
+class NullSink : public AudioSink
+{
+public:
+	NullSink( unsigned int sampleRate,bool realTime = true );
+	void Submit( const float* pFrames,size_t nFrames ) override;
+private:
+	unsigned int sampleRate;
+	bool realTime;
+	bool started = false;
+	std::chrono::steady_clock::time_point deadline;
+};
+
+// writes the mix to a 32-bit float wave file (sizes in the header are patched on destruction)
+class WaveFileSink : public AudioSink
+{
+public:
+	WaveFileSink( const std::string& fileName,unsigned int sampleRate,bool realTime = false );
+	WaveFileSink( const WaveFileSink& ) = delete;
+	WaveFileSink& operator=( const WaveFileSink& ) = delete;
+	~WaveFileSink();
+	void Submit( const float* pFrames,size_t nFrames ) override;
+private:
+	void WriteHeader();
+private:
+	std::ofstream file;
+	unsigned int sampleRate;
+	size_t nDataBytes = 0u;
+	NullSink pacer;
+};
+
+// software mixing kernels (SSE2 with a scalar fallback)
+// the bus is interleaved stereo float, sources are interleaved stereo 16-bit pcm
+// source positions are 32.32 fixed point frame indices
+class SoundMixer
+{
+public:
+	static constexpr unsigned int nChannels = 2u;
+	static constexpr int fracBits = 32;
+	static constexpr uint64_t unityStep = uint64_t( 1u ) << fracBits;
+public:
+	static uint64_t StepFromRatio( float freqRatio );
+	static void Clear( float* pBus,size_t nFrames );
+	// adds source frames [0,nSrcFrames) to the bus starting at pos and advancing by step,
+	// pNextFrame is the frame that follows the span (for interpolating across the end of it)
+	// stops when the bus is full or pos runs off the span, returns the number of bus frames written
+	static size_t MixPcm16( float* pBus,size_t nBusFrames,
+		const int16_t* pSrc,size_t nSrcFrames,const int16_t* pNextFrame,
+		uint64_t& pos,uint64_t step,float vol );
+	// applies master gain and clamps the bus to [-1,1]
+	static void Finalize( float* pBus,size_t nFrames,float gain );
+};
\ No newline at end of file
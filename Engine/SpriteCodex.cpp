@@ -1,8 +1,59 @@
 #include "SpriteCodex.h"
 #include <assert.h>
 
+const char* const SpriteCodex::spriteNames[int( Sprite::Count )] =
+{
+	"sprites/tile0",
+	"sprites/tile1",
+	"sprites/tile2",
+	"sprites/tile3",
+	"sprites/tile4",
+	"sprites/tile5",
+	"sprites/tile6",
+	"sprites/tile7",
+	"sprites/tile8",
+	"sprites/tilebutton",
+	"sprites/tilecross",
+	"sprites/tileflag",
+	"sprites/tilebomb",
+	"sprites/tilebombred",
+	"sprites/win",
+	"sprites/small",
+	"sprites/medium",
+	"sprites/large"
+};
+
+SpriteView SpriteCodex::packedSprites[int( Sprite::Count )] = {};
+
+void SpriteCodex::UsePack( const AssetPack* pPack )
+{
+	// look everything up once here, drawing is then just a blit out of the mapping
+	for( int i = 0; i < int( Sprite::Count ); i++ )
+	{
+		if( !pPack || !pPack->FindSprite( spriteNames[i],packedSprites[i] ) )
+		{
+			packedSprites[i] = {};
+		}
+	}
+}
+
+bool SpriteCodex::DrawPacked( Sprite s,const Vei2& pos,Graphics& gfx )
+{
+	const SpriteView& sprite = packedSprites[int( s )];
+	if( !sprite.pPixels )
+	{
+		return false;
+	}
+	gfx.DrawSprite( pos.x - sprite.originX,pos.y - sprite.originY,sprite );
+	return true;
+}
+
 void SpriteCodex::DrawTile0( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile0,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -38,6 +89,10 @@ void SpriteCodex::DrawTile0( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTile1( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile1,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -113,6 +168,10 @@ void SpriteCodex::DrawTile1( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTile2( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile2,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -213,6 +272,10 @@ void SpriteCodex::DrawTile2( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTile3( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile3,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -310,6 +373,10 @@ void SpriteCodex::DrawTile3( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTile4( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile4,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -401,6 +468,10 @@ void SpriteCodex::DrawTile4( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTile5( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile5,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -506,6 +577,10 @@ void SpriteCodex::DrawTile5( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTile6( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile6,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -613,6 +688,10 @@ void SpriteCodex::DrawTile6( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTile7( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile7,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -692,6 +771,10 @@ void SpriteCodex::DrawTile7( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTile8( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Tile8,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -803,6 +886,10 @@ void SpriteCodex::DrawTile8( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTileButton( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::TileButton,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,255,255,255 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,255,255,255 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,255,255,255 );
@@ -915,6 +1002,10 @@ void SpriteCodex::DrawTileButton( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTileCross( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::TileCross,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 2 + pos.x,2 + pos.y,255,0,0 );
 	gfx.PutPixel( 3 + pos.x,2 + pos.y,255,0,0 );
 	gfx.PutPixel( 13 + pos.x,2 + pos.y,255,0,0 );
@@ -965,6 +1056,10 @@ void SpriteCodex::DrawTileCross( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTileFlag( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::TileFlag,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 7 + pos.x,3 + pos.y,255,0,0 );
 	gfx.PutPixel( 8 + pos.x,3 + pos.y,255,0,0 );
 	gfx.PutPixel( 5 + pos.x,4 + pos.y,255,0,0 );
@@ -1008,6 +1103,10 @@ void SpriteCodex::DrawTileFlag( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTileBomb( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::TileBomb,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -1217,6 +1316,10 @@ void SpriteCodex::DrawTileBomb( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawTileBombRed( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::TileBombRed,pos,gfx ) )
+	{
+		return;
+	}
 	gfx.PutPixel( 0 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 1 + pos.x,0 + pos.y,128,128,128 );
 	gfx.PutPixel( 2 + pos.x,0 + pos.y,128,128,128 );
@@ -1512,6 +1615,10 @@ void SpriteCodex::DrawTileNumber( const Vei2& pos,int n,Graphics& gfx )
 
 void SpriteCodex::DrawWin( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Win,pos,gfx ) )
+	{
+		return;
+	}
 	// calculate top left corner based on input (center)
 	const int x = pos.x - 254 / 2;
 	const int y = pos.y - 192 / 2;
@@ -9136,6 +9243,10 @@ void SpriteCodex::DrawWin( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawSmall( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Small,pos,gfx ) )
+	{
+		return;
+	}
 	const int x = pos.x - 90;
 	const int y = pos.y - 20;
 	gfx.PutPixel( 11 + x,0 + y,42,42,42 );
@@ -11337,6 +11448,10 @@ void SpriteCodex::DrawSmall( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawMedium( const Vei2& pos,Graphics& gfx )
 {
+	if( DrawPacked( Sprite::Medium,pos,gfx ) )
+	{
+		return;
+	}
 	const int x = pos.x - 225 / 2;
 	const int y = pos.y - 20;
 	gfx.PutPixel( 1 + x,0 + y,93,93,93 );
@@ -14221,6 +14336,10 @@ void SpriteCodex::DrawMedium( const Vei2& pos,Graphics& gfx )
 
 void SpriteCodex::DrawLarge( const Vei2 & pos,Graphics & gfx )
 {
+	if( DrawPacked( Sprite::Large,pos,gfx ) )
+	{
+		return;
+	}
 	const int x = pos.x - 174 / 2;
 	const int y = pos.y - 20;
 	gfx.PutPixel( 117 + x,0 + y,42,42,42 );
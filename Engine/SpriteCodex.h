@@ -2,6 +2,7 @@
 
 #include "Graphics.h"
 #include "Vei2.h"
+#include "AssetPack.h"
 
 class SpriteCodex
 {
@@ -37,4 +38,36 @@ public:
 	static void DrawSmall( const Vei2& pos,Graphics& gfx );
 	static void DrawMedium( const Vei2& pos,Graphics& gfx );
 	static void DrawLarge( const Vei2& pos,Graphics& gfx );
+
+	// draw the sprites the pack has out of it instead of with the built-in code
+	// (the pack has to stay open until UsePack( nullptr ) or the end of the program)
+	static void UsePack( const AssetPack* pPack );
+private:
+	enum class Sprite
+	{
+		Tile0,
+		Tile1,
+		Tile2,
+		Tile3,
+		Tile4,
+		Tile5,
+		Tile6,
+		Tile7,
+		Tile8,
+		TileButton,
+		TileCross,
+		TileFlag,
+		TileBomb,
+		TileBombRed,
+		Win,
+		Small,
+		Medium,
+		Large,
+		Count
+	};
+	// false if the sprite isn't in the pack (and the caller should draw it the old way)
+	static bool DrawPacked( Sprite s,const Vei2& pos,Graphics& gfx );
+private:
+	static const char* const spriteNames[int( Sprite::Count )];
+	static SpriteView packedSprites[int( Sprite::Count )];
 };
\ No newline at end of file
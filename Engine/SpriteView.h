@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Colors.h"
+
+// read-only view of a block of 32-bit pixels (rows top to bottom, no padding),
+// e.g. a sprite sitting in a mapped asset pack
+struct SpriteView
+{
+	int width;
+	int height;
+	// the point the sprite is positioned by (relative to its top left)
+	int originX;
+	int originY;
+	const Color* pPixels;
+};
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "StartupProfiler.h"
+#include "ChiliWin.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+namespace
+{
+	// first thing to run in this translation unit's static init, everything is timed from here
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	std::mutex recordMutex;
+	std::vector<StartupProfiler::Record> records;
+	std::atomic<int> nThreads = { 0 };
+	thread_local int threadNumber = -1;
+	thread_local int threadDepth = 0;
+}
+
+StartupProfiler::Phase::Phase( std::string name )
+	:
+	name( std::move( name ) ),
+	start( Now() ),
+	depth( threadDepth++ )
+{}
+
+StartupProfiler::Phase::Phase( const std::wstring& name )
+	:
+	Phase( Narrow( name ) )
+{}
+
+StartupProfiler::Phase::~Phase()
+{
+	End();
+}
+
+void StartupProfiler::Phase::End()
+{
+	if( !ended )
+	{
+		ended = true;
+		threadDepth--;
+		Add( { std::move( name ),start,Now() - start,GetThreadNumber(),depth,false } );
+	}
+}
+
+int64_t StartupProfiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - epoch ).count();
+}
+
+void StartupProfiler::Mark( std::string name )
+{
+	Add( { std::move( name ),Now(),0,GetThreadNumber(),threadDepth,true } );
+}
+
+std::vector<StartupProfiler::Record> StartupProfiler::GetRecords()
+{
+	std::vector<Record> sorted;
+	{
+		std::lock_guard<std::mutex> lock( recordMutex );
+		sorted = records;
+	}
+	// phases are added when they end, so parents come after their children until sorted
+	std::stable_sort( sorted.begin(),sorted.end(),[]( const Record& a,const Record& b )
+	{
+		return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+	} );
+	return sorted;
+}
+
+std::string StartupProfiler::GetReport()
+{
+	std::string report = "Startup profile (ms since launch)\n     start   duration  thread  phase\n";
+	char line[64];
+	for( const Record& r : GetRecords() )
+	{
+		if( r.mark )
+		{
+			snprintf( line,sizeof( line ),"%10.3f %10s  %6d  ",r.start / 1e6,"-",r.thread );
+		}
+		else
+		{
+			snprintf( line,sizeof( line ),"%10.3f %10.3f  %6d  ",r.start / 1e6,r.duration / 1e6,r.thread );
+		}
+		report += line + std::string( size_t( r.depth ) * 2u,' ' ) + (r.mark ? "* " : "") + r.name + "\n";
+	}
+	return report;
+}
+
+std::string StartupProfiler::GetJson()
+{
+	std::string json = "{\n\t\"unit\": \"ns\",\n\t\"records\": [";
+	const std::vector<Record> sorted = GetRecords();
+	for( size_t i = 0u; i < sorted.size(); i++ )
+	{
+		const Record& r = sorted[i];
+		json += std::string( i == 0u ? "\n" : ",\n" ) +
+			"\t\t{ \"name\": \"" + Escape( r.name ) + "\"" +
+			", \"type\": \"" + (r.mark ? "mark" : "phase") + "\"" +
+			", \"start\": " + std::to_string( r.start ) +
+			", \"duration\": " + std::to_string( r.duration ) +
+			", \"thread\": " + std::to_string( r.thread ) +
+			", \"depth\": " + std::to_string( r.depth ) + " }";
+	}
+	return json + "\n\t]\n}\n";
+}
+
+void StartupProfiler::Print()
+{
+	OutputDebugStringA( GetReport().c_str() );
+}
+
+bool StartupProfiler::WriteJson( const std::wstring& fileName )
+{
+	std::ofstream file( fileName,std::ios::binary );
+	file << GetJson();
+	return bool( file );
+}
+
+void StartupProfiler::Add( Record r )
+{
+	std::lock_guard<std::mutex> lock( recordMutex );
+	if( records.size() < maxRecords )
+	{
+		records.push_back( std::move( r ) );
+	}
+}
+
+int StartupProfiler::GetThreadNumber()
+{
+	if( threadNumber < 0 )
+	{
+		threadNumber = nThreads.fetch_add( 1,std::memory_order_relaxed );
+	}
+	return threadNumber;
+}
+
+std::string StartupProfiler::Narrow( const std::wstring& s )
+{
+	std::string narrow;
+	for( const wchar_t c : s )
+	{
+		narrow += c < 0x80 ? char( c ) : '?';
+	}
+	return narrow;
+}
+
+std::string StartupProfiler::Escape( const std::string& s )
+{
+	std::string escaped;
+	for( const char c : s )
+	{
+		if( c == '"' || c == '\\' )
+		{
+			escaped += '\\';
+			escaped += c;
+		}
+		else if( uint8_t( c ) < 0x20u )
+		{
+			char code[8];
+			snprintf( code,sizeof( code ),"\\u%04x",unsigned( uint8_t( c ) ) );
+			escaped += code;
+		}
+		else
+		{
+			escaped += c;
+		}
+	}
+	return escaped;
+}
\ No newline at end of file
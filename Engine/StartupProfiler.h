@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// where the time goes between launch and the first frame
+// wrap each startup phase in a Phase (they nest, and can come from any thread), drop in a Mark
+// for single moments like the first frame, then print the breakdown or dump it as json
+// times are nanoseconds since the profiler came up during static initialization,
+// which is about as close to process start as we get without asking the os
+class StartupProfiler
+{
+public:
+	class Phase
+	{
+	public:
+		Phase( std::string name );
+		// for file names, anything outside ascii comes out as '?'
+		Phase( const std::wstring& name );
+		Phase( const Phase& ) = delete;
+		Phase& operator=( const Phase& ) = delete;
+		~Phase();
+		// for phases that end before the scope does, no-op after the first call
+		void End();
+	private:
+		std::string name;
+		int64_t start;
+		int depth;
+		bool ended = false;
+	};
+	struct Record
+	{
+		std::string name;
+		int64_t start;
+		// 0 for marks
+		int64_t duration;
+		// small per thread number in order of first use
+		int thread;
+		int depth;
+		bool mark;
+	};
+public:
+	static int64_t Now();
+	static void Mark( std::string name );
+	// sorted by start time
+	static std::vector<Record> GetRecords();
+	// human readable table in milliseconds
+	static std::string GetReport();
+	static std::string GetJson();
+	// report to the debugger output window
+	static void Print();
+	static bool WriteJson( const std::wstring& fileName );
+private:
+	static void Add( Record r );
+	static int GetThreadNumber();
+	static std::string Narrow( const std::wstring& s );
+	static std::string Escape( const std::string& s );
+private:
+	// startup makes a few dozen of these, this is only a guard against something
+	// recording phases every frame and growing forever
+	static constexpr size_t maxRecords = 1024u;
+};
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+ThreadPool::ThreadPool( size_t nThreads )
+{
+	assert( nThreads > 0u );
+	for( size_t i = 0u; i < nThreads; i++ )
+	{
+		workers.emplace_back( &ThreadPool::WorkerProc,this );
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		quitting = true;
+	}
+	cvTask.notify_all();
+	for( auto& w : workers )
+	{
+		w.join();
+	}
+}
+
+void ThreadPool::ParallelFor( size_t n,const std::function<void( size_t )>& f )
+{
+	// helpers that only get going after everything's done still find this, so it's shared
+	struct Shared
+	{
+		std::atomic<size_t> next = { 0u };
+		std::mutex mutex;
+		std::condition_variable cvDone;
+		size_t nDone = 0u;
+		std::exception_ptr pException;
+	};
+	const auto pShared = std::make_shared<Shared>();
+	// f is only touched for indices claimed before the last one is done, so the caller is still waiting
+	const auto Work = [pShared,n,&f]()
+	{
+		for( size_t i = pShared->next++; i < n; i = pShared->next++ )
+		{
+			std::exception_ptr pException;
+			try
+			{
+				f( i );
+			}
+			catch( ... )
+			{
+				pException = std::current_exception();
+			}
+			std::lock_guard<std::mutex> lock( pShared->mutex );
+			if( pException && !pShared->pException )
+			{
+				pShared->pException = pException;
+			}
+			if( ++pShared->nDone == n )
+			{
+				pShared->cvDone.notify_all();
+			}
+		}
+	};
+	const size_t nHelpers = n > 0u ? std::min( workers.size(),n - 1u ) : 0u;
+	for( size_t i = 0u; i < nHelpers; i++ )
+	{
+		Enqueue( Work );
+	}
+	Work();
+	std::unique_lock<std::mutex> lock( pShared->mutex );
+	pShared->cvDone.wait( lock,[pShared,n] { return pShared->nDone == n; } );
+	if( pShared->pException )
+	{
+		std::rethrow_exception( pShared->pException );
+	}
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+	return workers.size();
+}
+
+size_t ThreadPool::DefaultThreadCount()
+{
+	// hardware_concurrency is allowed to come back 0 when it can't tell
+	return std::max( size_t( std::thread::hardware_concurrency() ),size_t( 2u ) ) - 1u;
+}
+
+void ThreadPool::Enqueue( std::function<void()> task )
+{
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		assert( !quitting );
+		tasks.push_back( std::move( task ) );
+	}
+	cvTask.notify_one();
+}
+
+void ThreadPool::WorkerProc()
+{
+	Trace::SetThreadName( "worker" );
+	while( true )
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock( mutex );
+			cvTask.wait( lock,[this] { return quitting || !tasks.empty(); } );
+			if( tasks.empty() )
+			{
+				return;
+			}
+			task = std::move( tasks.front() );
+			tasks.pop_front();
+		}
+		task();
+	}
+}
\ No newline at end of file
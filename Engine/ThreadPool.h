@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+// fixed set of worker threads pulling tasks off a shared queue
+class ThreadPool
+{
+public:
+	ThreadPool( size_t nThreads = DefaultThreadCount() );
+	ThreadPool( const ThreadPool& ) = delete;
+	ThreadPool& operator=( const ThreadPool& ) = delete;
+	// tasks already queued still get run before the workers are joined
+	~ThreadPool();
+	// exceptions thrown by the task come out of the future's get()
+	template<typename F>
+	auto Submit( F&& f ) -> std::future<decltype( f() )>
+	{
+		auto pTask = std::make_shared<std::packaged_task<decltype( f() )()>>( std::forward<F>( f ) );
+		auto future = pTask->get_future();
+		Enqueue( [pTask]() { (*pTask)(); } );
+		return future;
+	}
+	// runs f( 0 ) to f( n - 1 ) on the workers and the calling thread, each taking the next index
+	// as soon as it's done with one (so a slow index doesn't hold the rest up), and returns once all
+	// are done, the first exception thrown by f comes out of here
+	// fine to call from a task on this pool, the caller works through the indices itself when the
+	// workers are all busy
+	void ParallelFor( size_t n,const std::function<void( size_t )>& f );
+	size_t GetThreadCount() const;
+	// one per hardware thread, leaving one for the thread doing the submitting
+	static size_t DefaultThreadCount();
+private:
+	void Enqueue( std::function<void()> task );
+	void WorkerProc();
+private:
+	std::mutex mutex;
+	std::condition_variable cvTask;
+	std::deque<std::function<void()>> tasks;
+	bool quitting = false;
+	std::vector<std::thread> workers;
+};
\ No newline at end of file
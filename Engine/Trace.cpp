@@ -0,0 +1,164 @@
+#include "Trace.h"
+#include "WideFile.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	struct Event
+	{
+		const char* name;
+		int64_t start;
+		int64_t duration;
+	};
+	// zones per thread per capture, the rest are dropped
+	constexpr size_t capacity = 65536u;
+
+	struct ThreadBuffer
+	{
+		// written by the owning thread only, count is published with release after the event is written
+		std::unique_ptr<Event[]> pEvents;
+		std::atomic<size_t> count = { 0u };
+		// capture the events belong to, the owner clears its buffer when it sees a new one
+		// (stored last, so a reader that sees the new capture sees the cleared buffer)
+		std::atomic<uint32_t> capture = { 0u };
+		// registry fields, set once under the registry mutex
+		const char* name = nullptr;
+		int tid = 0;
+	};
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	std::atomic<bool> capturing = { false };
+	std::atomic<uint32_t> currentCapture = { 0u };
+	// buffers outlive their threads so a capture can still be exported after a worker exits
+	std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		thread_local ThreadBuffer* pBuffer = nullptr;
+		if( !pBuffer )
+		{
+			std::lock_guard<std::mutex> lock( registryMutex );
+			buffers.push_back( std::make_unique<ThreadBuffer>() );
+			pBuffer = buffers.back().get();
+			pBuffer->tid = int( buffers.size() );
+		}
+		return *pBuffer;
+	}
+}
+
+Trace::Zone::Zone( const char* name )
+	:
+	name( name ),
+	start( capturing.load( std::memory_order_relaxed ) ? Now() : -1 )
+{}
+
+Trace::Zone::~Zone()
+{
+	if( start >= 0 )
+	{
+		Record( name,start,Now() );
+	}
+}
+
+void Trace::Start()
+{
+	currentCapture.fetch_add( 1u,std::memory_order_release );
+	capturing.store( true,std::memory_order_release );
+}
+
+bool Trace::IsCapturing()
+{
+	return capturing.load( std::memory_order_relaxed );
+}
+
+std::string Trace::Stop()
+{
+	capturing.store( false,std::memory_order_release );
+	const uint32_t capture = currentCapture.load( std::memory_order_acquire );
+	std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	char line[256];
+	const auto Append = [&]( const char* text )
+	{
+		json += first ? "\n" : ",\n";
+		json += text;
+		first = false;
+	};
+	std::lock_guard<std::mutex> lock( registryMutex );
+	for( const auto& pBuffer : buffers )
+	{
+		const ThreadBuffer& b = *pBuffer;
+		if( b.name )
+		{
+			snprintf( line,sizeof( line ),"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				b.tid,b.name );
+			Append( line );
+		}
+		// a thread that hasn't recorded since Start still holds the previous capture
+		if( b.capture.load( std::memory_order_acquire ) != capture )
+		{
+			continue;
+		}
+		const size_t n = b.count.load( std::memory_order_acquire );
+		for( size_t i = 0u; i < n; i++ )
+		{
+			const Event& e = b.pEvents[i];
+			snprintf( line,sizeof( line ),"{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				e.name,b.tid,e.start / 1000.0,e.duration / 1000.0 );
+			Append( line );
+		}
+	}
+	return json + "\n]}\n";
+}
+
+bool Trace::StopAndWrite( const std::wstring& fileName )
+{
+	const std::string json = Stop();
+	std::ofstream file;
+	OpenWideFile( file,fileName,std::ios::binary );
+	file << json;
+	return bool( file );
+}
+
+void Trace::SetThreadName( const char* name )
+{
+	ThreadBuffer& b = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock( registryMutex );
+	b.name = name;
+}
+
+int64_t Trace::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - epoch ).count();
+}
+
+void Trace::Record( const char* name,int64_t start,int64_t end )
+{
+	ThreadBuffer& b = GetThreadBuffer();
+	const uint32_t capture = currentCapture.load( std::memory_order_acquire );
+	if( b.capture.load( std::memory_order_relaxed ) != capture )
+	{
+		// only allocates for threads that record during a capture, and only the first time
+		if( !b.pEvents )
+		{
+			b.pEvents = std::make_unique<Event[]>( capacity );
+		}
+		b.count.store( 0u,std::memory_order_relaxed );
+		b.capture.store( capture,std::memory_order_release );
+	}
+	const size_t n = b.count.load( std::memory_order_relaxed );
+	if( n == capacity )
+	{
+		return;
+	}
+	b.pEvents[n] = { name,start,end - start };
+	b.count.store( n + 1u,std::memory_order_release );
+}
\ No newline at end of file
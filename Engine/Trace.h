@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// build with CHILI_TRACE=0 to compile the zones out
+#ifndef CHILI_TRACE
+#define CHILI_TRACE 1
+#endif
+
+#define CHILI_TRACE_CONCAT_( a,b ) a##b
+#define CHILI_TRACE_CONCAT( a,b ) CHILI_TRACE_CONCAT_( a,b )
+#if CHILI_TRACE
+#define CHILI_TRACE_ZONE( name ) const Trace::Zone CHILI_TRACE_CONCAT( chiliTraceZone,__LINE__ )( name )
+#else
+#define CHILI_TRACE_ZONE( name ) ((void)0)
+#endif
+
+// scoped zones captured for a trace viewer (chrome://tracing or ui.perfetto.dev)
+// while a capture runs every thread appends its finished zones to a buffer only it writes,
+// publishing them with a release store, so recording never takes a lock
+// Stop collects all threads' buffers and hands them over as trace_event json
+class Trace
+{
+public:
+	class Zone
+	{
+	public:
+		// the name is kept as a pointer, so use literals
+		Zone( const char* name );
+		Zone( const Zone& ) = delete;
+		Zone& operator=( const Zone& ) = delete;
+		~Zone();
+	private:
+		const char* name;
+		// -1 when no capture was running at the start of the zone
+		int64_t start;
+	};
+public:
+	static void Start();
+	static bool IsCapturing();
+	// stops recording, returns the capture as trace_event json
+	static std::string Stop();
+	static bool StopAndWrite( const std::wstring& fileName );
+	// how the calling thread is labelled in the viewer (a literal again)
+	static void SetThreadName( const char* name );
+private:
+	static int64_t Now();
+	static void Record( const char* name,int64_t start,int64_t end );
+};
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "WaveStream.h"
+#include "WideFile.h"
+#include <assert.h>
+#include <algorithm>
+
+WaveStream::WaveStream( const Source& source )
+	:
+	dataOffset( source.dataOffset ),
+	dataEnd( source.looping ? source.loopEnd : source.dataSize ),
+	loopStart( source.loopStart ),
+	// chunks always hold whole frames
+	chunkBytesMax( chunkSize - chunkSize % source.blockAlign ),
+	looping( source.looping ),
+	pStorage( std::make_unique<char[]>( nChunks * chunkSize ) )
+{
+	assert( chunkBytesMax > 0u );
+	assert( !looping || (source.loopStart < source.loopEnd && source.loopEnd <= source.dataSize) );
+	file.exceptions( std::ifstream::failbit | std::ifstream::badbit );
+	OpenWideFile( file,source.fileName,std::ios::binary );
+	file.seekg( dataOffset );
+}
+
+size_t WaveStream::Fill()
+{
+	size_t nNewChunks = 0u;
+	while( !atEnd && nFilled - nConsumed < nChunks )
+	{
+		const size_t slot = nFilled % nChunks;
+		char* const pChunk = &pStorage[slot * chunkSize];
+		size_t nRead = 0u;
+		try
+		{
+			while( nRead < chunkBytesMax )
+			{
+				if( readPos == dataEnd )
+				{
+					if( looping )
+					{
+						readPos = loopStart;
+						file.seekg( dataOffset + std::streamoff( loopStart ) );
+					}
+					else
+					{
+						atEnd = true;
+						break;
+					}
+				}
+				const size_t n = std::min( chunkBytesMax - nRead,dataEnd - readPos );
+				file.read( pChunk + nRead,n );
+				nRead += n;
+				readPos += n;
+			}
+		}
+		catch( const std::exception& )
+		{
+			// file went bad under our feet, play what we have and end the stream there
+			atEnd = true;
+		}
+		if( nRead == 0u )
+		{
+			break;
+		}
+		chunkBytes[slot] = nRead;
+		nFilled++;
+		nNewChunks++;
+	}
+	return nNewChunks;
+}
+
+size_t WaveStream::GetReadyCount() const
+{
+	return nFilled - nConsumed;
+}
+
+const char* WaveStream::GetChunk( size_t i,size_t& nBytes ) const
+{
+	assert( i < GetReadyCount() );
+	const size_t slot = (nConsumed + i) % nChunks;
+	nBytes = chunkBytes[slot];
+	return &pStorage[slot * chunkSize];
+}
+
+void WaveStream::PopChunk()
+{
+	assert( GetReadyCount() > 0u );
+	nConsumed++;
+}
+
+bool WaveStream::IsExhausted() const
+{
+	return atEnd && GetReadyCount() == 0u;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <memory>
+#include <atomic>
+
+// reads the data chunk of a wave file in fixed-size pieces into a small ring of buffers
+// memory use is bounded by nChunks * chunkSize no matter how long the file is
+// one thread fills the ring (producer) while another plays it back (consumer)
+class WaveStream
+{
+public:
+	static constexpr size_t nChunks = 4u;
+	static constexpr size_t chunkSize = 16384u;
+	// where the payload is, enough to open any number of streams of it
+	struct Source
+	{
+		std::wstring fileName;
+		std::streamoff dataOffset;
+		size_t dataSize;
+		size_t blockAlign;
+		bool looping;
+		// in bytes relative to the start of the data chunk
+		size_t loopStart;
+		size_t loopEnd;
+	};
+public:
+	explicit WaveStream( const Source& source );
+	WaveStream( const WaveStream& ) = delete;
+	WaveStream& operator=( const WaveStream& ) = delete;
+	// producer: fills every free chunk in the ring, returns the number of chunks filled
+	size_t Fill();
+	// consumer: chunks are indexed from the front of the ring (0 is the oldest)
+	size_t GetReadyCount() const;
+	const char* GetChunk( size_t i,size_t& nBytes ) const;
+	void PopChunk();
+	// true when the end of the data was reached and every chunk was consumed
+	bool IsExhausted() const;
+private:
+	std::ifstream file;
+	std::streamoff dataOffset;
+	size_t dataEnd;
+	size_t loopStart;
+	size_t chunkBytesMax;
+	bool looping;
+	size_t readPos = 0u;
+	std::atomic<bool> atEnd = { false };
+	std::unique_ptr<char[]> pStorage;
+	size_t chunkBytes[nChunks] = {};
+	std::atomic<size_t> nFilled = { 0u };
+	std::atomic<size_t> nConsumed = { 0u };
+};
\ No newline at end of file
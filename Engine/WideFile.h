@@ -0,0 +1,20 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#ifndef _MSC_VER
+#include <codecvt>
+#include <locale>
+#endif
+
+// opens a file stream by a wide file name, which only the msvc library takes as is
+// (anywhere else the name goes to the os as utf-8)
+template<typename Stream>
+void OpenWideFile( Stream& stream,const std::wstring& fileName,std::ios::openmode mode )
+{
+#ifdef _MSC_VER
+	stream.open( fileName,mode );
+#else
+	stream.open( std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes( fileName ),mode );
+#endif
+}
\ No newline at end of file
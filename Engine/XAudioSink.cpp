@@ -0,0 +1,316 @@
+#include "XAudioSink.h"
+#include "ChiliWin.h"
+#include "StartupProfiler.h"
+#include "XAudio\XAudio2.h"
+#include "DXErr.h"
+#include <wrl\client.h>
+#include <assert.h>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#define CHILI_XAUDIO_EXCEPTION( hr,note ) XAudioSink::APIException( hr,_CRT_WIDE(__FILE__),__LINE__,note )
+
+static_assert(std::is_same<HRESULT,long>::value,"APIException keeps the HRESULT as a long");
+
+class XAudioSink::Device
+{
+private:
+	class XAudioDll
+	{
+	private:
+		enum class LoadType
+		{
+			Folder,
+			Local,
+			System,
+			Invalid
+		};
+	public:
+		XAudioDll();
+		XAudioDll( const XAudioDll& ) = delete;
+		XAudioDll& operator=( const XAudioDll& ) = delete;
+		~XAudioDll();
+		operator HMODULE() const;
+	private:
+		static const wchar_t* GetDllPath( LoadType type );
+	private:
+		HMODULE hModule = 0;
+		static constexpr const wchar_t* systemPath = L"XAudio2_7.dll";
+#ifdef _M_X64
+		static constexpr const wchar_t* folderPath = L"XAudio\\XAudio2_7_64.dll";
+		static constexpr const wchar_t* localPath = L"XAudio2_7_64.dll";
+#else
+		static constexpr const wchar_t* folderPath = L"XAudio\\XAudio2_7_32.dll";
+		static constexpr const wchar_t* localPath = L"XAudio2_7_32.dll";
+#endif
+	};
+public:
+	Device( unsigned int sampleRate,IXAudio2VoiceCallback& callback );
+	Device( const Device& ) = delete;
+	Device& operator=( const Device& ) = delete;
+	~Device();
+	void Submit( const float* pBuffer,size_t nFrames );
+private:
+	XAudioDll xaudio_dll;
+	Microsoft::WRL::ComPtr<IXAudio2> pEngine;
+	IXAudio2MasteringVoice* pMaster = nullptr;
+	IXAudio2SourceVoice* pSource = nullptr;
+};
+
+class XAudioSink::BufferCallback : public IXAudio2VoiceCallback
+{
+public:
+	BufferCallback( XAudioSink& sink )
+		:
+		sink( sink )
+	{}
+	void STDMETHODCALLTYPE OnStreamEnd() override
+	{}
+	void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override
+	{}
+	void STDMETHODCALLTYPE OnVoiceProcessingPassStart( UINT32 SamplesRequired ) override
+	{}
+	void STDMETHODCALLTYPE OnBufferEnd( void* pBufferContext ) override
+	{
+		std::lock_guard<std::mutex> lock( sink.mutex );
+		sink.nBuffersQueued--;
+		sink.cvBufferDone.notify_one();
+	}
+	void STDMETHODCALLTYPE OnBufferStart( void* pBufferContext ) override
+	{}
+	void STDMETHODCALLTYPE OnLoopEnd( void* pBufferContext ) override
+	{}
+	void STDMETHODCALLTYPE OnVoiceError( void* pBufferContext,HRESULT Error ) override
+	{}
+private:
+	XAudioSink& sink;
+};
+
+XAudioSink::Device::XAudioDll::XAudioDll()
+{
+	StartupProfiler::Phase phase( "xaudio dll" );
+	LoadType type = LoadType::System;
+	while( true )
+	{
+		{
+			StartupProfiler::Phase attempt( L"LoadLibrary " + std::wstring( GetDllPath( type ) ) );
+			hModule = LoadLibrary( GetDllPath( type ) );
+		}
+		if( hModule != 0 )
+		{
+			return;
+		}
+		else
+		{
+			switch( type )
+			{
+			case LoadType::System:
+				type = LoadType::Folder;
+				break;
+			case LoadType::Folder:
+				type = LoadType::Local;
+				break;
+			case LoadType::Local:
+				throw CHILI_XAUDIO_EXCEPTION(
+					HRESULT_FROM_WIN32( GetLastError() ),
+					std::wstring(
+						L"The XAudio2 DLL Could not be loaded. It is required that:\n"
+						L"A) [ " ) + std::wstring( GetDllPath( LoadType::Folder ) ) +
+					std::wstring( L" ] exist in the same folder as this executable;\n"
+						L"B) [ " ) + std::wstring( GetDllPath( LoadType::Local ) ) +
+					std::wstring( L" ] exist in the same folder as this executable; or\n"
+						L"C) [ XAudio2_7.dll ] be installed on this system via the DirectX"
+						L" Redistributable Installer Version June 2010\n" ) );
+			default:
+				assert( false && "Bad LoadType encountered in XAudio Dll loading sequence loop" );
+			}
+		}
+	}
+}
+
+XAudioSink::Device::XAudioDll::~XAudioDll()
+{
+	if( hModule != 0 )
+	{
+		FreeLibrary( hModule );
+		hModule = 0;
+	}
+}
+
+XAudioSink::Device::XAudioDll::operator HMODULE() const
+{
+	return hModule;
+}
+
+const wchar_t* XAudioSink::Device::XAudioDll::GetDllPath( LoadType type )
+{
+	switch( type )
+	{
+	case LoadType::System:
+		return systemPath;
+	case LoadType::Folder:
+		return folderPath;
+	case LoadType::Local:
+		return localPath;
+	default:
+		assert( false && "Bad LoadType in GetDllPath function" );
+		return nullptr;
+	}
+}
+
+XAudioSink::Device::Device( unsigned int sampleRate,IXAudio2VoiceCallback& callback )
+{
+	if( sampleRate < XAUDIO2_MIN_SAMPLE_RATE || sampleRate > XAUDIO2_MAX_SAMPLE_RATE )
+	{
+		throw CHILI_XAUDIO_EXCEPTION( E_INVALIDARG,L"Mixer sample rate is outside the range XAudio2 allows" );
+	}
+
+	// find address of DllGetClassObject() function in the dll
+	const std::function<HRESULT(REFCLSID,REFIID,LPVOID)> DllGetClassObject =
+        reinterpret_cast<HRESULT(WINAPI*)(REFCLSID,REFIID,LPVOID)>(
+		GetProcAddress( xaudio_dll,"DllGetClassObject" ) );
+	if( !DllGetClassObject )
+	{
+		throw CHILI_XAUDIO_EXCEPTION(
+			HRESULT_FROM_WIN32( GetLastError() ),
+			L"Getting process address of 'DllGetClassObject' function" );
+	}
+
+	// create the factory class for the XAudio2 component object
+	Microsoft::WRL::ComPtr<IClassFactory> pClassFactory;
+	HRESULT hr;
+	if( FAILED( hr = DllGetClassObject(
+		 __uuidof( XAudio2 ),
+		IID_IClassFactory,
+		pClassFactory.ReleaseAndGetAddressOf() ) ) )
+	{
+		throw CHILI_XAUDIO_EXCEPTION( hr,L"Creating factory for XAudio2 object" );
+	}
+
+	// create the XAudio2 component object itself
+	if( FAILED( hr = pClassFactory->CreateInstance( nullptr,
+		__uuidof( IXAudio2 ),&pEngine ) ) )
+	{
+		throw CHILI_XAUDIO_EXCEPTION( hr,L"Creating XAudio2 object" );
+	}
+
+	// initialize the XAudio2 component object
+	if( FAILED( hr = pEngine->Initialize( 0,XAUDIO2_DEFAULT_PROCESSOR ) ) )
+	{
+		throw CHILI_XAUDIO_EXCEPTION( hr,L"Initializing XAudio2 object" );
+	}
+
+	// create the mastering voice
+	if( FAILED( hr = pEngine->CreateMasteringVoice( &pMaster ) ) )
+	{
+		throw CHILI_XAUDIO_EXCEPTION( hr,L"Creating mastering voice" );
+	}
+
+	// create the single source voice that plays the output of the software mixer
+	WAVEFORMATEX mixFormat = {};
+	mixFormat.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+	mixFormat.nChannels = WORD( SoundMixer::nChannels );
+	mixFormat.nSamplesPerSec = sampleRate;
+	mixFormat.wBitsPerSample = WORD( sizeof( float ) * 8u );
+	mixFormat.nBlockAlign = WORD( SoundMixer::nChannels * sizeof( float ) );
+	mixFormat.nAvgBytesPerSec = mixFormat.nBlockAlign * sampleRate;
+	mixFormat.cbSize = 0;
+	if( FAILED( hr = pEngine->CreateSourceVoice( &pSource,&mixFormat,0u,1.0f,&callback ) ) )
+	{
+		throw CHILI_XAUDIO_EXCEPTION( hr,L"Creating source voice for mixer output" );
+	}
+	if( FAILED( hr = pSource->Start() ) )
+	{
+		pSource->DestroyVoice();
+		throw CHILI_XAUDIO_EXCEPTION( hr,L"Starting mixer output voice" );
+	}
+}
+
+XAudioSink::Device::~Device()
+{
+	if( pSource )
+	{
+		pSource->DestroyVoice();
+		pSource = nullptr;
+	}
+}
+
+void XAudioSink::Device::Submit( const float* pBuffer,size_t nFrames )
+{
+	XAUDIO2_BUFFER xaBuffer = {};
+	xaBuffer.pAudioData = reinterpret_cast<const BYTE*>( pBuffer );
+	xaBuffer.AudioBytes = UINT32( nFrames * SoundMixer::nChannels * sizeof( float ) );
+	HRESULT hr;
+	if( FAILED( hr = pSource->SubmitSourceBuffer( &xaBuffer,nullptr ) ) )
+	{
+		throw CHILI_XAUDIO_EXCEPTION( hr,L"Submitting mixer output buffer" );
+	}
+}
+
+XAudioSink::XAudioSink( unsigned int sampleRate,size_t nBlockFrames )
+	:
+	pCallback( std::make_unique<BufferCallback>( *this ) ),
+	nBlockFrames( nBlockFrames ),
+	pBuffers( std::make_unique<float[]>( nBuffers * nBlockFrames * SoundMixer::nChannels ) ),
+	pDevice( std::make_unique<Device>( sampleRate,*pCallback ) )
+{}
+
+XAudioSink::~XAudioSink()
+{}
+
+void XAudioSink::Submit( const float* pFrames,size_t nFrames )
+{
+	assert( nFrames <= nBlockFrames );
+	{
+		// wait for the device to free up one of our buffers
+		std::unique_lock<std::mutex> lock( mutex );
+		cvBufferDone.wait( lock,[this] { return nBuffersQueued < nBuffers; } );
+		nBuffersQueued++;
+	}
+	float* const pBuffer = &pBuffers[iNextBuffer * nBlockFrames * SoundMixer::nChannels];
+	iNextBuffer = (iNextBuffer + 1u) % nBuffers;
+	memcpy( pBuffer,pFrames,nFrames * SoundMixer::nChannels * sizeof( float ) );
+	try
+	{
+		pDevice->Submit( pBuffer,nFrames );
+	}
+	catch( ... )
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		nBuffersQueued--;
+		throw;
+	}
+}
+
+XAudioSink::APIException::APIException( long hr,const wchar_t * file,unsigned int line,const std::wstring & note )
+	:
+	hr( hr ),
+	ChiliException( file,line,note )
+{}
+
+std::wstring XAudioSink::APIException::GetFullMessage() const
+{
+	return L"Error Name: " + GetErrorName() + L"\n\n" +
+		L"Error Description: " + GetErrorDescription() + L"\n\n" +
+		L"Note: " + GetNote() + L"\n\n" +
+		L"Location: " + GetLocation();
+}
+
+std::wstring XAudioSink::APIException::GetExceptionType() const
+{
+	return L"Sound System API Exception";
+}
+
+std::wstring XAudioSink::APIException::GetErrorName() const
+{
+	return DXGetErrorString( hr );
+}
+
+std::wstring XAudioSink::APIException::GetErrorDescription() const
+{
+	std::array<wchar_t,512> wideDescription;
+	DXGetErrorDescription( hr,wideDescription.data(),wideDescription.size() );
+	return wideDescription.data();
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "SoundMixer.h"
+#include "ChiliException.h"
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+// final output of the software mixer on Windows, one float stereo XAudio2 source voice fed
+// block by block (the Windows and XAudio2 headers stay in XAudioSink.cpp)
+class XAudioSink : public AudioSink
+{
+public:
+	class APIException : public ChiliException
+	{
+	public:
+		// hr is an HRESULT
+		APIException( long hr,const wchar_t* file,unsigned int line,const std::wstring& note );
+		std::wstring GetErrorName() const;
+		std::wstring GetErrorDescription() const;
+		virtual std::wstring GetFullMessage() const override;
+		virtual std::wstring GetExceptionType() const override;
+	private:
+		long hr;
+	};
+private:
+	class Device;
+	class BufferCallback;
+public:
+	XAudioSink( unsigned int sampleRate,size_t nBlockFrames );
+	XAudioSink( const XAudioSink& ) = delete;
+	XAudioSink& operator=( const XAudioSink& ) = delete;
+	~XAudioSink();
+	void Submit( const float* pFrames,size_t nFrames ) override;
+private:
+	static constexpr size_t nBuffers = 3u;
+	std::unique_ptr<BufferCallback> pCallback;
+	size_t nBlockFrames;
+	std::unique_ptr<float[]> pBuffers;
+	size_t iNextBuffer = 0u;
+	std::mutex mutex;
+	std::condition_variable cvBufferDone;
+	size_t nBuffersQueued = 0u;
+	// the dll, engine and voices, last so the voice is gone before the callback and buffers
+	std::unique_ptr<Device> pDevice;
+};
\ No newline at end of file
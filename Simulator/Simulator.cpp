@@ -0,0 +1,272 @@
+// plays MemeField games headless (no window, no Graphics or Sound object) with BoardSolver
+// clicking for a player, on every core, and prints how it went over all of them
+// usage: Simulator [--board <small|medium|large|expert|<w>x<h>x<memes>>] [--games <n>] [--seed <n>] [--threads <n>]
+// game i plays the board of seed + i, so everything but the times comes out the same on any
+// number of threads, build Release for times worth comparing
+#include "BoardSolver.h"
+#include "FieldArena.h"
+#include "MemeField.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Board
+	{
+		std::string name;
+		int width;
+		int height;
+		int nMemes;
+	};
+
+	// games a task does, with one arena and solver
+	constexpr size_t chunkSize = 1024u;
+
+	struct Totals
+	{
+		size_t nGames = 0u;
+		size_t nWon = 0u;
+		uint64_t nGuesses = 0u;
+		uint64_t nGuessesWon = 0u;
+		uint64_t nMoves = 0u;
+	};
+
+	struct GameResult
+	{
+		bool won;
+		// reveals nothing said were safe, the first click included
+		int nGuesses;
+		// reveal and flag clicks
+		int nMoves;
+	};
+
+	bool ParseBoard( const char* s,Board& board )
+	{
+		// the menu presets (Game::UpdateModel) and the classic expert board
+		for( const Board& preset : { Board{ "small",8,4,5 },Board{ "medium",14,7,15 },Board{ "large",24,16,45 },Board{ "expert",30,16,99 } } )
+		{
+			if( preset.name == s )
+			{
+				board = preset;
+				return true;
+			}
+		}
+		int width = 0;
+		int height = 0;
+		int nMemes = 0;
+		if( sscanf( s,"%dx%dx%d",&width,&height,&nMemes ) != 3 || width < 1 || height < 1 || nMemes < 1 || nMemes >= width * height )
+		{
+			return false;
+		}
+		board = { s,width,height,nMemes };
+		return true;
+	}
+
+	// tells the solver about every tile the click at tile opened, following the cascade out from
+	// it over the revealed zeros the way the field opened them
+	void ReportReveals( const MemeField& field,int tile,BoardSolver& solver,std::vector<int>& stack )
+	{
+		const int width = field.GetWidth();
+		const int height = field.GetHeight();
+		stack.clear();
+		stack.push_back( tile );
+		while( !stack.empty() )
+		{
+			const int i = stack.back();
+			stack.pop_back();
+			const Vei2 gridPos = { i % width,i / width };
+			if( solver.IsRevealed( i ) || !field.TileIsRevealed( gridPos ) )
+			{
+				continue;
+			}
+			const int nNeighborMemes = field.TileNeighborMemes( gridPos );
+			solver.OnRevealed( i,nNeighborMemes );
+			if( nNeighborMemes == 0 )
+			{
+				const int xStart = std::max( 0,gridPos.x - 1 );
+				const int yStart = std::max( 0,gridPos.y - 1 );
+				const int xEnd = std::min( width - 1,gridPos.x + 1 );
+				const int yEnd = std::min( height - 1,gridPos.y + 1 );
+				for( int y = yStart; y <= yEnd; y++ )
+				{
+					for( int x = xStart; x <= xEnd; x++ )
+					{
+						stack.push_back( y * width + x );
+					}
+				}
+			}
+		}
+	}
+
+	// the field goes into the arena like Game does it, the arena is reset after
+	GameResult PlayGame( const Board& board,uint64_t seed,FieldArena& arena,BoardSolver& solver,std::vector<int>& stack )
+	{
+		MemeField* const pField = new( arena.Allocate<MemeField>( 1u ) )
+			MemeField( { 0,0 },board.width,board.height,board.nMemes,seed,arena );
+		MemeField& field = *pField;
+		solver.Start( board.width,board.height,board.nMemes );
+		GameResult result = { false,0,0 };
+		while( field.GetState() == MemeField::State::Memeing )
+		{
+			const BoardSolver::Move move = solver.Next();
+			if( move.type == BoardSolver::Move::Type::Done )
+			{
+				// every tile known and the game still on can't happen, but don't spin if it does
+				break;
+			}
+			const Vei2 gridPos = { move.tile % board.width,move.tile / board.width };
+			result.nMoves++;
+			if( move.type == BoardSolver::Move::Type::Flag )
+			{
+				field.OnFlagClick( field.GridToScreen( gridPos ) );
+				continue;
+			}
+			result.nGuesses += move.guess ? 1 : 0;
+			field.OnRevealClick( field.GridToScreen( gridPos ) );
+			if( field.GetState() != MemeField::State::Fucked )
+			{
+				ReportReveals( field,move.tile,solver,stack );
+			}
+		}
+		result.won = field.GetState() == MemeField::State::Winrar;
+		pField->~MemeField();
+		arena.Reset();
+		return result;
+	}
+
+	void PrintUsage()
+	{
+		fprintf( stderr,"usage: Simulator [--board <small|medium|large|expert|<w>x<h>x<memes>>] [--games <n>] [--seed <n>] [--threads <n>]\n" );
+	}
+}
+
+int main( int argc,char** argv )
+{
+	Board board = { "expert",30,16,99 };
+	size_t nGames = 100000u;
+	uint64_t seed = 1u;
+	size_t nThreads = ThreadPool::DefaultThreadCount() + 1u;
+	for( int i = 1; i < argc; i++ )
+	{
+		const bool hasValue = i + 1 < argc;
+		if( !strcmp( argv[i],"--board" ) && hasValue )
+		{
+			if( !ParseBoard( argv[++i],board ) )
+			{
+				fprintf( stderr,"Simulator: bad board %s\n",argv[i] );
+				PrintUsage();
+				return 2;
+			}
+		}
+		else if( !strcmp( argv[i],"--games" ) && hasValue )
+		{
+			nGames = size_t( std::max( atoll( argv[++i] ),1ll ) );
+		}
+		else if( !strcmp( argv[i],"--seed" ) && hasValue )
+		{
+			seed = strtoull( argv[++i],nullptr,10 );
+		}
+		else if( !strcmp( argv[i],"--threads" ) && hasValue )
+		{
+			nThreads = size_t( std::max( atoi( argv[++i] ),1 ) );
+		}
+		else
+		{
+			fprintf( stderr,"Simulator: unknown argument %s\n",argv[i] );
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	// the calling thread works through chunks too
+	std::unique_ptr<ThreadPool> pPool;
+	if( nThreads > 1u )
+	{
+		pPool = std::make_unique<ThreadPool>( nThreads - 1u );
+	}
+	const size_t nChunks = (nGames + chunkSize - 1u) / chunkSize;
+	std::vector<Totals> chunkTotals( nChunks );
+	// per game, for the percentiles
+	std::vector<float> gameMicros( nGames );
+	const auto playChunk = [&]( size_t chunk )
+	{
+		FieldArena arena;
+		BoardSolver solver;
+		std::vector<int> stack;
+		Totals& totals = chunkTotals[chunk];
+		const size_t end = std::min( (chunk + 1u) * chunkSize,nGames );
+		for( size_t i = chunk * chunkSize; i < end; i++ )
+		{
+			const auto start = std::chrono::steady_clock::now();
+			const GameResult result = PlayGame( board,seed + i,arena,solver,stack );
+			gameMicros[i] = std::chrono::duration<float,std::micro>( std::chrono::steady_clock::now() - start ).count();
+			totals.nGames++;
+			totals.nWon += result.won ? 1u : 0u;
+			totals.nGuesses += uint64_t( result.nGuesses );
+			totals.nGuessesWon += result.won ? uint64_t( result.nGuesses ) : 0u;
+			totals.nMoves += uint64_t( result.nMoves );
+		}
+	};
+	const auto start = std::chrono::steady_clock::now();
+	try
+	{
+		if( pPool )
+		{
+			pPool->ParallelFor( nChunks,playChunk );
+		}
+		else
+		{
+			for( size_t chunk = 0u; chunk < nChunks; chunk++ )
+			{
+				playChunk( chunk );
+			}
+		}
+	}
+	catch( const std::exception& e )
+	{
+		fprintf( stderr,"Simulator: %s\n",e.what() );
+		return 1;
+	}
+	const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+	Totals totals;
+	for( const Totals& t : chunkTotals )
+	{
+		totals.nGames += t.nGames;
+		totals.nWon += t.nWon;
+		totals.nGuesses += t.nGuesses;
+		totals.nGuessesWon += t.nGuessesWon;
+		totals.nMoves += t.nMoves;
+	}
+	double sumMicros = 0.0;
+	for( const float micros : gameMicros )
+	{
+		sumMicros += double( micros );
+	}
+	std::sort( gameMicros.begin(),gameMicros.end() );
+	const auto percentile = [&gameMicros]( double p )
+	{
+		return double( gameMicros[std::min( size_t( double( gameMicros.size() ) * p ),gameMicros.size() - 1u )] );
+	};
+	const double n = double( totals.nGames );
+
+	printf( "board     %s (%dx%d, %d memes), %zu games from seed %llu on %zu threads\n",board.name.c_str(),
+		board.width,board.height,board.nMemes,totals.nGames,static_cast<unsigned long long>( seed ),nThreads );
+	printf( "won       %.2f%% (%zu)\n",100.0 * double( totals.nWon ) / n,totals.nWon );
+	printf( "guesses   %.3f per game, %.3f per won game (the first click is one)\n",double( totals.nGuesses ) / n,
+		totals.nWon > 0u ? double( totals.nGuessesWon ) / double( totals.nWon ) : 0.0 );
+	printf( "moves     %.2f per game (reveal and flag clicks)\n",double( totals.nMoves ) / n );
+	printf( "time      %.2fus mean, %.2fus p50, %.2fus p99, %.2fus max per game (built and played)\n",sumMicros / n,
+		percentile( 0.5 ),percentile( 0.99 ),double( gameMicros.back() ) );
+	printf( "total     %.3fs, %.0f games/s\n",seconds,n / seconds );
+	return 0;
+}
\ No newline at end of file